@@ -0,0 +1,606 @@
+// ============================================================================================
+//
+// SOURCE FILE:  benchmark.cpp
+//
+// ============================================================================================
+
+// ============================================================================================
+// DESCRIPTION
+// ============================================================================================
+
+/*
+This file implements "TestSuite::Benchmark", which times each test case in explicit cache
+states so that test data files can double as benchmarks:
+
+  TestSuite::Benchmark benchmark;           // cold and warm, 5 timed runs of each
+
+  benchmark.select("parseDate", TestSuite::Benchmark::warm);
+  benchmark.addFile("calendar.db");         // evicted from the page cache for cold runs
+  test.setBenchmark(&benchmark);
+  test.all();
+  benchmark.summarize(cout);                // totals for each test in each state
+  benchmark.write(timings);                 // one line for each test case in each state
+
+Once a section has been applied as usual (and its results logged), each of its test cases is
+run again a number of times in each of the cache states selected for it, and timed:
+
+  "cold" evicts the caches before each timed run, which measures the latency of the first
+    touch of the code and data.  The processor's caches are evicted by sweeping a buffer that's
+    much bigger than they are (64 MiB by default).  The pages of the files given to "addFile()"
+    are evicted from the page cache, and so is the whole page cache if "setDropCaches(true)"
+    has been called, but only where the program has permission to do so; "numUnevicted()"
+    counts the cold runs for which it didn't.
+  "warm" runs the test case once, untimed, before the timed runs, which measures its steady
+    state throughput.
+
+The states default to those given to the constructor, and "select()" picks them for a test (or
+for a range of its test cases), with later selections overriding earlier ones; selecting no
+states leaves the test cases untimed.  Only test cases that passed or failed are timed, not ones
+that aborted or that read extra lines from the test data stream, which couldn't be run again.
+The runs' log output is discarded, and each run gets a fresh copy of the test case, a fresh
+virtual clock and a fresh tokenizer.  The runs aren't counted in the section's duration (see
+"RunResult"), and since they come after the whole section they don't change what state its
+other test cases see.  But each run does see whatever state the section left behind, so a test
+whose test cases depend on what earlier ones did won't be timed meaningfully and should have no
+states selected.  A cancellation (see "cancel()") stops the runs too.  The tests are performed
+in a single process while they're being benchmarked (see "setWorkers()"), so that other
+processes don't disturb the caches.
+
+For each test case and state, the fastest, median and mean of the timed runs are kept.
+"write()" writes a line for each of them (e.g. "parseDate  12  cold  0.00018  0.00019
+0.000197"), and "summarize()" writes the total of the medians of each test's test cases in
+each state and how many test cases that comes to per second.
+
+The page cache is only evicted if "TESTSUITE_POSIX" is defined (with "posix_fadvise()"), and
+the whole page cache only on Linux, where it's usually only permitted for "root".
+*/
+
+// ============================================================================================
+// INCLUDE FILES
+// ============================================================================================
+
+#include <string.h>
+#include <stdlib.h>
+
+#ifdef FAT_FILENAMES
+  #include "testsuit.h"
+#else
+  #include "testsuite.h"
+#endif
+
+#ifdef TESTSUITE_POSIX
+  #include <fcntl.h>
+  #include <unistd.h>
+#endif
+
+// ============================================================================================
+// STATIC CONSTANTS
+// ============================================================================================
+
+static const unsigned long int cacheLineSize = 64UL;    // the stride of the cache sweep
+static const unsigned int      numStates     = 2U;
+
+static const TestSuite::Benchmark::CacheState cacheStates[numStates] =
+{
+  TestSuite::Benchmark::cold,
+  TestSuite::Benchmark::warm
+};
+
+static const char *const stateNames[numStates] =
+{
+  "cold",
+  "warm"
+};
+
+// ============================================================================================
+// STATIC FUNCTION DECLARATIONS
+// ============================================================================================
+
+static int compareTimes(const void*, const void*);
+
+// ============================================================================================
+// PUBLIC METHOD DEFINITIONS FOR TESTSUITE CLASS
+// ============================================================================================
+
+/*********************************************************************************************/
+
+void TestSuite::setBenchmark
+(
+  Benchmark *const benchmark    // where test cases are timed (or NULL)
+)
+
+/*
+This method makes this object time each test case that's applied with "benchmark", in the
+cache states selected for it (or stop timing them, if "benchmark" is NULL).  See
+"benchmark.cpp".
+
+POSTCONDITIONS:
+Every test case that passes or fails without reading extra lines will be timed.
+*/
+
+{
+  assertInvariants();
+
+  _benchmark = benchmark;
+
+  assertInvariants();
+  return;
+}
+
+// ============================================================================================
+// PRIVATE METHOD DEFINITIONS FOR TESTSUITE CLASS
+// ============================================================================================
+
+/*********************************************************************************************/
+
+void TestSuite::benchmarkCase
+(
+  Test&           test,
+  const TestCase& testCase              // a test case that has just been applied to "test"
+)
+
+/*
+This method runs "testCase" again in each of the cache states that "_benchmark" has selected
+for it, and records the times of the timed runs.  The runs' log output is discarded.  It's
+called by "applyTestCases()" after the section that "testCase" is in has been applied.
+*/
+
+{
+  const unsigned int states   = _benchmark->states(test.name(), testCase.number());
+  const unsigned int numRuns  = _benchmark->numRuns();
+  double *const      times    = new double[numRuns];    // how long each timed run took
+  ostrstream         discarded;                         // where the runs log to
+
+  for (unsigned int i = 0U; i < numStates; ++i)
+  {
+    if ((states & (unsigned int)cacheStates[i]) != 0U)
+    {
+      const int firstRun = (cacheStates[i] == Benchmark::warm ? -1 : 0);
+
+      for (int run = firstRun; run < (int)numRuns; ++run)
+      {
+        TestCase runCase(testCase.number(), testCase.lineCounter(), testCase.text());
+
+        test.setData(runCase, _testData, discarded);
+        _virtualClock.reset();
+        test._virtualClock = &_virtualClock;
+        _tokenizer.reset(runCase.text());
+        test._tokenizer = &_tokenizer;
+        discarded.seekp(0);
+
+        if (cacheStates[i] == Benchmark::cold)
+          _benchmark->evict();
+
+        const double startTime = timeStamp();
+
+        test.testMethod();
+
+        if (run >= 0)
+          times[run] = timeStamp() - startTime;
+      }
+
+      _benchmark->record(test.name(), testCase.number(), cacheStates[i], times);
+    }
+  }
+
+  delete[] times;
+
+  return;
+}
+
+// ============================================================================================
+// METHOD DEFINITIONS FOR TESTSUITE::BENCHMARK CLASS
+// ============================================================================================
+
+/*********************************************************************************************/
+
+TestSuite::Benchmark::Benchmark
+(
+  const unsigned int      defaultStates,  // the cache states for tests that aren't selected
+  const unsigned int      numRuns,        // no. of timed runs in each state
+  const unsigned long int sweepSize       // no. of bytes to sweep to evict the caches
+):
+
+/*
+This is the constructor for class "Benchmark".  "sweepSize" should be several times the size
+of the processor's largest cache.
+
+PRECONDITIONS:
+"numRuns" must be positive.
+*/
+
+  _defaultStates(defaultStates),
+  _numRuns(numRuns),
+  _sweepSize(sweepSize),
+  _sweep(NULL),
+  _sink(0U),
+  _rules(NULL),
+  _files(NULL),
+  _numFiles(0UL),
+  _dropCaches(false),
+  _numUnevicted(0UL),
+  _names(),
+  _measurements(NULL),
+  _numMeasurements(0UL),
+  _capacity(0UL)
+
+{
+  assert(numRuns > 0U);
+
+  return;
+}
+
+/*********************************************************************************************/
+
+TestSuite::Benchmark::~Benchmark()
+
+{
+  clear();
+
+  while (_rules != NULL)
+  {
+    Rule *const rule = _rules;
+
+    _rules = rule->next;
+    delete[] rule->testName;
+    delete rule;
+  }
+
+  for (unsigned long int i = 0UL; i < _numFiles; ++i)
+    delete[] _files[i];
+
+  delete[] _files;
+  delete[] _sweep;
+
+  return;
+}
+
+/*********************************************************************************************/
+
+void TestSuite::Benchmark::select
+(
+  const char *const  testName,
+  const unsigned int states,            // "cold", "warm", both or neither (0U)
+  const unsigned int firstCase,         // the first test case it applies to
+  const unsigned int lastCase           // the last test case it applies to
+)
+
+/*
+This method selects the cache states that test cases "firstCase" to "lastCase" of the test
+named "testName" are timed in, overriding any earlier selection for them.
+*/
+
+{
+  assert(testName != NULL);
+
+  Rule *const rule = new Rule;
+
+  rule->testName  = strcpy(new char[strlen(testName) + 1U], testName);
+  rule->states    = states;
+  rule->firstCase = firstCase;
+  rule->lastCase  = lastCase;
+  rule->next      = _rules;
+  _rules          = rule;
+
+  return;
+}
+
+/*********************************************************************************************/
+
+void TestSuite::Benchmark::addFile
+(
+  const char *const fileName            // a file that the code being tested reads
+)
+
+/*
+This method adds "fileName" to the files whose pages are evicted from the page cache before
+each cold run.
+*/
+
+{
+  assert(fileName != NULL);
+
+  char **const files = new char*[_numFiles + 1UL];
+
+  for (unsigned long int i = 0UL; i < _numFiles; ++i)
+    files[i] = _files[i];
+
+  files[_numFiles] = strcpy(new char[strlen(fileName) + 1U], fileName);
+
+  delete[] _files;
+  _files = files;
+  _numFiles++;
+
+  return;
+}
+
+/*********************************************************************************************/
+
+const unsigned int TestSuite::Benchmark::states
+(
+  const char *const  testName,
+  const unsigned int caseNum
+)
+const
+
+/*
+This method returns the cache states that test case "caseNum" of the test named "testName" is
+to be timed in:  those of the latest selection that covers it, or the default ones.
+*/
+
+{
+  assert(testName != NULL);
+
+  const Rule* rule = _rules;
+
+  while ((rule != NULL) && ((strcmp(rule->testName, testName) != 0) ||
+    (caseNum < rule->firstCase) || (caseNum > rule->lastCase)))
+    rule = rule->next;
+
+  return (rule != NULL ? rule->states : _defaultStates);
+}
+
+/*********************************************************************************************/
+
+const bool TestSuite::Benchmark::evict()
+
+/*
+This method evicts the processor's caches by sweeping "_sweep", and the pages it's been asked
+to evict from the page cache, and returns "true" if all of them were evicted.
+*/
+
+{
+  unsigned char sum = 0U;                       // what the sweep read
+  bool          evicted;
+
+  if (_sweep == NULL)
+  {
+    _sweep = new char[_sweepSize];
+    memset(_sweep, 0, _sweepSize);
+  }
+
+  for (unsigned long int i = 0UL; i < _sweepSize; i += cacheLineSize)
+  {
+    _sweep[i]++;
+    sum += (unsigned char)_sweep[i];
+  }
+
+  _sink   = sum;
+  evicted = evictPages();
+
+  if (!evicted)
+    _numUnevicted++;
+
+  return evicted;
+}
+
+/*********************************************************************************************/
+
+void TestSuite::Benchmark::record
+(
+  const char *const  testName,
+  const unsigned int caseNum,
+  const CacheState   state,
+  double *const      times              // the "_numRuns" times, which are sorted
+)
+
+/*
+This method records the fastest, median and mean of the times of the timed runs of a test case
+in a cache state.
+*/
+
+{
+  assert(testName != NULL);
+  assert(times != NULL);
+
+  double total = 0.0;
+
+  if (_numMeasurements == _capacity)
+  {
+    const unsigned long int newCapacity     = (_capacity == 0UL ? 256UL : _capacity * 2UL);
+    Measurement *const      newMeasurements = new Measurement[newCapacity];
+
+    for (unsigned long int i = 0UL; i < _numMeasurements; ++i)
+      newMeasurements[i] = _measurements[i];
+
+    delete[] _measurements;
+    _measurements = newMeasurements;
+    _capacity     = newCapacity;
+  }
+
+  qsort(times, _numRuns, sizeof(double), compareTimes);
+
+  for (unsigned int i = 0U; i < _numRuns; ++i)
+    total += times[i];
+
+  Measurement& measurement = _measurements[_numMeasurements++];
+
+  measurement.name    = _names.number(testName);
+  measurement.caseNum = caseNum;
+  measurement.state   = state;
+  measurement.min     = times[0];
+  measurement.median  = (times[(_numRuns - 1U) / 2U] + times[_numRuns / 2U]) / 2.0;
+  measurement.mean    = total / (double)_numRuns;
+
+  return;
+}
+
+/*********************************************************************************************/
+
+void TestSuite::Benchmark::write
+(
+  ostream&          stream,             // where to write the measurements
+  const char *const testName            // the only test to write them for (or NULL for all)
+)
+const
+
+/*
+This method writes a line for each test case and cache state that has been timed:  the test
+name, the test case number, the state and the fastest, median and mean times in seconds.
+*/
+
+{
+  const unsigned long int only = (testName == NULL ? 0UL : _names.find(testName));
+
+  for (unsigned long int i = 0UL; i < _numMeasurements; ++i)
+  {
+    const Measurement& measurement = _measurements[i];
+    const char *const  name        = _names.name(measurement.name);
+
+    if ((testName == NULL) || (measurement.name == only))
+    {
+      stream << name << "  " << measurement.caseNum << "  " <<
+        (measurement.state == cold ? stateNames[0] : stateNames[1]) << "  " <<
+        measurement.min << "  " << measurement.median << "  " << measurement.mean << '\n';
+    }
+  }
+
+  stream.flush();
+  return;
+}
+
+/*********************************************************************************************/
+
+void TestSuite::Benchmark::summarize
+(
+  ostream& stream                       // where to write the summary
+)
+const
+
+/*
+This method writes, for each test that has been timed and each cache state it was timed in,
+the number of test cases, the total of their median times and how many test cases per second
+that comes to.  It notes how many cold runs the page cache couldn't be evicted for.
+*/
+
+{
+  for (unsigned long int name = 0UL; name < _names.numNames(); ++name)
+  {
+    for (unsigned int i = 0U; i < numStates; ++i)
+    {
+      unsigned long int numCases = 0UL;
+      double            total    = 0.0;
+
+      for (unsigned long int j = 0UL; j < _numMeasurements; ++j)
+      {
+        if ((_measurements[j].name == name) && (_measurements[j].state == cacheStates[i]))
+        {
+          numCases++;
+          total += _measurements[j].median;
+        }
+      }
+
+      if (numCases > 0UL)
+      {
+        stream << _names.name(name) << " (" << stateNames[i] << "):  " << numCases <<
+          " test case" << (numCases == 1UL ? "" : "s") << ", " << total << " seconds";
+
+        if (total > 0.0)
+          stream << " (" << (double)numCases / total << " per second)";
+
+        stream << '\n';
+      }
+    }
+  }
+
+  if (_numUnevicted > 0UL)
+  {
+    stream << "The page cache couldn't be evicted for " << _numUnevicted << " cold run" <<
+      (_numUnevicted == 1UL ? "" : "s") << "." << '\n';
+  }
+
+  stream.flush();
+  return;
+}
+
+/*********************************************************************************************/
+
+void TestSuite::Benchmark::clear()
+
+/*
+This method discards the measurements (but not the selections or the files to evict).
+*/
+
+{
+  _names.clear();
+  delete[] _measurements;
+
+  _measurements    = NULL;
+  _numMeasurements = 0UL;
+  _capacity        = 0UL;
+  _numUnevicted    = 0UL;
+
+  return;
+}
+
+/*********************************************************************************************/
+
+const bool TestSuite::Benchmark::evictPages() const
+
+/*
+This method evicts the pages of "_files" from the page cache (after writing any that are
+dirty, since those can't be evicted), and the whole page cache if "_dropCaches" is set, and
+returns "true" if it could do all that was asked.
+*/
+
+{
+  bool evicted = true;
+
+  #ifdef TESTSUITE_POSIX
+    for (unsigned long int i = 0UL; i < _numFiles; ++i)
+    {
+      const int file = open(_files[i], O_RDONLY);
+
+      if (file < 0)
+        evicted = false;
+      else
+      {
+        fdatasync(file);
+        evicted = (posix_fadvise(file, 0, 0, POSIX_FADV_DONTNEED) == 0) && evicted;
+        close(file);
+      }
+    }
+
+    #ifdef __linux__
+      if (_dropCaches)
+      {
+        const int control = open("/proc/sys/vm/drop_caches", O_WRONLY);
+
+        sync();
+        evicted = (control >= 0) && (::write(control, "1", 1U) == 1) && evicted;
+
+        if (control >= 0)
+          close(control);
+      }
+    #else
+      evicted = !_dropCaches && evicted;
+    #endif
+  #else
+    evicted = (_numFiles == 0UL) && !_dropCaches;
+  #endif
+
+  return evicted;
+}
+
+// ============================================================================================
+// STATIC FUNCTION DEFINITIONS
+// ============================================================================================
+
+/*********************************************************************************************/
+
+static int compareTimes
+(
+  const void* first,
+  const void* second
+)
+
+/*
+This function is the comparison function for sorting times with "qsort()", fastest first.
+*/
+
+{
+  const double a = *(const double*)first;
+  const double b = *(const double*)second;
+
+  return (a < b ? -1 : (a > b ? 1 : 0));
+}
@@ -0,0 +1,325 @@
+// ============================================================================================
+//
+// SOURCE FILE:  clock.cpp
+//
+// ============================================================================================
+
+// ============================================================================================
+// DESCRIPTION
+// ============================================================================================
+
+/*
+This file implements "TestSuite::RealClock" and "TestSuite::VirtualClock", two kinds of
+"TestSuite::Clock".  Code that waits for timeouts, retries or expiry times can get the time
+from a "Clock&" instead of from the system; it's given a "RealClock" in production and the
+virtual clock of the test case being applied in a test method, so that hours of waiting take
+no time at all:
+
+  TEST(sessionExpires)
+  {
+    SessionTable table(virtualClock(), 1800.0);   // sessions expire after 30 minutes
+
+    table.open("alice");
+    virtualClock().sleep(1801.0);                  // returns immediately
+    return (table.isOpen("alice") ? fail : pass);
+  }
+
+Each "TestSuite" object has one virtual clock.  It's reset before each test case is applied,
+so a test case starts at time 0.0 with no timers pending, and "Test::virtualClock()" refers to
+it.  Time only moves when it's told to:
+
+  "sleep(s)" and "advance(s)" move the time "s" seconds forward.
+  "addTimer(s, callback, context)" makes "callback(context)" be called when the time gets "s"
+    seconds further on.  It returns an id that can be passed to "cancelTimer()".
+  "runUntilIdle()" moves the time forward to each pending timer in turn and calls its callback,
+    until there are none left.
+
+Timers are called in order of expiry (and in the order they were added if they expire at the
+same time), and "now()" returns the time a timer expired at while its callback is running.
+Callbacks can add and cancel timers and sleep.
+
+A test case is applied on one thread, so whenever the test method or the code under test
+sleeps, everything is waiting for the clock and the time can jump straight to the end of the
+sleep (calling the timers that expire on the way).  "runUntilIdle()" is how a test method
+waits for work that's only driven by timers, e.g. a retry loop.  Since a timer can add another
+timer when it's called, "runUntilIdle()" stops after one simulated year unless it's given some
+other limit.  Timers that are still pending when the test method returns are discarded without
+being called.
+
+"RealClock::sleep()" really sleeps.  If "TESTSUITE_POSIX" isn't defined then "timeStamp()" is
+processor time, so it waits by keeping the processor busy.
+*/
+
+// ============================================================================================
+// INCLUDE FILES
+// ============================================================================================
+
+#ifdef FAT_FILENAMES
+  #include "testsuit.h"
+#else
+  #include "testsuite.h"
+#endif
+
+#ifdef TESTSUITE_POSIX
+  #include <time.h>
+  #include <errno.h>
+#endif
+
+// ============================================================================================
+// METHOD DEFINITIONS FOR TESTSUITE::REALCLOCK CLASS
+// ============================================================================================
+
+/*********************************************************************************************/
+
+void TestSuite::RealClock::sleep
+(
+  const double seconds                  // how long to wait
+)
+
+/*
+This method waits for "seconds" seconds (or doesn't wait at all if "seconds" isn't positive).
+*/
+
+{
+  #ifdef TESTSUITE_POSIX
+    timespec remaining;                           // how much of the wait is left
+    int      status;                              // what "nanosleep()" returned
+
+    if (seconds > 0.0)
+    {
+      remaining.tv_sec  = (time_t)seconds;
+      remaining.tv_nsec = (long)((seconds - (double)remaining.tv_sec) * 1.0e9);
+
+      do
+        status = nanosleep(&remaining, &remaining);
+      while ((status != 0) && (errno == EINTR));
+    }
+  #else
+    const double wakeTime = timeStamp() + seconds;  // when to stop waiting
+    double       time;                              // the time now
+
+    do
+      time = timeStamp();
+    while (time < wakeTime);
+  #endif
+
+  return;
+}
+
+// ============================================================================================
+// METHOD DEFINITIONS FOR TESTSUITE::VIRTUALCLOCK CLASS
+// ============================================================================================
+
+/*********************************************************************************************/
+
+TestSuite::VirtualClock::VirtualClock():
+
+/*
+This is the constructor for class "VirtualClock".  The time starts at 0.0, with no timers
+pending.
+*/
+
+  _now(0.0),
+  _lastId(0UL),
+  _timers(NULL),
+  _numTimers(0UL)
+
+{
+  return;
+}
+
+/*********************************************************************************************/
+
+void TestSuite::VirtualClock::sleep
+(
+  const double seconds                  // how long to wait
+)
+
+/*
+This method moves the time "seconds" seconds forward and calls the timers that expire on the
+way.  It returns immediately.
+*/
+
+{
+  advance(seconds);
+  return;
+}
+
+/*********************************************************************************************/
+
+const unsigned long int TestSuite::VirtualClock::addTimer
+(
+  const double   delay,                 // how far in the future it expires
+  const Callback callback,              // what to call when it expires
+  void *const    context                // what to pass to "callback"
+)
+
+/*
+This method adds a timer that calls "callback(context)" when the time has moved "delay" seconds
+forward (or the next time it moves, if "delay" isn't positive) and returns an id for it, which
+is never 0UL.
+
+PRECONDITIONS:
+"callback" mustn't be NULL.
+*/
+
+{
+  assert(callback != NULL);
+
+  Timer *const timer    = new Timer;
+  Timer**      position = &_timers;             // where to link the new timer in
+
+  timer->due      = (delay > 0.0 ? _now + delay : _now);
+  timer->id       = ++_lastId;
+  timer->callback = callback;
+  timer->context  = context;
+
+  while ((*position != NULL) && ((*position)->due <= timer->due))
+    position = &(*position)->next;
+
+  timer->next = *position;
+  *position   = timer;
+  _numTimers++;
+
+  return timer->id;
+}
+
+/*********************************************************************************************/
+
+const bool TestSuite::VirtualClock::cancelTimer
+(
+  const unsigned long int id            // what "addTimer()" returned
+)
+
+/*
+This method removes the timer with the given id without calling it, and returns "true" if it
+was pending or "false" if it had already expired or been cancelled.
+*/
+
+{
+  Timer** position = &_timers;                  // where the timer is linked in
+  bool    found    = false;
+
+  while ((*position != NULL) && ((*position)->id != id))
+    position = &(*position)->next;
+
+  if (*position != NULL)
+  {
+    Timer *const timer = *position;
+
+    *position = timer->next;
+    delete timer;
+    _numTimers--;
+    found = true;
+  }
+
+  return found;
+}
+
+/*********************************************************************************************/
+
+const unsigned long int TestSuite::VirtualClock::advance
+(
+  const double seconds                  // how far to move the time forward
+)
+
+/*
+This method moves the time "seconds" seconds forward, calling the timers that expire on the
+way in order, and returns the number of timers that were called.
+*/
+
+{
+  const double      target   = _now + (seconds > 0.0 ? seconds : 0.0);
+  unsigned long int numFired = 0UL;
+
+  while (fireNext(target))
+    numFired++;
+
+  if (_now < target)
+    _now = target;
+
+  return numFired;
+}
+
+/*********************************************************************************************/
+
+const unsigned long int TestSuite::VirtualClock::runUntilIdle
+(
+  const double maxSeconds               // the furthest to move the time forward
+)
+
+/*
+This method moves the time forward to each pending timer in turn and calls it, until there are
+no timers left or the next one expires more than "maxSeconds" seconds from now.  It returns the
+number of timers that were called.  The time is left at the expiry time of the last one.
+*/
+
+{
+  const double      limit    = _now + maxSeconds;
+  unsigned long int numFired = 0UL;
+
+  while (fireNext(limit))
+    numFired++;
+
+  return numFired;
+}
+
+/*********************************************************************************************/
+
+void TestSuite::VirtualClock::reset()
+
+/*
+This method discards the pending timers without calling them and sets the time back to 0.0.
+*/
+
+{
+  while (_timers != NULL)
+  {
+    Timer *const timer = _timers;
+
+    _timers = timer->next;
+    delete timer;
+  }
+
+  _now       = 0.0;
+  _numTimers = 0UL;
+
+  return;
+}
+
+/*********************************************************************************************/
+
+const bool TestSuite::VirtualClock::fireNext
+(
+  const double limit                    // the latest expiry time to call a timer for
+)
+
+/*
+This method removes the first pending timer and calls it, after moving the time forward to its
+expiry time, if it expires no later than "limit".  It returns "true" if a timer was called.
+
+The timer is removed before it's called, so that the callback can add and cancel timers or
+sleep.
+*/
+
+{
+  Timer *const timer = _timers;                 // the timer that expires first
+  const bool   fire  = ((timer != NULL) && (timer->due <= limit));
+
+  if (fire)
+  {
+    const Callback callback = timer->callback;
+    void *const    context  = timer->context;
+
+    _timers = timer->next;
+    _numTimers--;
+
+    if (_now < timer->due)
+      _now = timer->due;
+
+    delete timer;
+    callback(context);
+  }
+
+  return fire;
+}
@@ -0,0 +1,915 @@
+// ============================================================================================
+//
+// SOURCE FILE:  coverage.cpp
+//
+// ============================================================================================
+
+// ============================================================================================
+// DESCRIPTION
+// ============================================================================================
+
+/*
+This file implements "TestSuite::CoverageMap", which records which source files each test
+executes, and "TestSuite::changed()", which uses it to perform only the tests that a change can
+affect.  It's meant for builds that check a change before it's merged:
+
+  TestSuite::CoverageMap map;
+  ifstream               mapFile("coverage.map");
+
+  map.read(mapFile);
+  map.readChanged(cin);                     // e.g. from "git diff --name-only main"
+  test.changed(map);
+
+"changed()" performs the tests that execute at least one of the changed files, plus every
+registered test that isn't in the map at all (i.e. new tests, which have never been measured).
+Like "tagged()", it performs them in the order in which they appear in the test data stream.
+
+The map is built once, from a build that was compiled for coverage.  Each test is performed on
+its own (e.g. with "one()") with the coverage counters reset beforehand, and the counters are
+then exported as an LCOV trace file, which both GCC ("lcov --capture" or "gcovr --lcov") and
+Clang ("llvm-cov export -format=lcov") can produce.  "addTrace()" adds the files with at least
+one line executed to the test's entry; "testcov" (see "testcov.cpp") does it from the command
+line:
+
+  testcov coverage.map add parseDate parseDate.info
+
+A source file in the map matches a changed file if they're the same or one ends with the other
+at a "/", so paths relative to the top of the repository match the absolute paths in trace
+files.  "addChanged()" and "readChanged()" return the number of files in the map that matched.
+A changed file that matches nothing in the map (e.g. a new source file, or one that no test has
+executed yet) is kept in a list of unmatched files.  While that list isn't empty, "changed()"
+logs the files and performs every test, since the map can't say what they affect.
+
+The map file is text.  Each source file is named once and each test lists the numbers of its
+files (counting "F" lines from 0):
+
+  F <source file path>
+  T <test name> <file no.> <file no.>...
+
+Lines starting with "//" are comments.
+*/
+
+// ============================================================================================
+// INCLUDE FILES
+// ============================================================================================
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#ifdef FAT_FILENAMES
+  #include "testsuit.h"
+#else
+  #include "testsuite.h"
+#endif
+
+// ============================================================================================
+// STATIC CONSTANTS
+// ============================================================================================
+
+static const char fileTag     = 'F';        // starts a source file line in a map file
+static const char testTag     = 'T';        // starts a test line in a map file
+static const char mapHeader[] = "// TestSuite coverage map";
+
+// ============================================================================================
+// STATIC FUNCTION DECLARATIONS
+// ============================================================================================
+
+static const bool              readLine(istream&, char*&, size_t&);
+static const unsigned long int hashPath(const char *const);
+static const bool              sameFile(const char *const, const char *const);
+static int                     compareIndices(const void*, const void*);
+
+// ============================================================================================
+// PUBLIC METHOD DEFINITIONS FOR TESTSUITE CLASS
+// ============================================================================================
+
+/*********************************************************************************************/
+
+const TestSuite::RunResult& TestSuite::changed
+(
+  const CoverageMap& map                // what each test executes, and which files changed
+)
+
+/*
+This method performs the tests that "map" says are affected by the files given to its
+"addChanged()" and "readChanged()", plus any registered tests that aren't in "map".  If any
+of the changed files matched nothing in "map" then they're logged and every registered test is
+performed instead.  See "coverage.cpp".
+
+Tests are performed in the order in which they appear in the test data stream.
+
+PRECONDITIONS:
+None.
+
+POSTCONDITIONS:
+All test cases in the test data stream (if any) will have been applied to the affected test
+objects.  If no test objects are affected then it's logged and no tests are performed.
+The results are returned (see "RESULTS", above).
+*/
+
+{
+  assertInvariants();
+
+  prepareForTesting();
+  logHeader();
+
+  if (map.numUnmatched() > 0UL)
+  {
+    logUnmatchedFiles(map);
+    runTests(_tests);
+  }
+  else
+  {
+    const ListNode *const tests = getTests(map);            // list of tests to perform
+
+    if (tests == NULL)
+      logNoAffectedTests();
+    else
+    {
+      runTests(tests);
+      deleteList(tests);
+    }
+  }
+
+  finishTesting();
+  logFooter();
+
+  assertInvariants();
+  return _result;
+}
+
+// ============================================================================================
+// PROTECTED METHOD DEFINITIONS FOR TESTSUITE CLASS
+// ============================================================================================
+
+/*********************************************************************************************/
+
+void TestSuite::logNoAffectedTests() const
+
+/*
+This method sends a message to "report()" saying that "changed()" found no tests to perform.
+*/
+
+{
+  log() << "*** No tests are affected by the changed files. ***" << endl << endl;
+  return;
+}
+
+/*********************************************************************************************/
+
+void TestSuite::logUnmatchedFiles
+(
+  const CoverageMap& map                // has changed files that matched nothing in it
+)
+const
+
+/*
+This method sends a message to "report()" saying that "changed()" is performing every test
+because of the changed files that "map" doesn't know about.
+*/
+
+{
+  log() << "-------------------------------------------------------------------------------" <<
+    endl;
+  log() << "*** These changed files aren't in the coverage map, so every test is being "
+    "performed:  ";
+
+  for (unsigned long int i = 0UL; i < map.numUnmatched(); ++i)
+    log() << (i == 0UL ? "" : " ") << map.unmatched(i);
+
+  log() << " ***" << endl;
+  log() << endl;
+  return;
+}
+
+// ============================================================================================
+// PRIVATE METHOD DEFINITIONS FOR TESTSUITE CLASS
+// ============================================================================================
+
+/*********************************************************************************************/
+
+const TestSuite::ListNode *const TestSuite::getTests
+(
+  const CoverageMap& map                // selects test objects by the files they execute
+)
+const
+
+/*
+This method returns a list of the registered test objects that "map" says are affected by the
+changed files.  It is the caller's responsibility to eventually de-allocate the list (but NOT
+the test objects).
+
+POSTCONDITIONS:
+A list of test objects is returned, which will be NULL if no test objects are selected.
+*/
+
+{
+  assertInvariants();
+
+  ListNode*       tests   = NULL;
+  const ListNode* current = _tests;                                   // iterates through tests
+
+  while (current != NULL)
+  {
+    if (map.affects(current->test()->name()))
+    {
+      tests = new ListNode(current->test(), tests);
+      assert(tests != NULL);
+    }
+
+    current = current->next();
+  }
+
+  return tests;
+}
+
+// ============================================================================================
+// METHOD DEFINITIONS FOR TESTSUITE::COVERAGEMAP CLASS
+// ============================================================================================
+
+/*********************************************************************************************/
+
+TestSuite::CoverageMap::CoverageMap():
+
+/*
+This is the constructor for class "CoverageMap".  The map starts out empty.
+*/
+
+  _files(NULL),
+  _changed(NULL),
+  _numFiles(0UL),
+  _capacity(0UL),
+  _table(NULL),
+  _tableSize(0UL),
+  _tests(NULL),
+  _lastTest(NULL),
+  _testNames(),
+  _entries(NULL),
+  _entriesCapacity(0UL),
+  _unmatched(NULL),
+  _numUnmatched(0UL)
+
+{
+  return;
+}
+
+/*********************************************************************************************/
+
+const bool TestSuite::CoverageMap::read
+(
+  istream& stream                       // a map that was written by "write()"
+)
+
+/*
+This method replaces the contents of this map with the map in "stream" and returns "true", or
+returns "false" (leaving the map with whatever was read before the problem) if "stream" isn't
+a valid map.  No files are marked as changed afterward.
+*/
+
+{
+  char*             line     = NULL;            // the line being parsed
+  size_t            capacity = 0U;              // no. of characters allocated for "line"
+  bool              valid    = true;            // has everything read so far been valid?
+  unsigned long int numFiles = 0UL;             // no. of entries in "files"
+  unsigned long int* files   = NULL;            // the file numbers on a test line
+
+  clear();
+
+  while (valid && readLine(stream, line, capacity))
+  {
+    if ((line[0] == fileTag) && (line[1] == ' ') && (line[2] != '\0'))
+      valid = (fileIndex(line + 2) == _numFiles - 1UL);
+    else if ((line[0] == testTag) && (line[1] == ' '))
+    {
+      char*        position = line + 2;          // where the next field starts
+      const char*  name     = position;
+      char*        end;
+
+      while ((*position != ' ') && (*position != '\0'))
+        position++;
+
+      delete[] files;
+      files    = new unsigned long int[strlen(position) / 2U + 1U];
+      numFiles = 0UL;
+
+      if (*position == ' ')
+        *position++ = '\0';
+
+      while (valid && (*position != '\0'))
+      {
+        files[numFiles] = strtoul(position, &end, 10);
+        valid           = ((end != position) && (files[numFiles] < _numFiles));
+        position        = end + strspn(end, " ");
+        numFiles++;
+      }
+
+      valid = valid && (*name != '\0') && (findTest(name) == NULL);
+
+      if (valid)
+        addFiles(test(name), files, numFiles);
+    }
+    else
+      valid = ((line[0] == '\0') || ((line[0] == '/') && (line[1] == '/')));
+  }
+
+  delete[] files;
+  delete[] line;
+
+  return valid;
+}
+
+/*********************************************************************************************/
+
+void TestSuite::CoverageMap::write
+(
+  ostream& stream                       // where to write the map
+)
+const
+
+/*
+This method writes this map to "stream" in the form that "read()" reads.
+*/
+
+{
+  const TestEntry* current = _tests;
+
+  stream << mapHeader << endl;
+
+  for (unsigned long int i = 0UL; i < _numFiles; ++i)
+    stream << fileTag << ' ' << _files[i] << '\n';
+
+  for (; current != NULL; current = current->next)
+  {
+    stream << testTag << ' ' << current->name;
+
+    for (unsigned long int i = 0UL; i < current->numFiles; ++i)
+      stream << ' ' << current->files[i];
+
+    stream << '\n';
+  }
+
+  stream.flush();
+  return;
+}
+
+/*********************************************************************************************/
+
+const unsigned long int TestSuite::CoverageMap::addTrace
+(
+  const char *const testName,           // the test that was performed
+  istream&          trace               // the LCOV trace file of what it executed
+)
+
+/*
+This method adds the source files that "trace" shows at least one line of being executed to
+the files that "testName" executes, and returns the number of such files in "trace".  The test
+is added to the map even if it didn't execute anything, so that it's no longer treated as a
+new test.
+
+A file counts as executed if a "DA:" line for it has a non-zero count, or if its "LH:" line
+says that lines were hit (for trace files that only have summaries).
+*/
+
+{
+  assert(testName != NULL);
+
+  char*              line      = NULL;          // the line being parsed
+  size_t             capacity  = 0U;            // no. of characters allocated for "line"
+  unsigned long int* files     = NULL;          // the files executed, in the order found
+  unsigned long int  numFiles  = 0UL;           // no. of entries in use in "files"
+  unsigned long int  allocated = 0UL;           // no. of entries allocated for "files"
+  unsigned long int  current   = 0UL;           // the file that the record is for
+  bool               inRecord  = false;         // has an "SF:" line started a record?
+  bool               executed  = false;         // has the record shown any line executed?
+  TestEntry&         entry     = test(testName);
+
+  while (readLine(trace, line, capacity))
+  {
+    if (strncmp(line, "SF:", 3U) == 0)
+    {
+      current  = fileIndex(line + 3);
+      inRecord = true;
+      executed = false;
+    }
+    else if (inRecord && (strncmp(line, "DA:", 3U) == 0))
+    {
+      const char *const comma = strchr(line + 3, ',');
+
+      executed = executed || ((comma != NULL) && (strtoul(comma + 1, NULL, 10) > 0UL));
+    }
+    else if (inRecord && (strncmp(line, "LH:", 3U) == 0))
+      executed = executed || (strtoul(line + 3, NULL, 10) > 0UL);
+    else if (inRecord && (strcmp(line, "end_of_record") == 0))
+    {
+      inRecord = false;
+
+      if (executed)
+      {
+        if (numFiles == allocated)
+        {
+          unsigned long int *const larger = new unsigned long int[allocated * 2UL + 16UL];
+
+          if (numFiles > 0UL)
+            memcpy(larger, files, numFiles * sizeof(unsigned long int));
+
+          delete[] files;
+          files     = larger;
+          allocated = allocated * 2UL + 16UL;
+        }
+
+        files[numFiles++] = current;
+      }
+    }
+  }
+
+  addFiles(entry, files, numFiles);
+
+  delete[] files;
+  delete[] line;
+
+  return numFiles;
+}
+
+/*********************************************************************************************/
+
+void TestSuite::CoverageMap::clearChanged()
+
+/*
+This method marks every file in the map as unchanged and empties the list of unmatched files.
+*/
+
+{
+  for (unsigned long int i = 0UL; i < _numFiles; ++i)
+    _changed[i] = false;
+
+  for (unsigned long int i = 0UL; i < _numUnmatched; ++i)
+    delete[] _unmatched[i];
+
+  delete[] _unmatched;
+  _unmatched    = NULL;
+  _numUnmatched = 0UL;
+
+  return;
+}
+
+/*********************************************************************************************/
+
+const unsigned long int TestSuite::CoverageMap::addChanged
+(
+  const char *const path                // a file that has changed
+)
+
+/*
+This method marks the files in the map that match "path" as changed and returns how many there
+were.  "path" matches a file if they're the same or one ends with the other at a "/" (a leading
+"./" on "path" is ignored).  If nothing matches, "path" is added to the unmatched files.
+*/
+
+{
+  assert(path != NULL);
+
+  const char *const trimmed    = ((path[0] == '.') && (path[1] == '/') ? path + 2 : path);
+  unsigned long int numMatches = 0UL;
+
+  for (unsigned long int i = 0UL; i < _numFiles; ++i)
+  {
+    if (sameFile(_files[i], trimmed))
+    {
+      _changed[i] = true;
+      numMatches++;
+    }
+  }
+
+  if (numMatches == 0UL)
+  {
+    char **const larger = new char*[_numUnmatched + 1UL];
+
+    for (unsigned long int i = 0UL; i < _numUnmatched; ++i)
+      larger[i] = _unmatched[i];
+
+    larger[_numUnmatched++] = strcpy(new char[strlen(trimmed) + 1U], trimmed);
+    delete[] _unmatched;
+    _unmatched = larger;
+  }
+
+  return numMatches;
+}
+
+/*********************************************************************************************/
+
+const unsigned long int TestSuite::CoverageMap::readChanged
+(
+  istream& stream                       // the changed files, one per line
+)
+
+/*
+This method calls "addChanged()" for each (non-blank) line of "stream" and returns the total
+number of files in the map that matched.
+*/
+
+{
+  char*             line       = NULL;          // a changed file
+  size_t            capacity   = 0U;            // no. of characters allocated for "line"
+  unsigned long int numMatches = 0UL;
+
+  while (readLine(stream, line, capacity))
+  {
+    if (line[0] != '\0')
+      numMatches += addChanged(line);
+  }
+
+  delete[] line;
+
+  return numMatches;
+}
+
+/*********************************************************************************************/
+
+const bool TestSuite::CoverageMap::affects
+(
+  const char *const testName            // the test to check
+)
+const
+
+/*
+This method returns "true" if the test named "testName" executes a file that's marked as
+changed, or if it isn't in the map at all.
+*/
+
+{
+  const TestEntry *const entry    = findTest(testName);
+  bool                   affected = (entry == NULL);
+
+  for (unsigned long int i = 0UL; !affected && (i < entry->numFiles); ++i)
+    affected = _changed[entry->files[i]];
+
+  return affected;
+}
+
+/*********************************************************************************************/
+
+const unsigned long int TestSuite::CoverageMap::listAffected
+(
+  ostream& stream                       // where to list the tests
+)
+const
+
+/*
+This method writes the names of the tests in the map that execute a file that's marked as
+changed to "stream", one per line, and returns how many there were.  (Tests that aren't in the
+map are affected too, but the map can't list them.)
+*/
+
+{
+  unsigned long int numAffected = 0UL;
+
+  for (const TestEntry* current = _tests; current != NULL; current = current->next)
+  {
+    if (affects(current->name))
+    {
+      stream << current->name << '\n';
+      numAffected++;
+    }
+  }
+
+  stream.flush();
+  return numAffected;
+}
+
+/*********************************************************************************************/
+
+void TestSuite::CoverageMap::clear()
+
+/*
+This method empties the map.
+*/
+
+{
+  clearChanged();
+
+  while (_tests != NULL)
+  {
+    TestEntry *const victim = _tests;
+
+    _tests = victim->next;
+    delete[] victim->files;
+    delete victim;
+  }
+
+  for (unsigned long int i = 0UL; i < _numFiles; ++i)
+    delete[] _files[i];
+
+  delete[] _files;
+  delete[] _changed;
+  delete[] _table;
+  delete[] _entries;
+  _testNames.clear();
+
+  _files           = NULL;
+  _changed         = NULL;
+  _numFiles        = 0UL;
+  _capacity        = 0UL;
+  _table           = NULL;
+  _tableSize       = 0UL;
+  _lastTest        = NULL;
+  _entries         = NULL;
+  _entriesCapacity = 0UL;
+
+  return;
+}
+
+/*********************************************************************************************/
+
+const unsigned long int TestSuite::CoverageMap::fileIndex
+(
+  const char *const path                // a source file's path
+)
+
+/*
+This method returns the number of the source file "path" in "_files", adding it first if it
+isn't there.  "_table" is an open addressing hash table of file numbers (plus one, so that 0UL
+means an empty slot) that's kept at most half full.
+*/
+
+{
+  unsigned long int slot;                       // where "path" is (or belongs) in "_table"
+
+  if ((_numFiles + 1UL) * 2UL > _tableSize)
+  {
+    delete[] _table;
+    _tableSize = (_tableSize == 0UL ? 256UL : _tableSize * 2UL);
+    _table     = new unsigned long int[_tableSize];
+
+    for (slot = 0UL; slot < _tableSize; ++slot)
+      _table[slot] = 0UL;
+
+    for (unsigned long int i = 0UL; i < _numFiles; ++i)
+    {
+      slot = hashPath(_files[i]) % _tableSize;
+
+      while (_table[slot] != 0UL)
+        slot = (slot + 1UL) % _tableSize;
+
+      _table[slot] = i + 1UL;
+    }
+  }
+
+  slot = hashPath(path) % _tableSize;
+
+  while ((_table[slot] != 0UL) && (strcmp(_files[_table[slot] - 1UL], path) != 0))
+    slot = (slot + 1UL) % _tableSize;
+
+  if (_table[slot] == 0UL)
+  {
+    if (_numFiles == _capacity)
+    {
+      char **const larger  = new char*[_capacity * 2UL + 64UL];
+      bool *const  changed = new bool[_capacity * 2UL + 64UL];
+
+      for (unsigned long int i = 0UL; i < _numFiles; ++i)
+      {
+        larger[i]  = _files[i];
+        changed[i] = _changed[i];
+      }
+
+      delete[] _files;
+      delete[] _changed;
+      _files    = larger;
+      _changed  = changed;
+      _capacity = _capacity * 2UL + 64UL;
+    }
+
+    _files[_numFiles]   = strcpy(new char[strlen(path) + 1U], path);
+    _changed[_numFiles] = false;
+    _table[slot]        = ++_numFiles;
+  }
+
+  return (_table[slot] - 1UL);
+}
+
+/*********************************************************************************************/
+
+TestSuite::CoverageMap::TestEntry *const TestSuite::CoverageMap::findTest
+(
+  const char *const testName            // the test to look for
+)
+const
+
+/*
+This method returns the entry for "testName", or NULL if it isn't in the map.
+*/
+
+{
+  assert(testName != NULL);
+
+  const unsigned long int number = _testNames.find(testName);
+
+  return (number < _testNames.numNames() ? _entries[number] : (TestEntry*)NULL);
+}
+
+/*********************************************************************************************/
+
+TestSuite::CoverageMap::TestEntry& TestSuite::CoverageMap::test
+(
+  const char *const testName            // the test to look for
+)
+
+/*
+This method returns the entry for "testName", appending an empty one if it isn't in the map.
+*/
+
+{
+  const unsigned long int numTests = _testNames.numNames();
+  const unsigned long int number   = _testNames.number(testName);
+
+  if (number == numTests)
+  {
+    if (numTests == _entriesCapacity)
+    {
+      TestEntry **const larger = new TestEntry*[_entriesCapacity * 2UL + 64UL];
+
+      for (unsigned long int i = 0UL; i < numTests; ++i)
+        larger[i] = _entries[i];
+
+      delete[] _entries;
+      _entries         = larger;
+      _entriesCapacity = _entriesCapacity * 2UL + 64UL;
+    }
+
+    TestEntry *const entry = new TestEntry;
+
+    entry->name     = _testNames.name(number);
+    entry->files    = NULL;
+    entry->numFiles = 0UL;
+    entry->next     = NULL;
+
+    if (_lastTest == NULL)
+      _tests = entry;
+    else
+      _lastTest->next = entry;
+
+    _lastTest        = entry;
+    _entries[number] = entry;
+  }
+
+  return *_entries[number];
+}
+
+/*********************************************************************************************/
+
+void TestSuite::CoverageMap::addFiles
+(
+  TestEntry&                     entry,
+  const unsigned long int *const files,       // file numbers to add to "entry" (any order)
+  const unsigned long int        numFiles     // no. of entries in "files"
+)
+
+/*
+This method merges "files" into "entry"'s files, keeping them in ascending order without
+repeats.
+*/
+
+{
+  unsigned long int *const merged = new unsigned long int[entry.numFiles + numFiles + 1UL];
+  unsigned long int        total  = entry.numFiles + numFiles;
+  unsigned long int        kept   = 0UL;        // no. of distinct entries in "merged"
+
+  if (entry.numFiles > 0UL)
+    memcpy(merged, entry.files, entry.numFiles * sizeof(unsigned long int));
+
+  if (numFiles > 0UL)
+    memcpy(merged + entry.numFiles, files, numFiles * sizeof(unsigned long int));
+
+  qsort(merged, total, sizeof(unsigned long int), compareIndices);
+
+  for (unsigned long int i = 0UL; i < total; ++i)
+  {
+    if ((kept == 0UL) || (merged[kept - 1UL] != merged[i]))
+      merged[kept++] = merged[i];
+  }
+
+  delete[] entry.files;
+  entry.files    = merged;
+  entry.numFiles = kept;
+
+  return;
+}
+
+// ============================================================================================
+// STATIC FUNCTION DEFINITIONS
+// ============================================================================================
+
+/*********************************************************************************************/
+
+static const bool readLine
+(
+  istream& stream,
+  char*&   line,                        // where the line is returned (re-allocated as needed)
+  size_t&  capacity                     // no. of characters allocated for "line"
+)
+
+/*
+This function reads the next line from "stream" into "line", without the newline (or carriage
+return before it), and returns "true", or returns "false" if there are no more lines.
+*/
+
+{
+  size_t length = 0U;                           // no. of characters read so far
+  int    inputChar = stream.get();
+
+  while ((inputChar != EOF) && (inputChar != '\n'))
+  {
+    if (length + 1U >= capacity)
+    {
+      char *const larger = new char[capacity * 2U + 256U];
+
+      if (length > 0U)
+        memcpy(larger, line, length);
+
+      delete[] line;
+      line     = larger;
+      capacity = capacity * 2U + 256U;
+    }
+
+    line[length++] = (char)inputChar;
+    inputChar      = stream.get();
+  }
+
+  if ((length > 0U) && (line[length - 1U] == '\r'))
+    length--;
+
+  if (line == NULL)
+  {
+    capacity = 256U;
+    line     = new char[capacity];
+  }
+
+  line[length] = '\0';
+
+  return ((inputChar != EOF) || (length > 0U));
+}
+
+/*********************************************************************************************/
+
+static const unsigned long int hashPath
+(
+  const char *const path
+)
+
+/*
+This function returns an FNV-1a hash of "path".
+*/
+
+{
+  unsigned long int hash = 2166136261UL;
+
+  for (const char* current = path; *current != '\0'; current++)
+    hash = (hash ^ (unsigned char)*current) * 16777619UL;
+
+  return hash;
+}
+
+/*********************************************************************************************/
+
+static const bool sameFile
+(
+  const char *const first,
+  const char *const second
+)
+
+/*
+This function returns "true" if "first" and "second" are the same or if the longer of them
+ends with the shorter one just after a "/".
+*/
+
+{
+  const size_t      firstLength  = strlen(first);
+  const size_t      secondLength = strlen(second);
+  const char *const longer       = (firstLength >= secondLength ? first : second);
+  const char *const shorter      = (firstLength >= secondLength ? second : first);
+  const size_t      difference   = (firstLength >= secondLength ? firstLength - secondLength :
+                                     secondLength - firstLength);
+
+  return ((*shorter != '\0') && (strcmp(longer + difference, shorter) == 0) &&
+    ((difference == 0U) || (longer[difference - 1U] == '/')));
+}
+
+/*********************************************************************************************/
+
+static int compareIndices
+(
+  const void* first,
+  const void* second
+)
+
+/*
+This function compares two file numbers for "qsort()".
+*/
+
+{
+  const unsigned long int a = *(const unsigned long int*)first;
+  const unsigned long int b = *(const unsigned long int*)second;
+
+  return (a < b ? -1 : (a > b ? 1 : 0));
+}
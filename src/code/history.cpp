@@ -0,0 +1,1270 @@
+// ============================================================================================
+//
+// SOURCE FILE:  history.cpp
+//
+// ============================================================================================
+
+// ============================================================================================
+// DESCRIPTION
+// ============================================================================================
+
+/*
+This file implements "TestSuite::History", an append-only store of the result of every test
+case of every run, kept in a compact binary file.  It's what scheduling, regression detection
+and the triage of flaky tests need to look back on, and it can be queried by programs (see
+"testhist.cpp") as well as by "TestSuite" itself.
+
+A history is recorded like this:
+
+  TestSuite::History history("results.hst");
+
+  history.beginRun("nightly-2041", "build-1187");   // run and build identifiers
+  test.setHistory(&history);
+  test.all();                                       // (and/or any other tests)
+  history.endRun();                                 // appends the run to the file
+
+For each test case, the test name, test case number, test result, elapsed time, processor time
+and (if "TESTSUITE_POSIX" is defined) number of page faults are recorded.  A run is only written
+to the file by "endRun()", all at once, so a run that crashes leaves the file as it was.
+
+Runs are found by reading the file backward from its end, so queries that only need recent runs
+("percentile()", "newFailures()") take the same time no matter how many years of history the
+file holds.  Only "listRuns()" reads the whole file.
+*/
+
+// ============================================================================================
+// FORMAT OF THE HISTORY FILE
+// ============================================================================================
+
+/*
+The file starts with the 8 characters "TSHIST1\n", followed by one block for each run:
+
+  <length> <run record> <name or case record>... <length>
+
+where both "<length>"s are the number of bytes between them as 4-byte little-endian unsigned
+integers (the second one is what lets the file be read backward).  Within a block, numbers are
+unsigned and written 7 bits per byte, least significant first, with the high bit set on every
+byte but the last.  Strings are written with a terminating '\0'.
+
+  'R' <time> <run id> <build id>                           -- once, at the start of the block
+  'N' <test name>                                          -- gives the next name number
+  'C' <name no.> <case no.> <result> <elapsed> <processor> <page faults>
+
+"<name no.>" counts 'N' records from 0 within the block, "<result>" is a "TestResult" value,
+"<time>" is from "time()" and the durations are in microseconds.
+*/
+
+// ============================================================================================
+// INCLUDE FILES
+// ============================================================================================
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+
+#ifdef FAT_FILENAMES
+  #include <strstrea.h>
+#else
+  #include <strstream.h>
+#endif
+
+#include <fstream.h>
+
+#ifdef TESTSUITE_POSIX
+  #include <sys/time.h>
+  #include <sys/resource.h>
+#endif
+
+#ifdef FAT_FILENAMES
+  #include "testsuit.h"
+#else
+  #include "testsuite.h"
+#endif
+
+// ============================================================================================
+// STATIC CONSTANTS
+// ============================================================================================
+
+static const char   fileMagic[]     = "TSHIST1\n";   // identifies a history file
+static const long   fileMagicLength = 8L;
+static const char   runTag          = 'R';
+static const char   nameTag         = 'N';
+static const char   caseTag         = 'C';
+static const size_t headerLength    = 1024U;         // enough to read a run record
+
+// ============================================================================================
+// RUNBLOCK CLASS DECLARATION
+// ============================================================================================
+
+/*
+This is a run that has been read back from a history file.  It can be built from a whole block
+(so that its test cases can be read) or from just the start of one (to check its run record).
+*/
+
+class RunBlock
+{
+  public:
+                            RunBlock(char *const, const unsigned long int);
+                            ~RunBlock()
+                              {delete[] _data; delete[] _names; return;}
+
+    const bool              valid() const
+                              {return (_firstCase != NULL);}
+    const char *const       runId() const
+                              {return _runId;}
+    const char *const       buildId() const
+                              {return _buildId;}
+    const unsigned long int time() const
+                              {return _time;}
+    void                    rewind();
+    const bool              nextCase(const char*&, unsigned long int&, unsigned long int&,
+                              unsigned long int&);
+
+  private:
+    char *const             _data;          // the block, between the two lengths
+    const char *const       _end;           // the end of "_data"
+    const char*             _firstCase;     // the first record after the run record
+    const char*             _position;      // the next record to read
+    const char*             _runId;
+    const char*             _buildId;
+    unsigned long int       _time;
+    const char**            _names;         // the test names read so far, by name number
+    unsigned long int       _numNames;      // no. of entries in use in "_names"
+    unsigned long int       _namesCapacity; // no. of entries allocated for "_names"
+};
+
+/*
+This is a test case that failed in a run that's being compared against.
+*/
+
+struct FailedCase
+{
+  const char*       testName;               // points into the "RunBlock" it was read from
+  unsigned long int caseNum;
+};
+
+// ============================================================================================
+// STATIC FUNCTION DECLARATIONS
+// ============================================================================================
+
+static void                    putNumber(ostream&, const unsigned long int);
+static void                    putString(ostream&, const char *const);
+static void                    putLength(ostream&, const unsigned long int);
+static const bool              getNumber(const char*&, const char *const, unsigned long int&);
+static const bool              getString(const char*&, const char *const, const char*&);
+static const unsigned long int toMicroseconds(const double);
+static const unsigned long int pageFaults();
+static const bool              previousBlock(istream&, long&, long&, unsigned long int&);
+static RunBlock *const         readBlock(istream&, const long, const unsigned long int);
+static RunBlock *const         readRun(istream&, long&, const char *const = NULL);
+static int                     compareDoubles(const void*, const void*);
+static int                     compareFailedCases(const void*, const void*);
+
+// ============================================================================================
+// METHOD DEFINITIONS FOR TESTSUITE::HISTORY
+// ============================================================================================
+
+/*********************************************************************************************/
+
+TestSuite::History::History
+(
+  const char *const fileName           // the file that the history is stored in
+):
+
+/*
+This is the constructor for class "TestSuite::History".  The file doesn't have to exist yet --
+it's created the first time a run is written to it.
+
+PRECONDITIONS:
+"fileName" can't be NULL.
+*/
+
+  _fileName(strcpy(new char[strlen(fileName) + 1U], fileName)),
+  _run(NULL),
+  _relay(NULL),
+  _names(),
+  _caseStartTime(0.0),
+  _caseStartCpuTime(0.0),
+  _caseStartFaults(0UL)
+
+{
+  return;
+}
+
+/*********************************************************************************************/
+
+TestSuite::History::~History()
+
+/*
+This is the destructor for class "TestSuite::History".  A run that was begun but not ended is
+discarded.
+*/
+
+{
+  if (_run != NULL)
+  {
+    delete[] _run->str();
+    delete _run;
+  }
+
+  if (_relay != NULL)
+  {
+    delete[] _relay->str();
+    delete _relay;
+  }
+
+  delete[] (char*)_fileName;
+
+  return;
+}
+
+/*********************************************************************************************/
+
+void TestSuite::History::beginRun
+(
+  const char *const runId,                       // identifies this run
+  const char *const buildId                      // identifies what was built to be tested
+)
+
+/*
+This method starts recording a run.  Test case results are recorded (by a "TestSuite" object
+that was given this object with "setHistory()") until "endRun()" is called.
+
+PRECONDITIONS:
+"runId" and "buildId" can't be NULL, and a run can't already be being recorded.
+*/
+
+{
+  assert(runId != NULL);
+  assert(buildId != NULL);
+  assert(_run == NULL);
+
+  _run = new ostrstream;
+  assert(_run != NULL);
+
+  _run->put(runTag);
+  putNumber(*_run, (unsigned long int)::time(NULL));
+  putString(*_run, runId);
+  putString(*_run, buildId);
+
+  return;
+}
+
+/*********************************************************************************************/
+
+const bool TestSuite::History::endRun()
+
+/*
+This method stops recording the run that was started by "beginRun()" and appends it to the
+history file.
+
+POSTCONDITIONS:
+True is returned if the run was written to the file.  False is returned if no run was being
+recorded, or if the file couldn't be written or isn't a history file.
+*/
+
+{
+  bool written = false;
+
+  if (_run != NULL)
+  {
+    const unsigned long int length = (unsigned long int)_run->pcount();
+    char *const             block  = _run->str();
+    bool                    isNew  = true;            // does the file need to be started?
+    bool                    isOk   = true;            // is it a history file?
+
+    {
+      ifstream existing(_fileName, ios::in | ios::binary);
+
+      if (existing.good())
+      {
+        char magic[sizeof(fileMagic)] = "";
+
+        existing.read(magic, fileMagicLength);
+        isNew = (existing.gcount() == 0);
+        isOk  = isNew || (strncmp(magic, fileMagic, (size_t)fileMagicLength) == 0);
+      }
+    }
+
+    if (isOk)
+    {
+      ofstream file(_fileName, ios::out | ios::app | ios::binary);
+
+      if (isNew)
+        file.write(fileMagic, fileMagicLength);
+
+      putLength(file, length);
+      file.write(block, (long)length);
+      putLength(file, length);
+      file.flush();
+
+      written = file.good();
+    }
+
+    delete[] block;
+    delete _run;
+    _run = NULL;
+    _names.clear();
+  }
+
+  return written;
+}
+
+/*********************************************************************************************/
+
+void TestSuite::History::startCase()
+
+/*
+This method notes the time and resources used so far, just before a test case is applied.
+*/
+
+{
+  if (_run != NULL)
+  {
+    _caseStartFaults  = pageFaults();
+    _caseStartCpuTime = (double)clock() / (double)CLOCKS_PER_SEC;
+    _caseStartTime    = TestSuite::timeStamp();
+  }
+
+  return;
+}
+
+/*********************************************************************************************/
+
+void TestSuite::History::endCase
+(
+  const char *const      testName,
+  const unsigned int     caseNum,
+  const Test::TestResult result
+)
+
+/*
+This method records the result of a test case that was just applied, along with the time and
+resources used since "startCase()" was called.  If "startRelay()" has been called then the
+record is kept for "endRelay()" instead.
+*/
+
+{
+  assert(testName != NULL);
+
+  if (_run != NULL)
+  {
+    const double            endTime    = TestSuite::timeStamp();
+    const double            endCpuTime = (double)clock() / (double)CLOCKS_PER_SEC;
+    const unsigned long int endFaults  = pageFaults();
+
+    if (_relay == NULL)
+    {
+      const unsigned long int name = nameIndex(testName);
+
+      _run->put(caseTag);
+      putNumber(*_run, name);
+    }
+
+    ostream& records = (_relay != NULL ? (ostream&)*_relay : (ostream&)*_run);
+
+    putNumber(records, caseNum);
+    putNumber(records, (unsigned long int)result);
+    putNumber(records, toMicroseconds(endTime - _caseStartTime));
+    putNumber(records, toMicroseconds(endCpuTime - _caseStartCpuTime));
+    putNumber(records, endFaults - _caseStartFaults);
+  }
+
+  return;
+}
+
+/*********************************************************************************************/
+
+void TestSuite::History::startRelay()
+
+/*
+This method makes "endCase()" keep the records of the test cases that follow (all of which
+must be for the same test) until "endRelay()" is called, rather than adding them to the run.
+It's used by worker processes (see "parallel.cpp"), which apply a chunk of one test's test
+cases and send the records back to be added, in order, by "addRelayed()".
+
+PRECONDITIONS:
+The records of earlier test cases can't be being kept.
+*/
+
+{
+  assert(_relay == NULL);
+
+  if (_run != NULL)
+  {
+    _relay = new ostrstream;
+    assert(_relay != NULL);
+  }
+
+  return;
+}
+
+/*********************************************************************************************/
+
+char *const TestSuite::History::endRelay
+(
+  unsigned long int& length                  // where the no. of characters is returned
+)
+
+/*
+This method returns the records kept since "startRelay()" was called and stops keeping them.
+It is the caller's responsibility to eventually de-allocate them.  NULL is returned if no run
+is being recorded.
+*/
+
+{
+  char* records = NULL;
+
+  length = 0UL;
+
+  if (_relay != NULL)
+  {
+    length  = (unsigned long int)_relay->pcount();
+    records = _relay->str();
+
+    delete _relay;
+    _relay = NULL;
+  }
+
+  return records;
+}
+
+/*********************************************************************************************/
+
+void TestSuite::History::addRelayed
+(
+  const char *const       testName,          // the test that the test cases were applied to
+  const char *const       records,           // the records from "endRelay()"
+  const unsigned long int length             // the no. of characters in "records"
+)
+
+/*
+This method adds the records of test cases that were kept by "startRelay()" and "endRelay()"
+(usually in another process) to the run being recorded, as though "endCase()" had been called
+for each of them here.
+*/
+
+{
+  assert(testName != NULL);
+  assert((records != NULL) || (length == 0UL));
+
+  if ((_run != NULL) && (length > 0UL))
+  {
+    const unsigned long int name     = nameIndex(testName);
+    const char *const       end      = records + length;
+    const char*             position = records;
+    unsigned long int       values[5];
+    bool                    ok       = true;
+
+    while (ok && (position < end))
+    {
+      for (unsigned int i = 0U; ok && (i < 5U); ++i)
+        ok = getNumber(position, end, values[i]);
+
+      if (ok)
+      {
+        _run->put(caseTag);
+        putNumber(*_run, name);
+
+        for (unsigned int i = 0U; i < 5U; ++i)
+          putNumber(*_run, values[i]);
+      }
+    }
+  }
+
+  return;
+}
+
+/*********************************************************************************************/
+
+const unsigned int TestSuite::History::durations
+(
+  const char *const  testName,            // the test to look up
+  const unsigned int maxRuns,             // the most runs to look back over
+  double *const      durations            // where the durations are returned
+)
+const
+
+/*
+This method finds the most recent runs (up to "maxRuns" of them) in which "testName" was
+performed and puts the total elapsed time, in seconds, of its test cases in each of those runs
+into "durations", the most recent run first.
+
+PRECONDITIONS:
+"testName" can't be NULL and "durations" must have room for "maxRuns" entries.
+
+POSTCONDITIONS:
+The number of entries put into "durations" is returned.
+*/
+
+{
+  assert(testName != NULL);
+  assert((maxRuns == 0U) || (durations != NULL));
+
+  ifstream     file(_fileName, ios::in | ios::binary);
+  unsigned int numRuns = 0U;                                  // no. of entries in durations
+
+  file.seekg(0, ios::end);
+
+  long      position = (long)file.tellg();                   // end of the next run to read
+  RunBlock* run      = NULL;
+
+  while ((numRuns < maxRuns) && ((run = readRun(file, position)) != NULL))
+  {
+    const char*       name;
+    unsigned long int caseNum;
+    unsigned long int result;
+    unsigned long int elapsed;
+    unsigned long int total = 0UL;                      // microseconds spent on testName
+    bool              found = false;                    // was testName performed in the run?
+
+    while (run->nextCase(name, caseNum, result, elapsed))
+    {
+      if (strcmp(name, testName) == 0)
+      {
+        found  = true;
+        total += elapsed;
+      }
+    }
+
+    if (found)
+      durations[numRuns++] = (double)total / 1.0e6;
+
+    delete run;
+  }
+
+  return numRuns;
+}
+
+/*********************************************************************************************/
+
+const bool TestSuite::History::percentile
+(
+  const char *const  testName,            // the test to look up
+  const unsigned int numRuns,             // how many of the most recent runs to look at
+  const double       percent,             // which percentile (e.g. 50.0 for the median)
+  double&            duration             // where the duration, in seconds, is returned
+)
+const
+
+/*
+This method finds the given percentile of the total elapsed time of "testName" over the most
+recent "numRuns" runs in which it was performed (e.g. "p50 duration of test X over the last 30
+runs").  The nearest-rank method is used, so the result is always an actual duration.
+
+PRECONDITIONS:
+"testName" can't be NULL, "numRuns" can't be 0U and "percent" must be from 0.0 to 100.0.
+
+POSTCONDITIONS:
+True is returned and "duration" is set if "testName" was performed in at least one run;
+otherwise, false is returned.
+*/
+
+{
+  assert(testName != NULL);
+  assert(numRuns > 0U);
+  assert((percent >= 0.0) && (percent <= 100.0));
+
+  ifstream          file(_fileName, ios::in | ios::binary);
+  unsigned int      numStored = 0U;            // no. of runs in the file, up to "numRuns"
+  long              start;
+  unsigned long int length;
+
+  file.seekg(0, ios::end);
+
+  long position = (long)file.tellg();                        // end of the next run to count
+
+  /*
+  "numRuns" can be far more than there are runs, so it's capped at the number in the file
+  (counted from their lengths alone) before room is allocated for their durations.
+  */
+
+  while ((numStored < numRuns) && previousBlock(file, position, start, length))
+    ++numStored;
+
+  double *const      found    = new double[numStored + 1U];    // durations from each run
+  const unsigned int numFound = durations(testName, numStored, found);
+
+  if (numFound > 0U)
+  {
+    unsigned int rank = (unsigned int)(percent / 100.0 * numFound + 0.999999);
+
+    if (rank > 0U)
+      --rank;
+
+    qsort(found, numFound, sizeof(double), compareDoubles);
+    duration = found[rank < numFound ? rank : numFound - 1U];
+  }
+
+  delete[] found;
+  return (numFound > 0U);
+}
+
+/*********************************************************************************************/
+
+const unsigned long int TestSuite::History::newFailures
+(
+  const char *const buildId,              // the build to compare the latest run against
+  ostream&          report                // where the test cases are listed
+)
+const
+
+/*
+This method lists the test cases that failed in the latest run but didn't fail in the latest
+run of build "buildId" (i.e. the test cases that "started failing since build Y").  Each is
+listed on its own line as "<test name>[<test case no.>]".
+
+PRECONDITIONS:
+"buildId" can't be NULL.
+
+POSTCONDITIONS:
+The number of test cases listed is returned.  If there's no run of "buildId" then nothing is
+listed.
+*/
+
+{
+  assert(buildId != NULL);
+
+  ifstream          file(_fileName, ios::in | ios::binary);
+  unsigned long int numListed = 0UL;
+
+  file.seekg(0, ios::end);
+
+  long            position = (long)file.tellg();             // end of the next run to read
+  RunBlock *const latest   = readRun(file, position);
+  RunBlock *const baseline = (latest == NULL ? NULL :
+                               (strcmp(latest->buildId(), buildId) == 0 ? NULL :
+                               readRun(file, position, buildId)));
+
+  if (baseline != NULL)
+  {
+    const char*       name;
+    unsigned long int caseNum;
+    unsigned long int result;
+    unsigned long int elapsed;
+    unsigned long int numFailed = 0UL;                // no. of failures in the baseline run
+
+    /*
+    The baseline run's failures are sorted once so that each failure in the latest run can be
+    looked up by a binary search rather than by re-reading the whole baseline run.
+    */
+
+    while (baseline->nextCase(name, caseNum, result, elapsed))
+    {
+      if (result != (unsigned long int)Test::pass)
+        ++numFailed;
+    }
+
+    FailedCase *const failed = new FailedCase[numFailed + 1UL];
+    unsigned long int index  = 0UL;
+
+    assert(failed != NULL);
+    baseline->rewind();
+
+    while ((index < numFailed) && baseline->nextCase(name, caseNum, result, elapsed))
+    {
+      if (result != (unsigned long int)Test::pass)
+      {
+        failed[index].testName = name;
+        failed[index].caseNum  = caseNum;
+        ++index;
+      }
+    }
+
+    qsort(failed, numFailed, sizeof(FailedCase), compareFailedCases);
+
+    while (latest->nextCase(name, caseNum, result, elapsed))
+    {
+      if (result != (unsigned long int)Test::pass)
+      {
+        FailedCase key;                                 // what to look for in "failed"
+
+        key.testName = name;
+        key.caseNum  = caseNum;
+
+        if (bsearch(&key, failed, numFailed, sizeof(FailedCase), compareFailedCases) == NULL)
+        {
+          report << name << "[" << caseNum << "]" << endl;
+          ++numListed;
+        }
+      }
+    }
+
+    delete[] failed;
+  }
+
+  delete latest;
+  delete baseline;
+
+  return numListed;
+}
+
+/*********************************************************************************************/
+
+const unsigned long int TestSuite::History::listRuns
+(
+  ostream& report                         // where the runs are listed
+)
+const
+
+/*
+This method lists every run in the history, the most recent first, one per line:  the run id,
+the build id, when it was run, the number of test cases and the number that failed.
+
+POSTCONDITIONS:
+The number of runs listed is returned.
+*/
+
+{
+  ifstream          file(_fileName, ios::in | ios::binary);
+  unsigned long int numRuns = 0UL;
+
+  file.seekg(0, ios::end);
+
+  long      position = (long)file.tellg();                   // end of the next run to read
+  RunBlock* run      = NULL;
+
+  while ((run = readRun(file, position)) != NULL)
+  {
+    const time_t      when     = (time_t)run->time();
+    char              whenText[32];
+    const char*       name;
+    unsigned long int caseNum;
+    unsigned long int result;
+    unsigned long int elapsed;
+    unsigned long int numCases  = 0UL;
+    unsigned long int numFailed = 0UL;
+
+    strftime(whenText, sizeof(whenText), "%Y-%m-%d %H:%M:%S", localtime(&when));
+
+    while (run->nextCase(name, caseNum, result, elapsed))
+    {
+      ++numCases;
+
+      if (result != (unsigned long int)Test::pass)
+        ++numFailed;
+    }
+
+    report << run->runId() << "  " << run->buildId() << "  " << whenText << "  " <<
+      numFailed << " of " << numCases << " test cases failed" << endl;
+
+    ++numRuns;
+    delete run;
+  }
+
+  return numRuns;
+}
+
+/*********************************************************************************************/
+
+void TestSuite::History::failureCounts
+(
+  const char *const *const testNames,     // the tests to look up
+  const unsigned long int  numNames,      // the number of entries in "testNames"
+  const unsigned int       numRuns,       // how many of the most recent runs to look at
+  unsigned long int *const counts         // where the numbers of failures are returned
+)
+const
+
+/*
+This method counts the failed test cases of each of "testNames" in the most recent "numRuns"
+runs, in a single pass through those runs.  It's what "TestSuite::setFailuresFirst()" orders
+sections by.  A name can appear in "testNames" more than once; each entry gets the same count.
+
+PRECONDITIONS:
+"testNames" and "counts" must have "numNames" entries.
+
+POSTCONDITIONS:
+"counts[i]" is the number of failed test cases of "testNames[i]".
+*/
+
+{
+  assert((numNames == 0UL) || ((testNames != NULL) && (counts != NULL)));
+
+  for (unsigned long int i = 0UL; i < numNames; ++i)
+    counts[i] = 0UL;
+
+  ifstream file(_fileName, ios::in | ios::binary);
+
+  file.seekg(0, ios::end);
+
+  long         position = (long)file.tellg();                // end of the next run to read
+  RunBlock*    run      = NULL;
+  unsigned int numRead  = 0U;                                // no. of runs read so far
+
+  while ((numRead < numRuns) && ((run = readRun(file, position)) != NULL))
+  {
+    const char*       name;
+    const char*       lastName   = NULL;       // the test of the last failed test cases found
+    unsigned long int numPending = 0UL;        // how many of them haven't been counted yet
+    unsigned long int caseNum;
+    unsigned long int result;
+    unsigned long int elapsed;
+    bool              more       = true;       // are there more test cases in the run?
+
+    /*
+    A test's failures tend to come together, and all of a test's test cases share one name
+    string within a run, so failures are gathered up until the name pointer changes and then
+    added to the matching entries of "testNames" all at once.
+    */
+
+    while (more)
+    {
+      more = run->nextCase(name, caseNum, result, elapsed);
+
+      if ((numPending > 0UL) && (!more || ((result != (unsigned long int)Test::pass) &&
+        (name != lastName))))
+      {
+        for (unsigned long int i = 0UL; i < numNames; ++i)
+        {
+          if (strcmp(testNames[i], lastName) == 0)
+            counts[i] += numPending;
+        }
+
+        numPending = 0UL;
+      }
+
+      if (more && (result != (unsigned long int)Test::pass))
+      {
+        lastName = name;
+        ++numPending;
+      }
+    }
+
+    ++numRead;
+    delete run;
+  }
+
+  return;
+}
+
+/*********************************************************************************************/
+
+const unsigned long int TestSuite::History::nameIndex
+(
+  const char *const testName
+)
+
+/*
+This method returns the name number of "testName" in the run being recorded, writing a name
+record to the run first if it hasn't been recorded yet.
+*/
+
+{
+  assert(testName != NULL);
+  assert(_run != NULL);
+
+  const unsigned long int numNames = _names.numNames();
+  const unsigned long int name     = _names.number(testName);
+
+  if (name == numNames)
+  {
+    _run->put(nameTag);
+    putString(*_run, testName);
+  }
+
+  return name;
+}
+
+// ============================================================================================
+// METHOD DEFINITIONS FOR RUNBLOCK
+// ============================================================================================
+
+/*********************************************************************************************/
+
+RunBlock::RunBlock
+(
+  char *const             data,         // the block (or the start of it); this object owns it
+  const unsigned long int length        // the number of bytes in "data"
+):
+
+  _data(data),
+  _end(data + length),
+  _firstCase(NULL),
+  _position(NULL),
+  _runId(NULL),
+  _buildId(NULL),
+  _time(0UL),
+  _names(NULL),
+  _numNames(0UL),
+  _namesCapacity(0UL)
+
+{
+  assert(data != NULL);
+
+  const char* position = _data;
+
+  if ((position < _end) && (*position++ == runTag) && getNumber(position, _end, _time) &&
+    getString(position, _end, _runId) && getString(position, _end, _buildId))
+  {
+    _firstCase = position;
+    _position  = position;
+  }
+
+  return;
+}
+
+/*********************************************************************************************/
+
+void RunBlock::rewind()
+
+/*
+This method starts reading the test cases from the beginning again.  The names are read again,
+too, since they're numbered from the start of the block.
+*/
+
+{
+  _position = _firstCase;
+  _numNames = 0UL;
+  return;
+}
+
+/*********************************************************************************************/
+
+const bool RunBlock::nextCase
+(
+  const char*&       testName,
+  unsigned long int& caseNum,
+  unsigned long int& result,
+  unsigned long int& elapsed
+)
+
+/*
+This method reads the next case record, reading any name records before it, and returns false
+if there are no more (or the block is damaged).
+*/
+
+{
+  bool found = false;
+  bool ok    = valid();
+
+  while (ok && !found && (_position < _end))
+  {
+    const char tag = *_position++;
+
+    if (tag == nameTag)
+    {
+      const char* name = NULL;
+
+      ok = getString(_position, _end, name);
+
+      if (ok && (_numNames == _namesCapacity))
+      {
+        const unsigned long int newCapacity = (_namesCapacity == 0UL ? 64UL :
+                                                _namesCapacity * 2UL);
+        const char** const      newNames    = new const char*[newCapacity];
+
+        assert(newNames != NULL);
+
+        for (unsigned long int i = 0UL; i < _numNames; ++i)
+          newNames[i] = _names[i];
+
+        delete[] _names;
+        _names         = newNames;
+        _namesCapacity = newCapacity;
+      }
+
+      if (ok)
+        _names[_numNames++] = name;
+    }
+    else if (tag == caseTag)
+    {
+      unsigned long int name;
+      unsigned long int cpuTime;
+      unsigned long int faults;
+
+      ok = getNumber(_position, _end, name) && (name < _numNames) &&
+        getNumber(_position, _end, caseNum) && getNumber(_position, _end, result) &&
+        getNumber(_position, _end, elapsed) && getNumber(_position, _end, cpuTime) &&
+        getNumber(_position, _end, faults);
+
+      if (ok)
+      {
+        testName = _names[name];
+        found    = true;
+      }
+    }
+    else
+      ok = false;
+  }
+
+  return found;
+}
+
+// ============================================================================================
+// STATIC FUNCTION DEFINITIONS
+// ============================================================================================
+
+/*********************************************************************************************/
+
+static void putNumber
+(
+  ostream&                stream,
+  const unsigned long int number
+)
+
+{
+  unsigned long int remaining = number;
+
+  while (remaining >= 0x80UL)
+  {
+    stream.put((char)((remaining & 0x7FUL) | 0x80UL));
+    remaining >>= 7;
+  }
+
+  stream.put((char)remaining);
+  return;
+}
+
+/*********************************************************************************************/
+
+static void putString
+(
+  ostream&          stream,
+  const char *const text
+)
+
+{
+  assert(text != NULL);
+
+  stream.write(text, (long)strlen(text) + 1L);
+  return;
+}
+
+/*********************************************************************************************/
+
+static void putLength
+(
+  ostream&                stream,
+  const unsigned long int length
+)
+
+{
+  for (unsigned int i = 0U; i < 4U; ++i)
+    stream.put((char)((length >> (8U * i)) & 0xFFUL));
+
+  return;
+}
+
+/*********************************************************************************************/
+
+static const bool getNumber
+(
+  const char*&       position,
+  const char *const  end,
+  unsigned long int& number
+)
+
+{
+  unsigned int shift = 0U;
+  bool         more  = true;
+
+  number = 0UL;
+
+  while (more && (position < end) && (shift < sizeof(number) * 8U))
+  {
+    const unsigned char byte = (unsigned char)*position++;
+
+    number |= (unsigned long int)(byte & 0x7FU) << shift;
+    shift  += 7U;
+    more    = ((byte & 0x80U) != 0U);
+  }
+
+  return !more;
+}
+
+/*********************************************************************************************/
+
+static const bool getString
+(
+  const char*&      position,
+  const char *const end,
+  const char*&      text
+)
+
+{
+  const char *const terminator = (const char*)memchr(position, '\0', (size_t)(end - position));
+
+  if (terminator != NULL)
+  {
+    text     = position;
+    position = terminator + 1;
+  }
+
+  return (terminator != NULL);
+}
+
+/*********************************************************************************************/
+
+static const unsigned long int toMicroseconds
+(
+  const double seconds
+)
+
+{
+  return (seconds <= 0.0 ? 0UL : (unsigned long int)(seconds * 1.0e6 + 0.5));
+}
+
+/*********************************************************************************************/
+
+static const unsigned long int pageFaults()
+{
+  #ifdef TESTSUITE_POSIX
+    rusage usage;
+
+    getrusage(RUSAGE_SELF, &usage);
+    return (unsigned long int)(usage.ru_minflt + usage.ru_majflt);
+  #else
+    return 0UL;
+  #endif
+}
+
+/*********************************************************************************************/
+
+static const bool previousBlock
+(
+  istream&           file,
+  long&              position,    // the end of the block to find; updated to its start
+  long&              start,       // where the block's contents start
+  unsigned long int& length       // the length of the block's contents
+)
+
+/*
+This function finds the block that ends at "position" by reading the length that precedes
+"position" and checking it against the length at the start of the block.
+*/
+
+{
+  bool          found = false;
+  unsigned char bytes[4];
+
+  if (position >= fileMagicLength + 8L)
+  {
+    file.clear();
+    file.seekg(position - 4L);
+    file.read((char*)bytes, 4);
+
+    length = (unsigned long int)bytes[0] | ((unsigned long int)bytes[1] << 8) |
+      ((unsigned long int)bytes[2] << 16) | ((unsigned long int)bytes[3] << 24);
+    start  = position - 4L - (long)length;
+
+    if (file.good() && (start >= fileMagicLength + 4L))
+    {
+      file.seekg(start - 4L);
+      file.read((char*)bytes, 4);
+
+      found = file.good() && (length == ((unsigned long int)bytes[0] |
+        ((unsigned long int)bytes[1] << 8) | ((unsigned long int)bytes[2] << 16) |
+        ((unsigned long int)bytes[3] << 24)));
+    }
+  }
+
+  if (found)
+    position = start - 4L;
+
+  return found;
+}
+
+/*********************************************************************************************/
+
+static RunBlock *const readBlock
+(
+  istream&                file,
+  const long              start,
+  const unsigned long int length
+)
+
+{
+  char *const data = new char[length > 0UL ? length : 1UL];
+
+  assert(data != NULL);
+
+  file.clear();
+  file.seekg(start);
+  file.read(data, (long)length);
+
+  RunBlock *const run = new RunBlock(data, (unsigned long int)file.gcount());
+
+  assert(run != NULL);
+  return run;
+}
+
+/*********************************************************************************************/
+
+static RunBlock *const readRun
+(
+  istream&          file,
+  long&             position,             // the end of the run to read; updated to its start
+  const char *const buildId               // if not NULL, skip runs of other builds
+)
+
+/*
+This function reads the run that ends at "position" -- or, if "buildId" isn't NULL, the latest
+run of "buildId" that ends at or before "position".  The run records of other runs are read to
+check their build ids, but their test cases aren't.  NULL is returned if there's no such run.
+*/
+
+{
+  RunBlock*         run = NULL;
+  long              start;
+  unsigned long int length;
+
+  while ((run == NULL) && previousBlock(file, position, start, length))
+  {
+    if (buildId != NULL)
+    {
+      RunBlock *const header = readBlock(file, start,
+                                 length < headerLength ? length : headerLength);
+      const bool      skip   = header->valid() && (strcmp(header->buildId(), buildId) != 0);
+
+      delete header;
+
+      if (!skip)
+        run = readBlock(file, start, length);
+    }
+    else
+      run = readBlock(file, start, length);
+
+    if ((run != NULL) && ((!run->valid()) ||
+      ((buildId != NULL) && (strcmp(run->buildId(), buildId) != 0))))
+    {
+      delete run;
+      run = NULL;
+    }
+  }
+
+  return run;
+}
+
+/*********************************************************************************************/
+
+static int compareDoubles
+(
+  const void* first,
+  const void* second
+)
+
+{
+  const double a = *(const double*)first;
+  const double b = *(const double*)second;
+
+  return (a < b ? -1 : (a > b ? 1 : 0));
+}
+
+/*********************************************************************************************/
+
+static int compareFailedCases
+(
+  const void* first,
+  const void* second
+)
+
+{
+  const FailedCase *const a     = (const FailedCase*)first;
+  const FailedCase *const b     = (const FailedCase*)second;
+  const int               names = strcmp(a->testName, b->testName);
+
+  return (names != 0 ? names : (a->caseNum < b->caseNum ? -1 :
+    (a->caseNum > b->caseNum ? 1 : 0)));
+}
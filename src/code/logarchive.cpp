@@ -0,0 +1,1264 @@
+// ============================================================================================
+//
+// SOURCE FILE:  logarchive.cpp
+//
+// ============================================================================================
+
+// ============================================================================================
+// DESCRIPTION
+// ============================================================================================
+
+/*
+This file implements "TestSuite::LogArchive", a stream buffer that compresses a "TestSuite"
+object's log into a file as it's written and indexes it by test name and test case number, and
+"TestSuite::LogReader", which gets any test's (or test case's) part of the log back out without
+decompressing the rest:
+
+  TestSuite::LogArchive archive("nightly.tsl");
+  ostream               log(&archive);
+  TestSuite             test(testData, log);
+
+  test.setLogArchive(&archive);             // so that it's told where each test case starts
+  test.all();
+  archive.close();                          // writes the index
+
+  TestSuite::LogReader reader("nightly.tsl");
+
+  reader.extractTest(cout, "parseDate");    // or reader.extractCase(cout, "parseDate", 12U)
+
+"testlog" (see "testlog.cpp") does the same from the command line.
+
+The log is compressed in blocks of 256 KiB (by default) of text, each one on its own, so any
+part of the log can be reached by decompressing only the blocks it's in.  The compression is a
+simple LZ77 scheme (in the style of LZ4) that's implemented here, so nothing else has to be
+linked in; it's fast, and test logs are repetitive enough that it usually shrinks them several
+times over.  A block that wouldn't get smaller is stored as it is.
+
+The index has an entry for each test header and footer (test case number 0) and for each test
+case that logged something, giving where its text starts; its text ends where the next entry's
+starts.  The test cases of a section that's performed by worker processes (see "setWorkers()")
+aren't indexed separately, so their text is only found as part of the test's.
+
+Blocks are written when they're full and by "close()".  Since a block that's written early
+compresses worse, flushing the log stream ("flush()" or "endl") only writes the current block
+if it's at least a quarter full or no block has been written for a second; otherwise it costs
+next to nothing.  "flushBlock()" writes it however little is in it, and "TestSuite" calls it
+after logging that a test was aborted.  So as long as the log is flushed now and then, a crash
+loses no more than about a second's worth of it.  The index is written by "close()" (or the
+destructor).  "LogReader" can still get the text out of an archive that wasn't closed, by
+reading the block headers one after another, but it can't find tests in it ("indexed()"
+returns "false").
+*/
+
+// ============================================================================================
+// FORMAT OF THE ARCHIVE FILE
+// ============================================================================================
+
+/*
+The file starts with the 8 characters "TSLOG01\n", followed by the blocks and then the index:
+
+  <block>...  <index>  <index offset>  "TSLOGIX\n"
+
+Numbers are unsigned and written 7 bits per byte, least significant first, with the high bit set
+on every byte but the last, except for "<index offset>", which is where "<index>" starts in the
+file as an 8-byte little-endian integer.  Strings are written with a terminating '\0'.
+
+  <block>  =  <stored length * 2 + 1 if stored as it is> <text length> <stored bytes>
+  <index>  =  <most text in a block> <total text length>
+              <no. of blocks> { <block offset> <text length> }...
+              <no. of names> <test name>...
+              <no. of entries> { <name no.> <test case no.> <text start - previous start> }...
+
+The compressed form of a block is a series of sequences, each of which is a token byte (the
+high 4 bits are the number of literal bytes and the low 4 bits are the match length minus 4,
+either of which is followed by more bytes if it's 15, each adding up to 255), the literal bytes,
+and (except at the end of the block) a 2-byte little-endian offset back to the match.
+*/
+
+// ============================================================================================
+// INCLUDE FILES
+// ============================================================================================
+
+#include <string.h>
+#include <fstream.h>
+
+#ifdef FAT_FILENAMES
+  #include "testsuit.h"
+#else
+  #include "testsuite.h"
+#endif
+
+// ============================================================================================
+// STATIC CONSTANTS
+// ============================================================================================
+
+static const char              fileMagic[]  = "TSLOG01\n";   // starts an archive file
+static const char              indexMagic[] = "TSLOGIX\n";   // ends an archive's index
+static const long              magicLength  = 8L;
+static const unsigned long int minMatch     = 4UL;           // the shortest match encoded
+static const unsigned long int maxOffset    = 65535UL;       // the furthest back a match goes
+static const unsigned int      hashBits     = 14U;           // size of the match finder table
+static const unsigned long int syncFraction = 4UL;           // 1 / how full "sync()" writes at
+static const double            syncInterval = 1.0;           // seconds before "sync()" writes
+
+// ============================================================================================
+// STATIC FUNCTION DECLARATIONS
+// ============================================================================================
+
+static const unsigned long int packedSize(const unsigned long int);
+static const unsigned long int pack(const char *const, const unsigned long int, char *const);
+static const bool              unpack(const char *const, const unsigned long int, char *const,
+                                 const unsigned long int);
+static char*                   putLength(char*, const unsigned long int);
+static const bool              getLength(const char*&, const char *const, unsigned long int&);
+static const unsigned long int putNumber(ostream&, const unsigned long int);
+static const bool              getNumber(const char*&, const char *const, unsigned long int&);
+static const bool              getNumber(istream&, unsigned long int&);
+
+// ============================================================================================
+// PUBLIC METHOD DEFINITIONS FOR TESTSUITE CLASS
+// ============================================================================================
+
+/*********************************************************************************************/
+
+void TestSuite::setLogArchive
+(
+  LogArchive *const archive     // where the log is written (or NULL)
+)
+
+/*
+This method makes this object tell "archive" where each test and test case starts in the log,
+so that it can be indexed (or stop telling it, if "archive" is NULL).  See "logarchive.cpp".
+
+PRECONDITIONS:
+"archive" must be the stream buffer of the log stream that was given to the constructor.
+
+POSTCONDITIONS:
+"archive" will be told about every test and test case whose results are logged.
+*/
+
+{
+  assertInvariants();
+  assert((archive == NULL) || (_log->rdbuf() == archive));
+
+  _logArchive = archive;
+
+  assertInvariants();
+  return;
+}
+
+// ============================================================================================
+// METHOD DEFINITIONS FOR TESTSUITE::LOGARCHIVE CLASS
+// ============================================================================================
+
+/*********************************************************************************************/
+
+TestSuite::LogArchive::LogArchive
+(
+  const char *const       fileName,     // the file to write the archive to
+  const unsigned long int blockSize     // how much text to compress in each block
+):
+
+/*
+This is the constructor for class "LogArchive".  It creates (or replaces) the file "fileName";
+"good()" says whether it could.
+*/
+
+  _file(new ofstream(fileName, ios::out | ios::binary)),
+  _blockSize(blockSize),
+  _block(new char[blockSize]),
+  _packed(new char[packedSize(blockSize)]),
+  _position(0UL),
+  _fileOffset((unsigned long int)magicLength),
+  _numBlocks(0UL),
+  _numEntries(0UL),
+  _names(),
+  _pending(false),
+  _pendingName(0UL),
+  _pendingCase(0U),
+  _pendingPosition(0UL),
+  _lastPosition(0UL),
+  _lastWrite(TestSuite::timeStamp())
+
+{
+  assert(fileName != NULL);
+  assert(blockSize > 0UL);
+
+  _file->write(fileMagic, magicLength);
+  setp(_block, _block + blockSize);
+
+  return;
+}
+
+/*********************************************************************************************/
+
+TestSuite::LogArchive::~LogArchive()
+
+/*
+This is the destructor for class "LogArchive".  It closes the archive if "close()" hasn't been
+called.
+*/
+
+{
+  close();
+
+  delete[] _packed;
+  delete[] _block;
+
+  return;
+}
+
+/*********************************************************************************************/
+
+const bool TestSuite::LogArchive::good() const
+
+/*
+This method returns "true" if the archive is open and nothing has failed to be written to it.
+*/
+
+{
+  return ((_file != NULL) && _file->good());
+}
+
+/*********************************************************************************************/
+
+void TestSuite::LogArchive::mark
+(
+  const char *const  testName,          // the test whose text starts here
+  const unsigned int caseNum            // the test case (or 0U for the header or footer)
+)
+
+/*
+This method notes that the text written from now on belongs to test case "caseNum" of the test
+named "testName".  If nothing has been written since the last mark then the last mark is
+replaced, so test cases that don't log anything don't take up space in the index.
+*/
+
+{
+  assert(testName != NULL);
+
+  const unsigned long int position = _position + (unsigned long int)(pptr() - pbase());
+
+  if (_pending && (position != _pendingPosition))
+    writeEntry();
+
+  _pending         = true;
+  _pendingName     = _names.number(testName);
+  _pendingCase     = caseNum;
+  _pendingPosition = position;
+
+  return;
+}
+
+/*********************************************************************************************/
+
+void TestSuite::LogArchive::flushBlock()
+
+/*
+This method writes the text in the current block to the file now, however little there is, so
+that it isn't lost if the program crashes.
+*/
+
+{
+  if (_file != NULL)
+  {
+    writeBlock();
+    _file->flush();
+  }
+
+  return;
+}
+
+/*********************************************************************************************/
+
+const bool TestSuite::LogArchive::close()
+
+/*
+This method writes the last block and the index, closes the file and returns "true" if all of
+it was written.  Nothing more can be written after it's called (and calling it again does
+nothing but return "false").
+*/
+
+{
+  bool written = false;
+
+  if (_file != NULL)
+  {
+    writeBlock();
+
+    if (_pending && (_pendingPosition < _position))
+      writeEntry();
+
+    const unsigned long int indexOffset = _fileOffset;      // where the index starts
+    char                    offsetBytes[8];                 // "indexOffset", little-endian
+
+    putNumber(*_file, _blockSize);
+    putNumber(*_file, _position);
+    putNumber(*_file, _numBlocks);
+    _file->write(_seekTable.str(), _seekTable.pcount());
+    _seekTable.rdbuf()->freeze(0);
+    putNumber(*_file, _names.numNames());
+
+    for (unsigned long int i = 0UL; i < _names.numNames(); ++i)
+      _file->write(_names.name(i), (long)strlen(_names.name(i)) + 1L);
+
+    putNumber(*_file, _numEntries);
+    _file->write(_entries.str(), _entries.pcount());
+    _entries.rdbuf()->freeze(0);
+
+    for (unsigned int i = 0U; i < 8U; ++i)
+      offsetBytes[i] = (char)((indexOffset >> (8U * i)) & 0xFFUL);
+
+    _file->write(offsetBytes, 8L);
+    _file->write(indexMagic, magicLength);
+    _file->flush();
+
+    written = _file->good();
+
+    delete _file;
+    _file = NULL;
+    setp(NULL, NULL);
+  }
+
+  return written;
+}
+
+/*********************************************************************************************/
+
+int TestSuite::LogArchive::overflow
+(
+  int character                         // the character that didn't fit (or EOF)
+)
+
+/*
+This method is called when the current block is full.  It compresses and writes the block and
+starts the next one with "character".
+*/
+
+{
+  int status = EOF;
+
+  if (_file != NULL)
+  {
+    writeBlock();
+    status = 0;
+
+    if (character != EOF)
+    {
+      *pptr() = (char)character;
+      pbump(1);
+      status  = character;
+    }
+  }
+
+  return status;
+}
+
+/*********************************************************************************************/
+
+int TestSuite::LogArchive::sync()
+
+/*
+This method is called when the log stream is flushed.  It writes the current block if it's at
+least "1 / syncFraction" full or if the last block was written more than "syncInterval" seconds
+ago.  Otherwise the block is left to fill up, because writing it early would make it compress
+worse.
+*/
+
+{
+  if (_file != NULL)
+  {
+    const unsigned long int length = (unsigned long int)(pptr() - pbase());
+
+    if ((length > 0UL) && ((length >= _blockSize / syncFraction) ||
+      (TestSuite::timeStamp() - _lastWrite >= syncInterval)))
+    {
+      writeBlock();
+      _file->flush();
+    }
+  }
+
+  return (_file != NULL ? 0 : EOF);
+}
+
+/*********************************************************************************************/
+
+void TestSuite::LogArchive::writeBlock()
+
+/*
+This method compresses the text in the current block, writes it to the file (as it is, if it
+didn't get any smaller) and starts a new block.
+*/
+
+{
+  const unsigned long int length = (unsigned long int)(pptr() - pbase());
+
+  if (length > 0UL)
+  {
+    const unsigned long int packedLength = pack(_block, length, _packed);
+    const bool              raw          = (packedLength >= length);
+    const unsigned long int stored       = (raw ? length : packedLength);
+
+    putNumber(_seekTable, _fileOffset);
+    putNumber(_seekTable, length);
+    _fileOffset += putNumber(*_file, stored * 2UL + (raw ? 1UL : 0UL));
+    _fileOffset += putNumber(*_file, length);
+    _file->write(raw ? _block : _packed, (long)stored);
+    _fileOffset += stored;
+    _position   += length;
+    _numBlocks++;
+    _lastWrite   = TestSuite::timeStamp();
+
+    setp(_block, _block + _blockSize);
+  }
+
+  return;
+}
+
+/*********************************************************************************************/
+
+void TestSuite::LogArchive::writeEntry()
+
+/*
+This method adds the pending mark to the index entries.
+*/
+
+{
+  putNumber(_entries, _pendingName);
+  putNumber(_entries, _pendingCase);
+  putNumber(_entries, _pendingPosition - _lastPosition);
+
+  _lastPosition = _pendingPosition;
+  _pending      = false;
+  _numEntries++;
+
+  return;
+}
+
+// ============================================================================================
+// METHOD DEFINITIONS FOR TESTSUITE::LOGREADER CLASS
+// ============================================================================================
+
+/*********************************************************************************************/
+
+TestSuite::LogReader::LogReader
+(
+  const char *const fileName            // the archive to read
+):
+
+/*
+This is the constructor for class "LogReader".  It reads the archive's index (or, if it doesn't
+have one, finds its blocks).  "good()" says whether it could, and "indexed()" says whether it
+read an index.
+*/
+
+  _file(new ifstream(fileName, ios::in | ios::binary)),
+  _indexed(false),
+  _blockSize(0UL),
+  _numBlocks(0UL),
+  _offsets(NULL),
+  _starts(NULL),
+  _nameText(NULL),
+  _names(NULL),
+  _numNames(0UL),
+  _numEntries(0UL),
+  _entryNames(NULL),
+  _entryCases(NULL),
+  _entryPositions(NULL),
+  _block(NULL),
+  _packed(NULL),
+  _loadedBlock(0UL)
+
+{
+  assert(fileName != NULL);
+
+  char magic[8];
+
+  _file->read(magic, magicLength);
+
+  if (!_file->good() || (memcmp(magic, fileMagic, (size_t)magicLength) != 0))
+  {
+    delete _file;
+    _file = NULL;
+  }
+  else
+  {
+    _indexed = readIndex();
+
+    if (!_indexed && !scanBlocks())
+    {
+      delete _file;
+      _file = NULL;
+    }
+  }
+
+  if (_file != NULL)
+  {
+    _block       = new char[_blockSize];
+    _packed      = new char[packedSize(_blockSize)];
+    _loadedBlock = _numBlocks;
+  }
+
+  return;
+}
+
+/*********************************************************************************************/
+
+TestSuite::LogReader::~LogReader()
+
+{
+  delete _file;
+  delete[] _offsets;
+  delete[] _starts;
+  delete[] _nameText;
+  delete[] _names;
+  delete[] _entryNames;
+  delete[] _entryCases;
+  delete[] _entryPositions;
+  delete[] _block;
+  delete[] _packed;
+
+  return;
+}
+
+/*********************************************************************************************/
+
+const unsigned long int TestSuite::LogReader::listTests
+(
+  ostream& stream                       // where to list the tests
+)
+const
+
+/*
+This method lists the tests in the index, in the order in which they were first logged, with
+the number of their test cases that logged something, and returns how many tests there were.
+*/
+
+{
+  unsigned long int *const numCases = new unsigned long int[_numNames + 1UL];
+
+  for (unsigned long int name = 0UL; name < _numNames; ++name)
+    numCases[name] = 0UL;
+
+  for (unsigned long int i = 0UL; i < _numEntries; ++i)
+  {
+    if (_entryCases[i] != 0U)
+      numCases[_entryNames[i]]++;
+  }
+
+  for (unsigned long int name = 0UL; name < _numNames; ++name)
+  {
+    stream << _names[name] << "  (" << numCases[name] << " test case" <<
+      (numCases[name] == 1UL ? "" : "s") << " logged something)" << '\n';
+  }
+
+  delete[] numCases;
+
+  stream.flush();
+  return _numNames;
+}
+
+/*********************************************************************************************/
+
+const bool TestSuite::LogReader::extractAll
+(
+  ostream& stream                       // where to write the log
+)
+
+/*
+This method writes the whole log to "stream" and returns "true" if it could all be read.
+*/
+
+{
+  return ((_file != NULL) && writeText(stream, 0UL, _starts[_numBlocks]));
+}
+
+/*********************************************************************************************/
+
+const bool TestSuite::LogReader::extractTest
+(
+  ostream&          stream,             // where to write the test's text
+  const char *const testName
+)
+
+/*
+This method writes all of the text logged for the test named "testName" (its headers, test
+cases and footers, in order) to "stream" and returns "true", or returns "false" if the test
+isn't in the index or its text couldn't be read.
+*/
+
+{
+  return extract(stream, testName, true, 0U);
+}
+
+/*********************************************************************************************/
+
+const bool TestSuite::LogReader::extractCase
+(
+  ostream&           stream,            // where to write the test case's text
+  const char *const  testName,
+  const unsigned int caseNum
+)
+
+/*
+This method writes the text logged for test case "caseNum" of the test named "testName" to
+"stream" and returns "true", or returns "false" if it isn't in the index (e.g. because it
+didn't log anything) or its text couldn't be read.
+*/
+
+{
+  return extract(stream, testName, false, caseNum);
+}
+
+/*********************************************************************************************/
+
+const bool TestSuite::LogReader::readIndex()
+
+/*
+This method reads the index at the end of the file and returns "true", or returns "false" if
+there's no valid index.
+*/
+
+{
+  char              trailer[16];                // the index offset and "indexMagic"
+  unsigned long int indexOffset = 0UL;
+  unsigned long int fileLength;
+  bool              valid;
+
+  _file->seekg(0, ios::end);
+  fileLength = (unsigned long int)_file->tellg();
+  valid      = (fileLength >= (unsigned long int)(magicLength * 3L));
+
+  if (valid)
+  {
+    _file->seekg(-2L * magicLength, ios::end);
+    _file->read(trailer, 2L * magicLength);
+    valid = _file->good() && (memcmp(trailer + 8, indexMagic, (size_t)magicLength) == 0);
+  }
+
+  for (unsigned int i = 8U; valid && (i > 0U); --i)
+    indexOffset = (indexOffset << 8) | (unsigned char)trailer[i - 1U];
+
+  valid = valid && (indexOffset >= (unsigned long int)magicLength) &&
+    (indexOffset <= fileLength - 2UL * (unsigned long int)magicLength);
+
+  if (valid)
+  {
+    const unsigned long int length = fileLength - 2UL * magicLength - indexOffset;
+    char *const             index  = new char[length + 1UL];
+    const char*             position = index;
+    const char *const       end      = index + length;
+    unsigned long int       totalLength = 0UL;
+    unsigned long int       nameTextLength;
+    unsigned long int       number;
+
+    _file->seekg((long)indexOffset, ios::beg);
+    _file->read(index, (long)length);
+
+    valid = _file->good() && getNumber(position, end, _blockSize) &&
+      getNumber(position, end, totalLength) && getNumber(position, end, _numBlocks) &&
+      (_numBlocks <= length);
+
+    if (valid)
+    {
+      _offsets = new unsigned long int[_numBlocks + 1UL];
+      _starts  = new unsigned long int[_numBlocks + 1UL];
+    }
+
+    if (valid)
+      _starts[0] = 0UL;
+
+    for (unsigned long int i = 0UL; valid && (i < _numBlocks); ++i)
+    {
+      valid = getNumber(position, end, _offsets[i]) && getNumber(position, end, number);
+      _starts[i + 1UL] = _starts[i] + number;
+    }
+
+    valid = valid && getNumber(position, end, _numNames) && (_numNames <= length);
+
+    if (valid)
+    {
+      const char *const nameStart = position;
+
+      for (unsigned long int i = 0UL; valid && (i < _numNames); ++i)
+      {
+        const char *const terminator = (const char*)memchr(position, '\0',
+          (size_t)(end - position));
+
+        valid    = (terminator != NULL);
+        position = (valid ? terminator + 1 : end);
+      }
+
+      nameTextLength = (unsigned long int)(position - nameStart);
+      _nameText      = new char[nameTextLength + 1UL];
+      _names         = new const char*[_numNames + 1UL];
+      memcpy(_nameText, nameStart, nameTextLength);
+
+      for (unsigned long int i = 0UL, start = 0UL; valid && (i < _numNames); ++i)
+      {
+        _names[i] = _nameText + start;
+        start    += strlen(_names[i]) + 1UL;
+      }
+    }
+
+    valid = valid && getNumber(position, end, _numEntries) && (_numEntries <= length);
+
+    if (valid)
+    {
+      _entryNames     = new unsigned long int[_numEntries + 1UL];
+      _entryCases     = new unsigned int[_numEntries + 1UL];
+      _entryPositions = new unsigned long int[_numEntries + 1UL];
+    }
+
+    for (unsigned long int i = 0UL; valid && (i < _numEntries); ++i)
+    {
+      valid = getNumber(position, end, _entryNames[i]) && (_entryNames[i] < _numNames) &&
+        getNumber(position, end, number) && getNumber(position, end, _entryPositions[i]);
+
+      _entryCases[i]      = (unsigned int)number;
+      _entryPositions[i] += (i > 0UL ? _entryPositions[i - 1UL] : 0UL);
+    }
+
+    if (valid)
+      _entryPositions[_numEntries] = totalLength;
+
+    delete[] index;
+
+    valid = valid && (_starts[_numBlocks] == totalLength);
+  }
+
+  if (!valid)
+  {
+    delete[] _offsets;
+    delete[] _starts;
+    delete[] _nameText;
+    delete[] _names;
+    delete[] _entryNames;
+    delete[] _entryCases;
+    delete[] _entryPositions;
+
+    _offsets        = NULL;
+    _starts         = NULL;
+    _nameText       = NULL;
+    _names          = NULL;
+    _entryNames     = NULL;
+    _entryCases     = NULL;
+    _entryPositions = NULL;
+    _numBlocks      = 0UL;
+    _numNames       = 0UL;
+    _numEntries     = 0UL;
+    _blockSize      = 0UL;
+  }
+
+  _file->clear();
+  return valid;
+}
+
+/*********************************************************************************************/
+
+const bool TestSuite::LogReader::scanBlocks()
+
+/*
+This method finds the blocks of an archive that has no index (because it wasn't closed) by
+reading their headers one after another, and returns "true" if there's at least one complete
+block.  The block that was being written when the program stopped is ignored.
+*/
+
+{
+  unsigned long int fileLength;
+  unsigned long int offset   = (unsigned long int)magicLength;  // where the next block starts
+  unsigned long int capacity = 0UL;                             // entries allocated
+  unsigned long int stored;
+  unsigned long int length;
+
+  _file->clear();
+  _file->seekg(0, ios::end);
+  fileLength = (unsigned long int)_file->tellg();
+  _file->seekg((long)offset, ios::beg);
+
+  while (getNumber(*_file, stored) && getNumber(*_file, length) &&
+    ((unsigned long int)_file->tellg() + stored / 2UL <= fileLength))
+  {
+    if (_numBlocks + 1UL >= capacity)
+    {
+      unsigned long int *const offsets = new unsigned long int[capacity * 2UL + 64UL];
+      unsigned long int *const starts  = new unsigned long int[capacity * 2UL + 64UL];
+
+      for (unsigned long int i = 0UL; i < _numBlocks; ++i)
+      {
+        offsets[i]      = _offsets[i];
+        starts[i + 1UL] = _starts[i + 1UL];
+      }
+
+      starts[0] = 0UL;
+
+      delete[] _offsets;
+      delete[] _starts;
+      _offsets = offsets;
+      _starts  = starts;
+      capacity = capacity * 2UL + 64UL;
+    }
+
+    _offsets[_numBlocks]      = offset;
+    _starts[_numBlocks + 1UL] = _starts[_numBlocks] + length;
+    _numBlocks++;
+
+    if (length > _blockSize)
+      _blockSize = length;
+
+    offset = (unsigned long int)_file->tellg() + stored / 2UL;
+    _file->seekg((long)offset, ios::beg);
+  }
+
+  _file->clear();
+  return (_numBlocks > 0UL);
+}
+
+/*********************************************************************************************/
+
+const bool TestSuite::LogReader::extract
+(
+  ostream&           stream,            // where to write the text
+  const char *const  testName,
+  const bool         allCases,          // should all of the test's text be written?
+  const unsigned int caseNum            // if not, which test case's text to write
+)
+
+/*
+This method writes the text of the index entries for "testName" (all of them, or only those
+for "caseNum") to "stream", and returns "true" if there were any and they could be read.
+Entries whose text follows on from each other are written together.
+*/
+
+{
+  assert(testName != NULL);
+
+  unsigned long int name  = 0UL;
+  bool              found = false;
+  bool              ok    = (_file != NULL);
+
+  while ((name < _numNames) && (strcmp(_names[name], testName) != 0))
+    name++;
+
+  for (unsigned long int i = 0UL; ok && (i < _numEntries); ++i)
+  {
+    if ((_entryNames[i] == name) && (allCases || (_entryCases[i] == caseNum)))
+    {
+      ok    = writeText(stream, _entryPositions[i], _entryPositions[i + 1UL]);
+      found = true;
+    }
+  }
+
+  stream.flush();
+  return (ok && found);
+}
+
+/*********************************************************************************************/
+
+const bool TestSuite::LogReader::writeText
+(
+  ostream&                stream,       // where to write the text
+  const unsigned long int start,        // where the text starts in the log
+  const unsigned long int end           // where it ends
+)
+
+/*
+This method writes the log's text from "start" up to "end" to "stream" and returns "true" if
+it could be read.  The blocks it's in are found by binary search.
+*/
+
+{
+  unsigned long int low      = 0UL;             // the first block that could hold "start"
+  unsigned long int high     = _numBlocks;      // one past the last one
+  unsigned long int position = start;           // where the next character comes from
+  bool              ok       = true;
+
+  while (high - low > 1UL)
+  {
+    const unsigned long int middle = low + (high - low) / 2UL;
+
+    if (_starts[middle] <= start)
+      low = middle;
+    else
+      high = middle;
+  }
+
+  for (unsigned long int i = low; ok && (position < end) && (i < _numBlocks); ++i)
+  {
+    const unsigned long int stop = (end < _starts[i + 1UL] ? end : _starts[i + 1UL]);
+
+    ok = loadBlock(i);
+
+    if (ok && (stop > position))
+    {
+      stream.write(_block + (position - _starts[i]), (long)(stop - position));
+      position = stop;
+    }
+  }
+
+  return (ok && (position >= end));
+}
+
+/*********************************************************************************************/
+
+const bool TestSuite::LogReader::loadBlock
+(
+  const unsigned long int blockNum      // the block to decompress into "_block"
+)
+
+/*
+This method reads block "blockNum" into "_block" (unless it's there already) and returns
+"true" if it could be read and decompressed.
+*/
+
+{
+  unsigned long int stored;
+  unsigned long int length;
+  bool              ok = (blockNum == _loadedBlock);
+
+  if (!ok)
+  {
+    _loadedBlock = _numBlocks;
+    _file->clear();
+    _file->seekg((long)_offsets[blockNum], ios::beg);
+
+    ok = getNumber(*_file, stored) && getNumber(*_file, length) &&
+      (length == _starts[blockNum + 1UL] - _starts[blockNum]) && (length <= _blockSize) &&
+      (stored / 2UL <= packedSize(_blockSize));
+
+    if (ok && ((stored & 1UL) != 0UL))
+    {
+      _file->read(_block, (long)(stored / 2UL));
+      ok = _file->good() && (stored / 2UL == length);
+    }
+    else if (ok)
+    {
+      _file->read(_packed, (long)(stored / 2UL));
+      ok = _file->good() && unpack(_packed, stored / 2UL, _block, length);
+    }
+
+    if (ok)
+      _loadedBlock = blockNum;
+  }
+
+  return ok;
+}
+
+// ============================================================================================
+// STATIC FUNCTION DEFINITIONS
+// ============================================================================================
+
+/*********************************************************************************************/
+
+static const unsigned long int packedSize
+(
+  const unsigned long int length        // no. of bytes to compress
+)
+
+/*
+This function returns the most bytes that "pack()" can produce from "length" bytes.
+*/
+
+{
+  return (length + length / 255UL + 16UL);
+}
+
+/*********************************************************************************************/
+
+static const unsigned long int pack
+(
+  const char *const       text,         // the text to compress
+  const unsigned long int length,       // no. of characters in "text"
+  char *const             packed        // where to put it (at least "packedSize(length)")
+)
+
+/*
+This function compresses "text" into "packed" and returns the number of bytes used (see
+"FORMAT OF THE ARCHIVE FILE", above).  Matches are found greedily with a hash table of the
+last place each 4-byte string was seen.
+*/
+
+{
+  const unsigned long int tableSize = 1UL << hashBits;
+  unsigned long int*      table     = new unsigned long int[tableSize];
+  const unsigned char*    input     = (const unsigned char*)text;
+  char*                   output    = packed;
+  unsigned long int       anchor    = 0UL;      // the first literal not yet written
+  unsigned long int       current   = 0UL;      // where a match is being looked for
+
+  for (unsigned long int i = 0UL; i < tableSize; ++i)
+    table[i] = length;
+
+  while (current + minMatch <= length)
+  {
+    const unsigned long int word  = (unsigned long int)input[current] |
+      ((unsigned long int)input[current + 1UL] << 8) |
+      ((unsigned long int)input[current + 2UL] << 16) |
+      ((unsigned long int)input[current + 3UL] << 24);
+    const unsigned long int slot  = ((word * 2654435761UL) & 0xFFFFFFFFUL) >> (32U - hashBits);
+    const unsigned long int match = table[slot];
+
+    table[slot] = current;
+
+    if ((match < current) && (current - match <= maxOffset) &&
+      (memcmp(input + match, input + current, minMatch) == 0))
+    {
+      unsigned long int matchLength = minMatch;
+      const unsigned long int numLiterals = current - anchor;
+
+      while ((current + matchLength < length) &&
+        (input[match + matchLength] == input[current + matchLength]))
+        matchLength++;
+
+      char *const token = output++;
+
+      *token = (char)(((numLiterals < 15UL ? numLiterals : 15UL) << 4) |
+        (matchLength - minMatch < 15UL ? matchLength - minMatch : 15UL));
+
+      if (numLiterals >= 15UL)
+        output = putLength(output, numLiterals - 15UL);
+
+      memcpy(output, text + anchor, numLiterals);
+      output   += numLiterals;
+      *output++ = (char)((current - match) & 0xFFUL);
+      *output++ = (char)((current - match) >> 8);
+
+      if (matchLength - minMatch >= 15UL)
+        output = putLength(output, matchLength - minMatch - 15UL);
+
+      current += matchLength;
+      anchor   = current;
+    }
+    else
+      current++;
+  }
+
+  /*
+  The block ends with a sequence of the remaining literals and no match.
+  */
+
+  const unsigned long int numLiterals = length - anchor;
+
+  *output++ = (char)((numLiterals < 15UL ? numLiterals : 15UL) << 4);
+
+  if (numLiterals >= 15UL)
+    output = putLength(output, numLiterals - 15UL);
+
+  memcpy(output, text + anchor, numLiterals);
+  output += numLiterals;
+
+  delete[] table;
+
+  return (unsigned long int)(output - packed);
+}
+
+/*********************************************************************************************/
+
+static const bool unpack
+(
+  const char *const       packed,       // the compressed text
+  const unsigned long int packedLength, // no. of bytes in "packed"
+  char *const             text,         // where to put the text
+  const unsigned long int length        // no. of characters the text should have
+)
+
+/*
+This function decompresses "packed" into "text" and returns "true" if it was valid and came to
+exactly "length" characters.
+*/
+
+{
+  const char*             input    = packed;
+  const char *const       inputEnd = packed + packedLength;
+  unsigned long int       produced = 0UL;       // no. of characters in "text" so far
+  bool                    ok       = true;
+  bool                    done     = false;     // has the last sequence been decoded?
+
+  while (ok && !done)
+  {
+    unsigned long int numLiterals;
+    unsigned long int matchLength;
+    unsigned long int offset;
+
+    ok = (input < inputEnd);
+
+    if (ok)
+    {
+      const unsigned char token = (unsigned char)*input++;
+
+      numLiterals = (unsigned long int)(token >> 4);
+      matchLength = (unsigned long int)(token & 0x0FU);
+
+      if (numLiterals == 15UL)
+        ok = getLength(input, inputEnd, numLiterals);
+
+      ok = ok && (numLiterals <= (unsigned long int)(inputEnd - input)) &&
+        (numLiterals <= length - produced);
+    }
+
+    if (ok)
+    {
+      memcpy(text + produced, input, numLiterals);
+      input    += numLiterals;
+      produced += numLiterals;
+      done      = (input == inputEnd);
+    }
+
+    if (ok && !done)
+    {
+      ok = (inputEnd - input >= 2);
+
+      if (ok)
+      {
+        offset  = (unsigned long int)(unsigned char)input[0] |
+          ((unsigned long int)(unsigned char)input[1] << 8);
+        input  += 2;
+
+        if (matchLength == 15UL)
+          ok = getLength(input, inputEnd, matchLength);
+
+        matchLength += minMatch;
+        ok = ok && (offset > 0UL) && (offset <= produced) && (matchLength <= length - produced);
+      }
+
+      for (unsigned long int i = 0UL; ok && (i < matchLength); ++i)
+        text[produced + i] = text[produced - offset + i];
+
+      if (ok)
+        produced += matchLength;
+    }
+  }
+
+  return (ok && (produced == length));
+}
+
+/*********************************************************************************************/
+
+static char* putLength
+(
+  char*                   output,
+  const unsigned long int extra         // what's left of a length after the 15 in the token
+)
+
+/*
+This function writes "extra" as bytes of 255 followed by a byte less than 255 and returns
+where it stopped.
+*/
+
+{
+  unsigned long int remaining = extra;
+
+  while (remaining >= 255UL)
+  {
+    *output++  = (char)255;
+    remaining -= 255UL;
+  }
+
+  *output++ = (char)remaining;
+  return output;
+}
+
+/*********************************************************************************************/
+
+static const bool getLength
+(
+  const char*&       input,
+  const char *const  end,
+  unsigned long int& length             // 15 on entry; the whole length on return
+)
+
+/*
+This function adds the bytes that "putLength()" wrote to "length" and returns "true" if they
+were all there.
+*/
+
+{
+  unsigned char byte = 255U;
+
+  while ((byte == 255U) && (input < end))
+  {
+    byte    = (unsigned char)*input++;
+    length += byte;
+  }
+
+  return (byte != 255U);
+}
+
+/*********************************************************************************************/
+
+static const unsigned long int putNumber
+(
+  ostream&                stream,
+  const unsigned long int number
+)
+
+/*
+This function writes "number" 7 bits per byte and returns the number of bytes written.
+*/
+
+{
+  unsigned long int remaining = number;
+  unsigned long int numBytes  = 1UL;
+
+  while (remaining >= 0x80UL)
+  {
+    stream.put((char)((remaining & 0x7FUL) | 0x80UL));
+    remaining >>= 7;
+    numBytes++;
+  }
+
+  stream.put((char)remaining);
+  return numBytes;
+}
+
+/*********************************************************************************************/
+
+static const bool getNumber
+(
+  const char*&       position,
+  const char *const  end,
+  unsigned long int& number
+)
+
+{
+  unsigned int shift = 0U;
+  bool         more  = true;
+
+  number = 0UL;
+
+  while (more && (position < end) && (shift < sizeof(number) * 8U))
+  {
+    const unsigned char byte = (unsigned char)*position++;
+
+    number |= (unsigned long int)(byte & 0x7FU) << shift;
+    shift  += 7U;
+    more    = ((byte & 0x80U) != 0U);
+  }
+
+  return !more;
+}
+
+/*********************************************************************************************/
+
+static const bool getNumber
+(
+  istream&           stream,
+  unsigned long int& number
+)
+
+{
+  unsigned int shift = 0U;
+  bool         more  = true;
+  int          byte  = 0;
+
+  number = 0UL;
+
+  while (more && (shift < sizeof(number) * 8U) && ((byte = stream.get()) != EOF))
+  {
+    number |= (unsigned long int)(byte & 0x7F) << shift;
+    shift  += 7U;
+    more    = ((byte & 0x80) != 0);
+  }
+
+  return !more;
+}
@@ -0,0 +1,304 @@
+// ============================================================================================
+//
+// SOURCE FILE:  modules.cpp
+//
+// ============================================================================================
+
+// ============================================================================================
+// DESCRIPTION
+// ============================================================================================
+
+/*
+This file implements loading test objects from modules (i.e. shared objects) at run time, so
+that a test program doesn't have to be re-linked every time a test changes.
+
+A module is simply a shared object built from one or more source files of "TEST()" definitions.
+Its test objects are constructed, and therefore registered, when "TestSuite::load()" loads it,
+and they're destroyed, and therefore unregistered, when "TestSuite::unload()" unloads it.  From
+then on they're treated exactly like the test objects that are linked into the test program.
+"TestSuite::reload()" unloads a module and loads it again, which picks up a module that has been
+rebuilt (e.g. by a server -- see "server.cpp").
+
+The test objects in a module must register themselves with the test program's "TestSuite"
+class, so the test program must export it to modules:  either link the "TestSuite" code as a
+shared library or link the test program with "-rdynamic" (or your linker's equivalent).
+
+If a module can't really be unloaded (e.g. because something else still refers to it) then its
+test objects aren't destroyed and reloading it won't pick up any changes.  This is logged when
+it can be detected.
+
+A module's test objects should have names that no other test object has.  If one doesn't, only
+one of the test objects with that name can be performed, so each duplicate is logged when the
+module is loaded.
+
+This file uses "dlopen()" and friends and is therefore only compiled if "TESTSUITE_POSIX" is
+defined.
+*/
+
+// ============================================================================================
+// INCLUDE FILES
+// ============================================================================================
+
+#include <string.h>
+
+#ifdef FAT_FILENAMES
+  #include "testsuit.h"
+#else
+  #include "testsuite.h"
+#endif
+
+#ifdef TESTSUITE_POSIX
+
+#include <dlfcn.h>
+
+#endif
+
+#ifdef TESTSUITE_POSIX
+
+// ============================================================================================
+// PUBLIC METHOD DEFINITIONS FOR TESTSUITE CLASS
+// ============================================================================================
+
+/*********************************************************************************************/
+
+const bool TestSuite::load
+(
+  const char *const path                          // the path of the module to load
+)
+
+/*
+This method loads the module at "path", which registers its test objects.  Loading a module
+that has already been loaded does nothing.  Each of the module's test objects that has the same
+name as another test object is logged.
+
+PRECONDITIONS:
+"path" can't be NULL.
+
+POSTCONDITIONS:
+True is returned if the module is loaded.  Otherwise, false is returned and the reason is
+logged.
+*/
+
+{
+  assertInvariants();
+  assert(path != NULL);
+
+  const Module* current = _modules;                                // iterates through modules
+
+  while ((current != NULL) && (strcmp(current->path(), path) != 0))
+    current = current->next();
+
+  if (current == NULL)
+  {
+    const ListNode *const oldTests = _tests;            // the tests registered before loading
+    void *const           handle   = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+
+    if (handle == NULL)
+      logModuleError(path, dlerror());
+    else
+    {
+      _modules = new Module(path, handle, _modules);
+      assert(_modules != NULL);
+
+      current = _modules;
+
+      /*
+      The module's test objects were added to the front of the list of tests, so they're the
+      ones before "oldTests".  Comparing each with the tests after it finds every duplicate
+      name once.
+      */
+
+      const ListNode* test = _tests;                           // iterates through new tests
+
+      for (; test != oldTests; test = test->next())
+      {
+        if (getTest(test->test()->name(), test->next()) != NULL)
+          logDuplicateTest(path, test->test()->name());
+      }
+    }
+  }
+
+  assertInvariants();
+  return (current != NULL);
+}
+
+/*********************************************************************************************/
+
+const bool TestSuite::unload
+(
+  const char *const path                          // the path of the module to unload
+)
+
+/*
+This method unloads the module at "path", which unregisters its test objects.
+
+PRECONDITIONS:
+"path" can't be NULL.
+
+POSTCONDITIONS:
+The module is forgotten by this object.  True is returned if it was unloaded; otherwise, false
+is returned and the reason is logged.
+*/
+
+{
+  assertInvariants();
+  assert(path != NULL);
+
+  Module* previous = NULL;                        // the module before "current"
+  Module* current  = _modules;                    // iterates through modules
+  bool    unloaded = false;                       // has the module been unloaded?
+
+  while ((current != NULL) && (strcmp(current->path(), path) != 0))
+  {
+    previous = current;
+    current  = current->next();
+  }
+
+  if (current == NULL)
+    logModuleError(path, "it hasn't been loaded");
+  else
+  {
+    if (previous == NULL)
+      _modules = current->next();
+    else
+      previous->setNext(current->next());
+
+    if (dlclose(current->handle()) != 0)
+      logModuleError(path, dlerror());
+    else
+    {
+      unloaded = true;
+
+      #ifdef RTLD_NOLOAD
+        void *const handle = dlopen(path, RTLD_NOW | RTLD_NOLOAD);  // set if it's still loaded
+
+        if (handle != NULL)
+        {
+          dlclose(handle);
+          logModuleError(path, "it's still in memory, so its test objects weren't destroyed");
+          unloaded = false;
+        }
+      #endif
+    }
+
+    delete current;
+  }
+
+  assertInvariants();
+  return unloaded;
+}
+
+/*********************************************************************************************/
+
+const bool TestSuite::reload
+(
+  const char *const path                          // the path of the module to reload
+)
+
+/*
+This method unloads the module at "path" (if it has been loaded) and loads it again.
+
+PRECONDITIONS:
+"path" can't be NULL.
+
+POSTCONDITIONS:
+True is returned if the module was re-loaded.  Otherwise, false is returned and the reason is
+logged.
+*/
+
+{
+  assertInvariants();
+  assert(path != NULL);
+
+  const Module* current = _modules;                                // iterates through modules
+
+  while ((current != NULL) && (strcmp(current->path(), path) != 0))
+    current = current->next();
+
+  const bool reloaded = ((current == NULL) || unload(path)) && load(path);
+
+  assertInvariants();
+  return reloaded;
+}
+
+#endif
+
+// ============================================================================================
+// PROTECTED METHOD DEFINITIONS FOR TESTSUITE CLASS
+// ============================================================================================
+
+/*********************************************************************************************/
+
+void TestSuite::logModuleError
+(
+  const char *const path,       // the path of the module
+  const char *const reason      // why the module couldn't be loaded or unloaded
+)
+const
+
+/*
+This method sends a module-error message to "report()".
+
+It's called when a module can't be loaded or unloaded.
+*/
+
+{
+  assert(path != NULL);
+
+  log() << "-------------------------------------------------------------------------------" <<
+    endl;
+  log() << "Module \"" << path << "\" couldn't be loaded or unloaded:  " <<
+    (reason != NULL ? reason : "unknown reason") << endl;
+  log() << endl;
+  return;
+}
+
+/*********************************************************************************************/
+
+void TestSuite::logDuplicateTest
+(
+  const char *const path,       // the path of the module
+  const char *const testName    // the name that's used by more than one test object
+)
+const
+
+/*
+This method sends a duplicate-test message to "report()".
+
+It's called when a module that's being loaded has a test object with the same name as another
+test object.
+*/
+
+{
+  assert(path != NULL);
+  assert(testName != NULL);
+
+  log() << "-------------------------------------------------------------------------------" <<
+    endl;
+  log() << "*** Test object \"" << testName << "\" in module \"" << path << "\" has the " <<
+    "same name as another test object, so only one of them will be performed. ***" << endl;
+  log() << endl;
+  return;
+}
+
+// ============================================================================================
+// METHOD DEFINITIONS FOR TESTSUITE::MODULE
+// ============================================================================================
+
+/*********************************************************************************************/
+
+TestSuite::Module::Module
+(
+  const char *const        path,
+  void *const              handle,
+  TestSuite::Module *const nextModule
+):
+
+  _path(newString(path)),
+  _handle(handle),
+  _next(nextModule)
+
+{
+  assert(_handle != NULL);
+  return;
+}
@@ -0,0 +1,1477 @@
+// ============================================================================================
+//
+// SOURCE FILE:  parallel.cpp
+//
+// ============================================================================================
+
+// ============================================================================================
+// DESCRIPTION
+// ============================================================================================
+
+/*
+This file implements performing tests in several worker processes at once.  After
+
+  test.setWorkers(8);
+
+the methods that perform tests ("one()", "group()", "tagged()", "shard()" and "all()") fork
+8 worker processes and hand them the selected sections of the test data stream a chunk of test
+cases at a time.  Worker processes are used rather than threads because test objects keep the
+test case being applied in member variables and so can't be shared between threads.
+
+The test data stream is only ever read by the calling process, which sends each chunk to a
+worker as text; the worker applies it to its own copy of the test object and sends back its log
+output and results.  Everything is logged, and added to the results, in the same order as when
+the tests are performed one section at a time:  sections in the order that they were selected
+(see "FAILURES FIRST AND FAIL-FAST" in "testsuite.cpp") and test cases in the order that they
+appear.  A section's log output is held back until all of its chunks are done.
+
+Test cases can take anything from microseconds to seconds, so the size of the chunks adapts to
+how long each test's test cases actually take.  The first chunks of a test are 1, 2, 4, ...
+test cases long, until the first of them is done; from then on each chunk is sized to take
+about the target time given to "setWorkers()" (0.05 seconds by default), using a running
+average of the test's time per test case.  Handing out one test case at a time would spend more
+time on the pipes than on the tests; handing out whole sections would leave workers idle while
+one of them works through a large section.
+
+A test case that reads extra lines from the test data stream can't be split from those lines,
+and only the test method knows how many there are.  When a worker notices that a test case read
+extra lines, that test's sections are no longer split, and if the section that it noticed it in
+had been split then the whole section is performed again (and the results of its chunks are
+discarded).
+
+Aborting works the same as it does one section at a time:  a test case that aborts its test
+discards the results of the test cases after it in its section, and a test case that aborts all
+tests (or cancels them -- see "setFailFast()") discards the results of everything after it.  No
+more chunks are handed out after that, and the workers that are applying chunks whose results
+will be discarded are sent a "SIGUSR1", which cancels the chunk in the worker (i.e. the test
+case being applied finishes, but no more are).  Workers applying chunks before the one that
+stopped testing finish them, since their results count.  "cancel()" stops new chunks from being
+handed out, sends every busy worker a "SIGUSR1", and the results of everything that was done
+are logged.
+
+A worker's "SIGUSR1" handler is installed with "SA_RESTART", but a test method that's waiting
+in a system call can still see it interrupted, so test code shouldn't rely on "SIGUSR1" being
+left alone in worker processes.  If a chunk was interrupted but turns out to count after all
+(because the section that stopped testing had to be performed again -- see below), its section
+is performed again, unsplit.
+
+If a results history is being recorded (see "setHistory()"), each worker keeps the records of
+its chunk's test cases (see "History::startRelay()") and sends them back with its results, and
+they're added to the history as each section is logged, so the history is the same as when the
+tests are performed one section at a time.
+
+A test case that reads extra lines at the end of a chunk gets NULL from "readLine()" and could
+crash its worker before the extra lines are noticed.  So if a worker crashes while applying
+part of a split section, it's replaced and the section is performed again, unsplit (and that
+test's sections aren't split from then on).  A worker that crashes while applying a whole
+section aborts testing, and the crash is logged in place of the section's output.
+
+This file uses "fork()" and friends and is therefore only compiled if "TESTSUITE_POSIX" is
+defined.
+*/
+
+// ============================================================================================
+// INCLUDE FILES
+// ============================================================================================
+
+#ifdef FAT_FILENAMES
+  #include "testsuit.h"
+#else
+  #include "testsuite.h"
+#endif
+
+#ifdef TESTSUITE_POSIX
+
+#ifdef FAT_FILENAMES
+  #include <strstrea.h>
+#else
+  #include <strstream.h>
+#endif
+
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/select.h>
+#include <signal.h>
+
+// ============================================================================================
+// STATIC CONSTANTS
+// ============================================================================================
+
+static const unsigned int noChunk      = UINT_MAX;   // "no chunk" (or "the whole section")
+static const unsigned int maxProbeSize = 256U;       // largest chunk before a test is timed
+static const unsigned int maxChunkSize = 1048576U;   // largest chunk of a split section
+
+// ============================================================================================
+// STATIC FUNCTION DECLARATIONS
+// ============================================================================================
+
+static const bool readAll(const int, void *const, const size_t);
+static const bool writeAll(const int, const void *const, const size_t);
+static void       onInterrupt(int);
+
+// ============================================================================================
+// DISPATCHER CLASS DECLARATION
+// ============================================================================================
+
+/*
+This class does the work of "TestSuite::runInParallel()":  it reads chunks of test cases from
+the test data stream, hands them to worker processes, and logs the results in order.
+*/
+
+class TestSuite::Dispatcher
+{
+  public:
+                    Dispatcher(TestSuite&, const ScheduledSection *const,
+                      const unsigned long int, const ListNode *const);
+                    ~Dispatcher();
+
+    const bool      run();
+
+  private:
+    class Unit                            // a chunk of test cases and, later, its results
+    {
+      public:
+        unsigned long int section;        // which "_sections" entry it's from
+        unsigned long int generation;     // the section's generation when it was read
+        unsigned int      chunk;          // its position within the section
+        bool              whole;          // is it the whole section?
+        unsigned int      firstCaseNum;   // the no. of its first test case
+        unsigned long int lineCounter;    // the line no. of the line before its first
+        char*             text;           // its test cases, one per line
+        unsigned long int textLength;     // no. of characters in "text"
+        CaseTally         tally;          // the results from the worker
+        bool              cancelled;      // did the worker cancel testing?
+        bool              interrupted;    // was the worker told to cancel it?
+        char*             log;            // the log output from the worker
+        unsigned long int logLength;      // no. of characters in "log"
+        char*             cases;          // the history records from the worker (if any)
+        unsigned long int casesLength;    // no. of characters in "cases"
+        Unit*             next;           // the next chunk of the section that's been done
+    };
+
+    class SectionState                    // what's become of a selected section
+    {
+      public:
+        const Test*       test;           // the test the section is for
+        unsigned long int generation;     // incremented each time the section is restarted
+        unsigned int      numChunks;      // no. of chunks read so far
+        unsigned int      numDone;        // no. of those that have been done
+        bool              fullyRead;      // have all of its test cases been read?
+        bool              redo;           // is it waiting to be performed again, unsplit?
+        unsigned int      abortChunk;     // the chunk that aborted the test (or "noChunk")
+        Unit*             units;          // the chunks that have been done, in order
+    };
+
+    class TestCost                        // how long a test's test cases take
+    {
+      public:
+        const Test*       test;
+        double            secondsPerCase; // running average (or negative if not known yet)
+        unsigned int      probeSize;      // size of the next chunk until it's known
+        bool              unsplittable;   // do its test cases read extra lines?
+    };
+
+    class Worker
+    {
+      public:
+        pid_t             pid;            // the worker process (or -1 if it's gone)
+        int               toWorker;       // where chunks are sent
+        int               fromWorker;     // where results are received
+        Unit*             unit;           // the chunk it's working on (if any)
+    };
+
+    class UnitMessage                     // what's sent to a worker ahead of a chunk's text
+    {
+      public:
+        const Test*       test;
+        unsigned int      firstCaseNum;
+        unsigned long int lineCounter;
+        unsigned long int textLength;
+    };
+
+    class ReplyMessage                    // what's received from a worker ahead of its log
+    {
+      public:
+        CaseTally         tally;
+        bool              cancelled;
+        unsigned long int logLength;
+        unsigned long int casesLength;    // no. of characters of history records after it
+    };
+
+    TestSuite&                    _suite;
+    const ScheduledSection *const _schedule;       // the selected sections, in order
+    const unsigned long int       _numScheduled;   // no. of entries in "_schedule"
+    SectionState *const           _sections;       // the state of each "_schedule" entry
+    TestCost *const               _costs;          // one entry for each test in "_schedule"
+    unsigned long int             _numCosts;       // no. of entries in use in "_costs"
+    Worker *const                 _workers;
+    unsigned int                  _numWorkers;     // no. of entries in use in "_workers"
+    unsigned long int             _readSection;    // the section being read
+    bool                          _readSeeked;     // has "_readSection" been sought yet?
+    bool                          _needsRestore;   // has another section been read since?
+    unsigned int                  _casesConsumed;  // no. of its test cases put into chunks
+    const char*                   _heldCase;       // a test case read but not put into a chunk
+    unsigned long int             _heldLine;       // the line that "_heldCase" was on
+    unsigned long int             _numRedo;        // no. of sections waiting to be redone
+    unsigned long int             _stopSection;    // the section that stops testing (if any)
+    unsigned int                  _stopChunk;      // the chunk of it that stops testing
+    bool                          _stopCancelled;  // was it stopped by a cancellation?
+    unsigned long int             _nextEmit;       // the next section to log
+
+                       Dispatcher(const Dispatcher&);
+    Dispatcher&        operator=(const Dispatcher&);
+    const bool         startWorkers();
+    const bool         startWorker(Worker&);
+    void               serveChunks(const int, const int);
+    void               stopWorker(Worker&);
+    TestCost&          cost(const Test *const);
+    const unsigned int chunkSize(const Test *const);
+    Unit *const        nextUnit();
+    Unit *const        readUnit(const unsigned long int, const unsigned int, unsigned int&,
+                         const char*&, unsigned long int&);
+    const char *const  readCase(unsigned long int&);
+    void               advanceReading();
+    void               restartSection(const unsigned long int);
+    const bool         send(Worker&);
+    void               receive(Worker&);
+    void               record(Unit *const);
+    const bool         afterStop(const Unit&) const;
+    void               interruptWorkers();
+    const unsigned int numReady(const SectionState&) const;
+    void               emitReady();
+    void               emit(const unsigned long int, const unsigned int);
+    void               deleteUnits(SectionState&);
+    static void        deleteUnit(Unit *const);
+};
+
+// ============================================================================================
+// PUBLIC METHOD DEFINITIONS FOR TESTSUITE CLASS
+// ============================================================================================
+
+/*********************************************************************************************/
+
+void TestSuite::setWorkers
+(
+  const unsigned int numWorkers,     // no. of worker processes (1U to perform tests in-process)
+  const double       chunkSeconds    // about how long each chunk of test cases should take
+)
+
+/*
+This method makes this object perform tests in "numWorkers" worker processes at once, handing
+them chunks of test cases that take about "chunkSeconds" each.  See "parallel.cpp".
+
+The test data stream is indexed first if necessary, so it must be seekable.
+
+PRECONDITIONS:
+"numWorkers" can't be 0U and "chunkSeconds" must be positive.
+
+POSTCONDITIONS:
+Tests will be performed in "numWorkers" worker processes if "numWorkers" is more than 1U.
+*/
+
+{
+  assertInvariants();
+  assert(numWorkers > 0U);
+  assert(chunkSeconds > 0.0);
+
+  _numWorkers   = numWorkers;
+  _chunkSeconds = chunkSeconds;
+
+  assertInvariants();
+  return;
+}
+
+// ============================================================================================
+// PRIVATE METHOD DEFINITIONS FOR TESTSUITE CLASS
+// ============================================================================================
+
+/*********************************************************************************************/
+
+void TestSuite::runInParallel
+(
+  const ScheduledSection *const schedule,       // the sections to perform, in order
+  const unsigned long int       numScheduled,   // no. of entries in "schedule"
+  const ListNode *const         tests           // the tests that the sections were selected for
+)
+
+/*
+This method performs the sections in "schedule" in worker processes.  If no worker process can
+be started then they're performed in this process instead.
+*/
+
+{
+  assertInvariants();
+
+  Dispatcher dispatcher(*this, schedule, numScheduled, tests);
+
+  if (!dispatcher.run())
+  {
+    bool abortAll = false;                                  // should all testing be stopped?
+
+    for (unsigned long int i = 0UL; !abortAll && (i < numScheduled); ++i)
+    {
+      const Test *const test = getTest(schedule[i].section->name(), tests);
+
+      _testData.seek(*schedule[i].section);
+      abortAll = !runTest(*(Test*)test);
+    }
+  }
+
+  assertInvariants();
+  return;
+}
+
+// ============================================================================================
+// METHOD DEFINITIONS FOR TESTSUITE::DISPATCHER
+// ============================================================================================
+
+/*********************************************************************************************/
+
+TestSuite::Dispatcher::Dispatcher
+(
+  TestSuite&                    suite,
+  const ScheduledSection *const schedule,
+  const unsigned long int       numScheduled,
+  const ListNode *const         tests
+):
+
+  _suite(suite),
+  _schedule(schedule),
+  _numScheduled(numScheduled),
+  _sections(new SectionState[numScheduled + 1UL]),
+  _costs(new TestCost[numScheduled + 1UL]),
+  _numCosts(0UL),
+  _workers(new Worker[suite._numWorkers]),
+  _numWorkers(0U),
+  _readSection(0UL),
+  _readSeeked(false),
+  _needsRestore(false),
+  _casesConsumed(0U),
+  _heldCase(NULL),
+  _heldLine(0UL),
+  _numRedo(0UL),
+  _stopSection(numScheduled),
+  _stopChunk(noChunk),
+  _stopCancelled(false),
+  _nextEmit(0UL)
+
+{
+  assert((_sections != NULL) && (_costs != NULL) && (_workers != NULL));
+
+  for (unsigned long int i = 0UL; i < _numScheduled; ++i)
+  {
+    _sections[i].test       = getTest(_schedule[i].section->name(), tests);
+    _sections[i].generation = 0UL;
+    _sections[i].numChunks  = 0U;
+    _sections[i].numDone    = 0U;
+    _sections[i].fullyRead  = false;
+    _sections[i].redo       = false;
+    _sections[i].abortChunk = noChunk;
+    _sections[i].units      = NULL;
+
+    assert(_sections[i].test != NULL);
+  }
+
+  return;
+}
+
+/*********************************************************************************************/
+
+TestSuite::Dispatcher::~Dispatcher()
+{
+  for (unsigned int i = 0U; i < _numWorkers; ++i)
+    stopWorker(_workers[i]);
+
+  for (unsigned long int i = 0UL; i < _numScheduled; ++i)
+    deleteUnits(_sections[i]);
+
+  delete[] (char*)_heldCase;
+  delete[] _workers;
+  delete[] _costs;
+  delete[] _sections;
+
+  return;
+}
+
+/*********************************************************************************************/
+
+const bool TestSuite::Dispatcher::run()
+
+/*
+This method performs the selected sections and logs the results.  False is returned (and
+nothing is done) if no worker process could be started.
+*/
+
+{
+  if (!startWorkers())
+    return false;
+
+  void (*const oldHandler)(int) = signal(SIGPIPE, SIG_IGN);  // so a dead worker is an error
+  bool         finished         = false;                 // is there nothing left to wait for?
+
+  while (!finished)
+  {
+    fd_set busy;                                         // workers with chunks to finish
+    int    maxFd = -1;                                   // the highest fd in "busy"
+
+    FD_ZERO(&busy);
+
+    for (unsigned int i = 0U; i < _numWorkers; ++i)
+    {
+      Worker& worker = _workers[i];
+
+      if ((worker.pid > 0) && (worker.unit == NULL))
+      {
+        worker.unit = nextUnit();
+
+        if ((worker.unit != NULL) && !send(worker))
+          receive(worker);
+      }
+
+      if (worker.unit != NULL)
+      {
+        FD_SET(worker.fromWorker, &busy);
+
+        if (worker.fromWorker > maxFd)
+          maxFd = worker.fromWorker;
+      }
+    }
+
+    finished = (maxFd < 0);
+
+    if (!finished && (TestSuite::_cancelled != 0))
+      interruptWorkers();
+
+    if (!finished && (select(maxFd + 1, &busy, NULL, NULL, NULL) > 0))
+    {
+      for (unsigned int i = 0U; i < _numWorkers; ++i)
+      {
+        if ((_workers[i].unit != NULL) && FD_ISSET(_workers[i].fromWorker, &busy))
+          receive(_workers[i]);
+      }
+    }
+
+    emitReady();
+  }
+
+  /*
+  If testing was cancelled then the chunks that were done at the start of the first unfinished
+  section are logged, followed by the cancellation.
+  */
+
+  if (TestSuite::_cancelled != 0)
+  {
+    if ((_nextEmit < _stopSection) && (_nextEmit < _numScheduled) &&
+      (numReady(_sections[_nextEmit]) > 0U))
+    {
+      _stopSection   = _nextEmit;
+      _stopChunk     = numReady(_sections[_nextEmit]) - 1U;
+      _stopCancelled = true;
+      emit(_nextEmit, _stopChunk + 1U);
+    }
+
+    _suite.cancelTesting();
+  }
+
+  signal(SIGPIPE, oldHandler);
+  return true;
+}
+
+/*********************************************************************************************/
+
+const bool TestSuite::Dispatcher::startWorkers()
+
+/*
+This method forks the worker processes.  True is returned if at least one was started.
+*/
+
+{
+  bool forked = true;                                    // was the last worker started?
+
+  while (forked && (_numWorkers < _suite._numWorkers))
+  {
+    forked = startWorker(_workers[_numWorkers]);
+
+    if (forked)
+      ++_numWorkers;
+  }
+
+  return (_numWorkers > 0U);
+}
+
+/*********************************************************************************************/
+
+const bool TestSuite::Dispatcher::startWorker
+(
+  Worker& worker                            // where the worker is kept (not in use)
+)
+
+/*
+This method forks a worker process.  True is returned if it was started.
+*/
+
+{
+  int   toWorker[2];
+  int   fromWorker[2];
+  pid_t pid = -1;
+
+  _suite.log().flush();
+  cout.flush();
+
+  if (pipe(toWorker) == 0)
+  {
+    if (pipe(fromWorker) == 0)
+    {
+      pid = fork();
+
+      if (pid == 0)
+      {
+        close(toWorker[1]);
+        close(fromWorker[0]);
+        serveChunks(toWorker[0], fromWorker[1]);
+      }
+
+      if (pid < 0)
+      {
+        close(fromWorker[0]);
+        close(fromWorker[1]);
+      }
+    }
+
+    if (pid < 0)
+    {
+      close(toWorker[0]);
+      close(toWorker[1]);
+    }
+  }
+
+  if (pid > 0)
+  {
+    close(toWorker[0]);
+    close(fromWorker[1]);
+
+    worker.pid        = pid;
+    worker.toWorker   = toWorker[1];
+    worker.fromWorker = fromWorker[0];
+    worker.unit       = NULL;
+  }
+
+  return (pid > 0);
+}
+
+/*********************************************************************************************/
+
+void TestSuite::Dispatcher::serveChunks
+(
+  const int input,                                    // where chunks are received
+  const int output                                    // where results are sent
+)
+
+/*
+This method is the whole life of a worker process:  it applies the chunks of test cases that it
+receives on "input" and sends back the results on "output" until "input" is closed.  It never
+returns.
+*/
+
+{
+  for (unsigned int i = 0U; i < _numWorkers; ++i)
+  {
+    if (_workers[i].pid > 0)
+    {
+      close(_workers[i].toWorker);
+      close(_workers[i].fromWorker);
+    }
+  }
+
+  _suite._logArchive = NULL;
+
+  struct sigaction action;                             // cancels the chunk being applied
+
+  action.sa_handler = onInterrupt;
+  action.sa_flags   = SA_RESTART;
+  sigemptyset(&action.sa_mask);
+  sigaction(SIGUSR1, &action, NULL);
+
+  UnitMessage message;
+  bool        ok = true;                               // is the calling process still there?
+
+  while (ok && readAll(input, &message, sizeof(message)))
+  {
+    char *const text = new char[message.textLength + 1UL];
+
+    assert(text != NULL);
+
+    ok = readAll(input, text, message.textLength);
+
+    if (ok)
+    {
+      istrstream   chunk(text, (int)message.textLength);
+      ostrstream   log;
+      ReplyMessage reply;
+
+      _suite._testData.redirect(chunk, message.lineCounter);
+      _suite._caseBase  = message.firstCaseNum - 1U;
+      _suite._log       = &log;
+      TestSuite::_cancelled = 0;
+
+      if (_suite._history != NULL)
+        _suite._history->startRelay();
+
+      _suite.applyTestCases(*(Test*)message.test, reply.tally);
+
+      char *const cases = (_suite._history != NULL ?
+                            _suite._history->endRelay(reply.casesLength) : (char*)NULL);
+
+      if (_suite._history == NULL)
+        reply.casesLength = 0UL;
+
+      reply.cancelled = (TestSuite::_cancelled != 0);
+      reply.logLength = (unsigned long int)log.pcount();
+
+      char *const logText = log.str();
+
+      ok = writeAll(output, &reply, sizeof(reply)) &&
+        writeAll(output, logText, reply.logLength) &&
+        writeAll(output, cases, reply.casesLength);
+
+      delete[] logText;
+      delete[] cases;
+      cout.flush();
+    }
+
+    delete[] text;
+  }
+
+  _exit(0);
+}
+
+/*********************************************************************************************/
+
+void TestSuite::Dispatcher::stopWorker
+(
+  Worker& worker
+)
+
+/*
+This method closes the pipes to and from a worker process, which makes it exit, and waits for
+it.
+*/
+
+{
+  if (worker.pid > 0)
+  {
+    int status;
+
+    close(worker.toWorker);
+    close(worker.fromWorker);
+
+    while ((waitpid(worker.pid, &status, 0) < 0) && (errno == EINTR))
+      status = 0;
+
+    worker.pid = -1;
+  }
+
+  return;
+}
+
+/*********************************************************************************************/
+
+TestSuite::Dispatcher::TestCost& TestSuite::Dispatcher::cost
+(
+  const Test *const test
+)
+
+/*
+This method returns what's known about how long "test"'s test cases take.
+*/
+
+{
+  unsigned long int i = 0UL;
+
+  while ((i < _numCosts) && (_costs[i].test != test))
+    ++i;
+
+  if (i == _numCosts)
+  {
+    _costs[i].test           = test;
+    _costs[i].secondsPerCase = -1.0;
+    _costs[i].probeSize      = 1U;
+    _costs[i].unsplittable   = false;
+    ++_numCosts;
+  }
+
+  return _costs[i];
+}
+
+/*********************************************************************************************/
+
+const unsigned int TestSuite::Dispatcher::chunkSize
+(
+  const Test *const test
+)
+
+/*
+This method returns how many test cases should go into the next chunk for "test".
+*/
+
+{
+  TestCost&    testCost = cost(test);
+  unsigned int size     = noChunk;                              // the chunk size
+
+  if (testCost.unsplittable)
+    size = noChunk;
+  else if (testCost.secondsPerCase < 0.0)
+  {
+    size = testCost.probeSize;
+
+    if (testCost.probeSize < maxProbeSize)
+      testCost.probeSize *= 2U;
+  }
+  else if (testCost.secondsPerCase * maxChunkSize <= _suite._chunkSeconds)
+    size = maxChunkSize;
+  else
+  {
+    size = (unsigned int)(_suite._chunkSeconds / testCost.secondsPerCase);
+
+    if (size == 0U)
+      size = 1U;
+  }
+
+  return size;
+}
+
+/*********************************************************************************************/
+
+TestSuite::Dispatcher::Unit *const TestSuite::Dispatcher::nextUnit()
+
+/*
+This method reads the next chunk to hand to a worker:  a section that has to be performed again
+(unsplit), if there is one, or the next chunk of the section being read.  NULL is returned if
+there's nothing to hand out -- because everything has been read, or because testing is being
+stopped.
+*/
+
+{
+  Unit* unit = NULL;
+
+  if (TestSuite::_cancelled == 0)
+  {
+    for (unsigned long int i = _nextEmit; (unit == NULL) && (_numRedo > 0UL) &&
+      (i < _stopSection) && (i < _numScheduled); ++i)
+    {
+      if (_sections[i].redo)
+      {
+        unsigned int      consumed = 0U;                  // (not needed for a whole section)
+        const char*       held     = NULL;
+        unsigned long int heldLine = 0UL;
+
+        _sections[i].redo = false;
+        --_numRedo;
+
+        _suite._testData.seek(*_schedule[i].section);
+        unit = readUnit(i, noChunk, consumed, held, heldLine);
+
+        _needsRestore = _readSeeked;
+      }
+    }
+
+    while ((unit == NULL) && (_readSection < _stopSection) && (_readSection < _numScheduled))
+    {
+      if (!_readSeeked || _needsRestore)
+      {
+        _suite._testData.seek(*_schedule[_readSection].section);
+
+        /*
+        If another section has been read since this one was started then the test cases that
+        were already put into chunks (and the one that's being held) are skipped.
+        */
+
+        if (_readSeeked)
+        {
+          const unsigned int numSkipped = _casesConsumed + (_heldCase != NULL ? 1U : 0U);
+          unsigned long int  line;
+
+          for (unsigned int i = 0U; i < numSkipped; ++i)
+            delete[] (char*)readCase(line);
+        }
+        else
+          _casesConsumed = 0U;
+
+        _readSeeked   = true;
+        _needsRestore = false;
+      }
+
+      unit = readUnit(_readSection, chunkSize(_sections[_readSection].test), _casesConsumed,
+        _heldCase, _heldLine);
+
+      if (_sections[_readSection].fullyRead)
+        advanceReading();
+    }
+  }
+
+  return unit;
+}
+
+/*********************************************************************************************/
+
+TestSuite::Dispatcher::Unit *const TestSuite::Dispatcher::readUnit
+(
+  const unsigned long int section,          // which section is being read
+  const unsigned int      size,             // the most test cases to put into the chunk
+  unsigned int&           consumed,         // no. of test cases already put into chunks
+  const char*&            held,             // a test case read but not yet put into a chunk
+  unsigned long int&      heldLine          // the line that "held" was on
+)
+
+/*
+This method reads a chunk of up to "size" test cases from the test data stream.  One more test
+case is read (and left in "held") to find out whether the section ends with the chunk.  NULL is
+returned if the section has no more test cases.
+
+Blank lines are put in place of comments and blank lines so that the worker process can count
+lines correctly.
+*/
+
+{
+  SectionState&      state        = _sections[section];
+  const unsigned int firstCaseNum = consumed + 1U;
+  unsigned long int  line         = heldLine;           // the line that "caseText" was on
+  const char*        caseText     = held;               // the test case to put in next
+  unsigned int       numCases     = 0U;                 // no. put into the chunk so far
+  ostrstream         text;                              // the chunk being built
+  Unit*              unit         = NULL;
+
+  held = NULL;
+
+  if ((caseText == NULL) && (consumed < _suite._lastCase))
+    caseText = readCase(line);
+
+  const unsigned long int lineCounter = line - 1UL;    // the line before the first test case
+  unsigned long int       lastLine    = lineCounter;   // the last line put into the chunk
+
+  while ((caseText != NULL) && (numCases < size))
+  {
+    while (lastLine + 1UL < line)
+    {
+      text << '\n';
+      ++lastLine;
+    }
+
+    text << caseText << '\n';
+    lastLine = line;
+
+    delete[] (char*)caseText;
+    ++numCases;
+    ++consumed;
+
+    caseText = (consumed < _suite._lastCase ? readCase(line) : (const char*)NULL);
+  }
+
+  held     = caseText;
+  heldLine = line;
+
+  state.fullyRead = (caseText == NULL);
+
+  if (numCases > 0U)
+  {
+    unit = new Unit;
+    assert(unit != NULL);
+
+    unit->section      = section;
+    unit->generation   = state.generation;
+    unit->chunk        = state.numChunks++;
+    unit->whole        = (unit->chunk == 0U) && state.fullyRead;
+    unit->firstCaseNum = firstCaseNum;
+    unit->lineCounter  = lineCounter;
+    unit->textLength   = (unsigned long int)text.pcount();
+    unit->text         = text.str();
+    unit->cancelled    = false;
+    unit->interrupted  = false;
+    unit->log          = NULL;
+    unit->logLength    = 0UL;
+    unit->cases        = NULL;
+    unit->casesLength  = 0UL;
+    unit->next         = NULL;
+  }
+  else
+    delete[] text.str();
+
+  return unit;
+}
+
+/*********************************************************************************************/
+
+const char *const TestSuite::Dispatcher::readCase
+(
+  unsigned long int& line                 // where the line no. of the test case is returned
+)
+
+{
+  const char *const caseText = _suite._testData.readTestCase();
+
+  line = _suite._testData.lineCounter();
+  return caseText;
+}
+
+/*********************************************************************************************/
+
+void TestSuite::Dispatcher::advanceReading()
+
+/*
+This method moves on to reading the next section.
+*/
+
+{
+  delete[] (char*)_heldCase;
+
+  _heldCase      = NULL;
+  _casesConsumed = 0U;
+  _readSeeked    = false;
+  _needsRestore  = false;
+  ++_readSection;
+
+  return;
+}
+
+/*********************************************************************************************/
+
+void TestSuite::Dispatcher::restartSection
+(
+  const unsigned long int section
+)
+
+/*
+This method discards everything that has been done for "section" and queues it to be performed
+again as a single chunk.  Chunks of it that are still being worked on will be discarded when
+they're done because their generation won't match.
+*/
+
+{
+  SectionState& state = _sections[section];
+
+  deleteUnits(state);
+
+  ++state.generation;
+  state.numChunks  = 0U;
+  state.numDone    = 0U;
+  state.fullyRead  = false;
+  state.abortChunk = noChunk;
+
+  if (!state.redo)
+  {
+    state.redo = true;
+    ++_numRedo;
+  }
+
+  if (_stopSection == section)
+  {
+    _stopSection   = _numScheduled;
+    _stopChunk     = noChunk;
+    _stopCancelled = false;
+  }
+
+  if (_readSection == section)
+    advanceReading();
+
+  return;
+}
+
+/*********************************************************************************************/
+
+const bool TestSuite::Dispatcher::send
+(
+  Worker& worker
+)
+
+/*
+This method sends "worker" its chunk.  False is returned if the worker has gone.
+*/
+
+{
+  Unit *const unit = worker.unit;
+  UnitMessage message;
+
+  assert(unit != NULL);
+
+  message.test         = _sections[unit->section].test;
+  message.firstCaseNum = unit->firstCaseNum;
+  message.lineCounter  = unit->lineCounter;
+  message.textLength   = unit->textLength;
+
+  const bool sent = writeAll(worker.toWorker, &message, sizeof(message)) &&
+                      writeAll(worker.toWorker, unit->text, unit->textLength);
+
+  delete[] unit->text;
+  unit->text = NULL;
+
+  return sent;
+}
+
+/*********************************************************************************************/
+
+void TestSuite::Dispatcher::receive
+(
+  Worker& worker
+)
+
+/*
+This method receives the results of "worker"'s chunk and records them.  If the worker has gone
+then it's stopped.  If its chunk was part of a split section then another worker is started in
+its place and the section is performed again, unsplit; otherwise its chunk aborts testing.
+*/
+
+{
+  Unit *const  unit = worker.unit;
+  ReplyMessage reply;
+  bool         ok   = readAll(worker.fromWorker, &reply, sizeof(reply));
+
+  assert(unit != NULL);
+
+  worker.unit = NULL;
+
+  if (ok)
+  {
+    unit->tally     = reply.tally;
+    unit->cancelled = reply.cancelled;
+    unit->logLength = reply.logLength;
+    unit->log       = new char[reply.logLength + 1UL];
+    assert(unit->log != NULL);
+
+    ok = readAll(worker.fromWorker, unit->log, reply.logLength);
+  }
+
+  if (ok && (reply.casesLength > 0UL))
+  {
+    unit->casesLength = reply.casesLength;
+    unit->cases       = new char[reply.casesLength];
+    assert(unit->cases != NULL);
+
+    ok = readAll(worker.fromWorker, unit->cases, reply.casesLength);
+  }
+
+  if (!ok)
+    stopWorker(worker);
+
+  if (!ok && !unit->whole && startWorker(worker))
+  {
+    cost(_sections[unit->section].test).unsplittable = true;
+
+    if (unit->generation == _sections[unit->section].generation)
+      restartSection(unit->section);
+
+    deleteUnit(unit);
+  }
+  else if (!ok)
+  {
+    static const char message[] = "*** A worker process stopped unexpectedly. ***\n\n";
+
+    delete[] unit->log;
+    delete[] unit->cases;
+
+    unit->tally.numCases        = 0U;
+    unit->tally.numFailedCases  = 0U;
+    unit->tally.firstFailedCase = 0U;
+    unit->tally.firstFailedLine = 0UL;
+    unit->tally.abortTest       = true;
+    unit->tally.abortAll        = true;
+    unit->tally.readExtra       = false;
+    unit->tally.numDuplicates   = 0U;
+    unit->tally.duration        = 0.0;
+    unit->cancelled             = false;
+    unit->logLength             = sizeof(message) - 1U;
+    unit->log                   = strcpy(new char[sizeof(message)], message);
+    unit->cases                 = NULL;
+    unit->casesLength           = 0UL;
+
+    record(unit);
+  }
+  else
+    record(unit);
+
+  return;
+}
+
+/*********************************************************************************************/
+
+void TestSuite::Dispatcher::record
+(
+  Unit *const unit                                   // a chunk whose results have come back
+)
+
+/*
+This method adds a chunk's results to its section, unless the section has been restarted
+since the chunk was read.
+*/
+
+{
+  SectionState& state = _sections[unit->section];
+
+  if (unit->generation != state.generation)
+    deleteUnit(unit);
+  else if (unit->interrupted && unit->cancelled && (TestSuite::_cancelled == 0) &&
+    !afterStop(*unit))
+  {
+    restartSection(unit->section);
+    deleteUnit(unit);
+  }
+  else
+  {
+    TestCost& testCost = cost(state.test);
+
+    if (unit->tally.readExtra)
+      testCost.unsplittable = true;
+
+    if (unit->tally.readExtra && !unit->whole)
+    {
+      restartSection(unit->section);
+      deleteUnit(unit);
+    }
+    else
+    {
+      Unit** position = &state.units;                // where "unit" belongs in chunk order
+
+      while ((*position != NULL) && ((*position)->chunk < unit->chunk))
+        position = &(*position)->next;
+
+      unit->next = *position;
+      *position  = unit;
+      ++state.numDone;
+
+      if (unit->tally.numCases > 0U)
+      {
+        const double perCase = unit->tally.duration / unit->tally.numCases;
+
+        testCost.secondsPerCase = (testCost.secondsPerCase < 0.0 ? perCase :
+                                    (testCost.secondsPerCase + perCase) / 2.0);
+      }
+
+      /*
+      A chunk after the one that aborted the test doesn't count, so it can't abort anything.
+      */
+
+      if ((unit->chunk < state.abortChunk) && (unit->tally.abortAll || unit->cancelled))
+      {
+        if ((unit->section < _stopSection) ||
+          ((unit->section == _stopSection) && (unit->chunk < _stopChunk)))
+        {
+          _stopSection   = unit->section;
+          _stopChunk     = unit->chunk;
+          _stopCancelled = unit->cancelled;
+        }
+      }
+      else if ((unit->chunk < state.abortChunk) && unit->tally.abortTest)
+      {
+        state.abortChunk = unit->chunk;
+
+        if ((_stopSection == unit->section) && (unit->chunk < _stopChunk))
+        {
+          _stopSection   = _numScheduled;
+          _stopChunk     = noChunk;
+          _stopCancelled = false;
+        }
+
+        if (_readSection == unit->section)
+        {
+          state.fullyRead = true;
+          advanceReading();
+        }
+      }
+    }
+  }
+
+  if (_stopSection < _numScheduled)
+    interruptWorkers();
+
+  return;
+}
+
+/*********************************************************************************************/
+
+const bool TestSuite::Dispatcher::afterStop
+(
+  const Unit& unit
+)
+const
+
+/*
+This method returns true if "unit" comes after the chunk that stops testing, so that its
+results will be discarded.
+*/
+
+{
+  return (unit.section > _stopSection) || ((unit.section == _stopSection) &&
+    (unit.chunk > _stopChunk));
+}
+
+/*********************************************************************************************/
+
+void TestSuite::Dispatcher::interruptWorkers()
+
+/*
+This method sends "SIGUSR1" to each worker whose chunk won't count (because it's after the
+chunk that stops testing, or because testing has been cancelled), so that it stops applying it.
+Each worker is only sent it once per chunk.
+*/
+
+{
+  for (unsigned int i = 0U; i < _numWorkers; ++i)
+  {
+    Unit *const unit = _workers[i].unit;
+
+    if ((unit != NULL) && !unit->interrupted && (_workers[i].pid > 0) &&
+      ((TestSuite::_cancelled != 0) || afterStop(*unit)))
+    {
+      unit->interrupted = true;
+      kill(_workers[i].pid, SIGUSR1);
+    }
+  }
+
+  return;
+}
+
+/*********************************************************************************************/
+
+const unsigned int TestSuite::Dispatcher::numReady
+(
+  const SectionState& state
+)
+const
+
+/*
+This method returns how many of a section's chunks, from its first, have been done.
+*/
+
+{
+  const Unit*  current  = state.units;
+  unsigned int numReady = 0U;
+
+  while ((current != NULL) && (current->chunk == numReady))
+  {
+    ++numReady;
+    current = current->next;
+  }
+
+  return numReady;
+}
+
+/*********************************************************************************************/
+
+void TestSuite::Dispatcher::emitReady()
+
+/*
+This method logs the sections, in order, whose results are complete.
+*/
+
+{
+  bool ready = true;                                 // is the next section's result complete?
+
+  while (ready && (_nextEmit <= _stopSection) && (_nextEmit < _numScheduled))
+  {
+    const SectionState& state = _sections[_nextEmit];
+    unsigned int        limit = noChunk;             // no. of chunks that count
+
+    if (!state.redo && state.fullyRead)
+      limit = state.numChunks;
+
+    if (state.abortChunk != noChunk)
+      limit = state.abortChunk + 1U;
+
+    if ((_nextEmit == _stopSection) && (_stopChunk + 1U < limit))
+      limit = _stopChunk + 1U;
+
+    ready = !state.redo && (limit != noChunk) && (numReady(state) >= limit);
+
+    if (ready)
+    {
+      emit(_nextEmit, limit);
+      ++_nextEmit;
+
+      if (_nextEmit > _stopSection)
+        _nextEmit = _numScheduled;
+    }
+  }
+
+  return;
+}
+
+/*********************************************************************************************/
+
+void TestSuite::Dispatcher::emit
+(
+  const unsigned long int section,
+  const unsigned int      numChunks          // no. of its chunks (from the first) that count
+)
+
+/*
+This method logs a section's results and adds them to the results of the tests performed,
+exactly as "TestSuite::runTest()" would have.
+*/
+
+{
+  SectionState& state = _sections[section];
+  CaseTally     total;                                  // the results of the whole section
+  const Unit*   current = state.units;
+
+  total.numCases        = 0U;
+  total.numFailedCases  = 0U;
+  total.firstFailedCase = 0U;
+  total.firstFailedLine = 0UL;
+  total.abortTest       = false;
+  total.abortAll        = false;
+  total.readExtra       = false;
+  total.numDuplicates   = 0U;
+  total.duration        = 0.0;
+
+  if (_suite._logArchive != NULL)
+    _suite._logArchive->mark(state.test->name(), 0U);
+
+  _suite.logTestHeader(*state.test);
+
+  for (; (current != NULL) && (current->chunk < numChunks); current = current->next)
+  {
+    _suite.log().write(current->log, (long)current->logLength);
+
+    if (_suite._history != NULL)
+      _suite._history->addRelayed(state.test->name(), current->cases, current->casesLength);
+
+    if (total.firstFailedCase == 0U)
+    {
+      total.firstFailedCase = current->tally.firstFailedCase;
+      total.firstFailedLine = current->tally.firstFailedLine;
+    }
+
+    total.numCases       += current->tally.numCases;
+    total.numFailedCases += current->tally.numFailedCases;
+    total.abortTest       = total.abortTest || current->tally.abortTest;
+    total.abortAll        = total.abortAll || current->tally.abortAll;
+    total.duration       += current->tally.duration;
+  }
+
+  if ((section == _stopSection) && _stopCancelled)
+    _suite.cancelTesting();
+
+  _suite.addTally(*state.test, total);
+  deleteUnits(state);
+
+  return;
+}
+
+/*********************************************************************************************/
+
+void TestSuite::Dispatcher::deleteUnits
+(
+  SectionState& state
+)
+
+{
+  while (state.units != NULL)
+  {
+    Unit *const victim = state.units;
+
+    state.units = victim->next;
+    deleteUnit(victim);
+  }
+
+  return;
+}
+
+/*********************************************************************************************/
+
+void TestSuite::Dispatcher::deleteUnit
+(
+  Unit *const unit
+)
+
+{
+  delete[] unit->text;
+  delete[] unit->log;
+  delete[] unit->cases;
+  delete unit;
+
+  return;
+}
+
+// ============================================================================================
+// STATIC FUNCTION DEFINITIONS
+// ============================================================================================
+
+/*********************************************************************************************/
+
+static const bool readAll
+(
+  const int    fd,
+  void *const  buffer,
+  const size_t length
+)
+
+/*
+This function reads exactly "length" bytes from "fd", and returns false if it can't.
+*/
+
+{
+  size_t numRead = 0U;
+  bool   ok      = true;
+
+  while (ok && (numRead < length))
+  {
+    const ssize_t result = read(fd, (char*)buffer + numRead, length - numRead);
+
+    if (result > 0)
+      numRead += (size_t)result;
+    else
+      ok = (result < 0) && (errno == EINTR);
+  }
+
+  return ok;
+}
+
+/*********************************************************************************************/
+
+static const bool writeAll
+(
+  const int         fd,
+  const void *const buffer,
+  const size_t      length
+)
+
+/*
+This function writes exactly "length" bytes to "fd", and returns false if it can't.
+*/
+
+{
+  size_t numWritten = 0U;
+  bool   ok         = true;
+
+  while (ok && (numWritten < length))
+  {
+    const ssize_t result = write(fd, (const char*)buffer + numWritten, length - numWritten);
+
+    if (result > 0)
+      numWritten += (size_t)result;
+    else
+      ok = (result < 0) && (errno == EINTR);
+  }
+
+  return ok;
+}
+
+/*********************************************************************************************/
+
+static void onInterrupt
+(
+  int
+)
+
+/*
+This function is a worker process's "SIGUSR1" handler.  It cancels the chunk being applied.
+*/
+
+{
+  TestSuite::cancel();
+  return;
+}
+
+#endif
@@ -0,0 +1,506 @@
+// ============================================================================================
+//
+// SOURCE FILE:  profiler.cpp
+//
+// ============================================================================================
+
+// ============================================================================================
+// DESCRIPTION
+// ============================================================================================
+
+/*
+This file implements "TestSuite::Profiler", a sampling profiler that attributes each sample to
+the test case that was being applied when it was taken.  It shows why a test is slow straight
+from a normal run, without setting up an external profiler for each suspect:
+
+  TestSuite::Profiler profiler;
+
+  test.setProfiler(&profiler);
+  profiler.start();                         // 997 samples per second of processor time
+  test.all();
+  profiler.stop();
+
+  ofstream folded("profile.folded");
+
+  profiler.write(folded);                   // or profiler.write(folded, "slowTest")
+
+The output is in the "folded stacks" format that flame graph tools read:  one line for each
+distinct stack, with its frames separated by semicolons (outermost first) and followed by the
+number of samples in which it was seen.  The first two frames are the test name and test case
+number (e.g. "parseDate;case 12;main;TestSuite::all();...").
+
+Samples are taken by a "SIGPROF" timer, so they're spread over processor time rather than
+elapsed time, and only samples taken while a test method is running are kept.  The signal
+handler only copies the stack's return addresses into memory that was allocated beforehand;
+they're turned into function names by "write()".  Functions that the dynamic linker can't name
+(e.g. static functions, or any function if the program wasn't linked with "-rdynamic") are
+shown as "<file>+0x<offset>".  If the memory fills up then further samples are counted by
+"numDropped()" but not kept.
+
+Only one profiler can be sampling at a time.  Test cases applied by worker processes (see
+"setWorkers()") aren't sampled.  Test names aren't copied, so "write()" has to be called before
+any module whose tests were sampled is unloaded.
+
+This file uses "setitimer()", "backtrace()" and "dladdr()" and is therefore only compiled if
+"TESTSUITE_POSIX" is defined.
+*/
+
+// ============================================================================================
+// INCLUDE FILES
+// ============================================================================================
+
+#ifdef FAT_FILENAMES
+  #include "testsuit.h"
+#else
+  #include "testsuite.h"
+#endif
+
+#ifdef TESTSUITE_POSIX
+
+#ifdef FAT_FILENAMES
+  #include <strstrea.h>
+#else
+  #include <strstream.h>
+#endif
+
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <sys/time.h>
+#include <execinfo.h>
+#include <dlfcn.h>
+
+#ifdef __GNUC__
+  #include <cxxabi.h>
+#endif
+
+// ============================================================================================
+// STATIC CONSTANTS
+// ============================================================================================
+
+static const unsigned int maxFrames  = 64U;  // the deepest stack that's kept
+static const unsigned int skipFrames = 2U;   // the signal handler and the signal trampoline
+static const unsigned int headerSize = 3U;   // test name, test case no. and no. of frames
+
+// ============================================================================================
+// STATIC FUNCTION DECLARATIONS
+// ============================================================================================
+
+static const char *const symbolize(const void *const);
+static int               compareAddresses(const void*, const void*);
+static int               compareStrings(const void*, const void*);
+
+// ============================================================================================
+// STATIC MEMBER INITIALIZATIONS FOR TESTSUITE::PROFILER CLASS
+// ============================================================================================
+
+TestSuite::Profiler* volatile TestSuite::Profiler::_active = NULL;
+
+// ============================================================================================
+// PUBLIC METHOD DEFINITIONS FOR TESTSUITE CLASS
+// ============================================================================================
+
+/*********************************************************************************************/
+
+void TestSuite::setProfiler
+(
+  Profiler *const profiler      // where the test case being applied is noted (or NULL)
+)
+
+/*
+This method makes this object tell "profiler" which test case is being applied, so that its
+samples can be attributed to test cases (or stop telling it, if "profiler" is NULL).  See
+"profiler.cpp".
+
+POSTCONDITIONS:
+"profiler" will be told about every test case that's applied.
+*/
+
+{
+  assertInvariants();
+
+  _profiler = profiler;
+
+  assertInvariants();
+  return;
+}
+
+// ============================================================================================
+// METHOD DEFINITIONS FOR TESTSUITE::PROFILER
+// ============================================================================================
+
+/*********************************************************************************************/
+
+TestSuite::Profiler::Profiler
+(
+  const unsigned long int capacity    // how many return addresses can be kept, in total
+):
+
+/*
+This is the constructor for class "TestSuite::Profiler".  All the memory that samples are kept
+in is allocated here, because none can be allocated while a sample is being taken.
+
+PRECONDITIONS:
+"capacity" can't be 0UL.
+*/
+
+  _pool(new void*[capacity]),
+  _capacity(capacity),
+  _used(0UL),
+  _numSamples(0UL),
+  _numDropped(0UL),
+  _testName(NULL),
+  _caseNum(0U)
+
+{
+  assert(_pool != NULL);
+  assert(_capacity > 0UL);
+
+  return;
+}
+
+/*********************************************************************************************/
+
+TestSuite::Profiler::~Profiler()
+{
+  stop();
+  delete[] _pool;
+
+  return;
+}
+
+/*********************************************************************************************/
+
+const bool TestSuite::Profiler::start
+(
+  const unsigned int frequency          // no. of samples per second of processor time
+)
+
+/*
+This method starts taking samples.
+
+PRECONDITIONS:
+"frequency" must be from 1U to 1000000U, and no other profiler can be sampling.
+
+POSTCONDITIONS:
+True is returned if sampling has started.
+*/
+
+{
+  assert((frequency > 0U) && (frequency <= 1000000U));
+  assert((_active == NULL) || (_active == this));
+
+  const unsigned long int period = 1000000UL / frequency;      // microseconds between samples
+  void*                   frames[4];
+  struct sigaction        action;
+  itimerval               timer;
+
+  /*
+  "backtrace()" can allocate memory the first time it's called (to load the unwinder), which
+  mustn't happen inside the signal handler, so it's called once here first.
+  */
+
+  backtrace(frames, 4);
+
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = takeSample;
+  action.sa_flags   = SA_RESTART;
+  sigemptyset(&action.sa_mask);
+
+  timer.it_interval.tv_sec  = (long)(period / 1000000UL);
+  timer.it_interval.tv_usec = (long)(period % 1000000UL);
+  timer.it_value            = timer.it_interval;
+
+  _active = this;
+
+  const bool started = (sigaction(SIGPROF, &action, NULL) == 0) &&
+                         (setitimer(ITIMER_PROF, &timer, NULL) == 0);
+
+  if (!started)
+    _active = NULL;
+
+  return started;
+}
+
+/*********************************************************************************************/
+
+void TestSuite::Profiler::stop()
+
+/*
+This method stops taking samples.  The samples taken so far are kept.
+*/
+
+{
+  if (_active == this)
+  {
+    struct sigaction action;
+    itimerval        timer;
+
+    memset(&timer, 0, sizeof(timer));
+    setitimer(ITIMER_PROF, &timer, NULL);
+
+    // a signal could still be pending, and the default action for "SIGPROF" is to terminate
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = SIG_IGN;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGPROF, &action, NULL);
+
+    _active = NULL;
+  }
+
+  return;
+}
+
+/*********************************************************************************************/
+
+void TestSuite::Profiler::write
+(
+  ostream&          report,             // where the folded stacks are written
+  const char *const testName            // the test to write them for (or NULL for every test)
+)
+const
+
+/*
+This method writes the samples taken while "testName" (or any test) was being applied, as
+folded stacks -- see "profiler.cpp".
+
+The return addresses in all of the samples are collected, sorted and named once each; then each
+sample's stack is written out as a line of text, and the lines are sorted so that identical
+stacks can be counted.
+
+PRECONDITIONS:
+The tests that were sampled must still exist.
+*/
+
+{
+  unsigned long int numSelected  = 0UL;    // no. of samples for "testName"
+  unsigned long int numAddresses = 0UL;    // no. of return addresses in them
+  unsigned long int position     = 0UL;    // iterates through "_pool"
+
+  for (position = 0UL; position < _used; position += headerSize + numFrames(position))
+  {
+    if ((testName == NULL) || (strcmp((const char*)_pool[position], testName) == 0))
+    {
+      ++numSelected;
+      numAddresses += numFrames(position);
+    }
+  }
+
+  const void**       addresses = new const void*[numAddresses + 1UL];   // sorted, unique
+  const char**       names     = new const char*[numAddresses + 1UL];   // of "addresses"
+  const char**       lines     = new const char*[numSelected + 1UL];    // one for each sample
+  unsigned long int  numUnique = 0UL;                   // no. of entries in use in "addresses"
+  unsigned long int  numLines  = 0UL;                   // no. of entries in use in "lines"
+
+  assert((addresses != NULL) && (names != NULL) && (lines != NULL));
+
+  for (position = 0UL; position < _used; position += headerSize + numFrames(position))
+  {
+    if ((testName == NULL) || (strcmp((const char*)_pool[position], testName) == 0))
+    {
+      for (unsigned long int i = 0UL; i < numFrames(position); ++i)
+        addresses[numUnique++] = _pool[position + headerSize + i];
+    }
+  }
+
+  qsort(addresses, numUnique, sizeof(const void*), compareAddresses);
+
+  if (numUnique > 0UL)
+  {
+    unsigned long int numKept = 1UL;
+
+    for (unsigned long int i = 1UL; i < numUnique; ++i)
+    {
+      if (addresses[i] != addresses[numKept - 1UL])
+        addresses[numKept++] = addresses[i];
+    }
+
+    numUnique = numKept;
+  }
+
+  for (unsigned long int i = 0UL; i < numUnique; ++i)
+    names[i] = symbolize(addresses[i]);
+
+  for (position = 0UL; position < _used; position += headerSize + numFrames(position))
+  {
+    if ((testName == NULL) || (strcmp((const char*)_pool[position], testName) == 0))
+    {
+      ostrstream line;
+
+      line << (const char*)_pool[position] << ";case " <<
+        (unsigned long int)_pool[position + 1U];
+
+      for (unsigned long int i = numFrames(position); i > skipFrames; --i)
+      {
+        const void *const address = _pool[position + headerSize + i - 1UL];
+        const void **const found  = (const void**)bsearch(&address, addresses, numUnique,
+                                      sizeof(const void*), compareAddresses);
+
+        assert(found != NULL);
+        line << ';' << names[found - addresses];
+      }
+
+      line << '\0';
+      lines[numLines++] = line.str();
+    }
+  }
+
+  qsort(lines, numLines, sizeof(const char*), compareStrings);
+
+  for (unsigned long int i = 0UL; i < numLines; )
+  {
+    unsigned long int count = 1UL;                        // no. of samples with the same stack
+
+    while ((i + count < numLines) && (strcmp(lines[i], lines[i + count]) == 0))
+      ++count;
+
+    report << lines[i] << ' ' << count << endl;
+    i += count;
+  }
+
+  for (unsigned long int i = 0UL; i < numLines; ++i)
+    delete[] (char*)lines[i];
+
+  for (unsigned long int i = 0UL; i < numUnique; ++i)
+    delete[] (char*)names[i];
+
+  delete[] lines;
+  delete[] names;
+  delete[] addresses;
+
+  return;
+}
+
+/*********************************************************************************************/
+
+void TestSuite::Profiler::takeSample
+(
+  int
+)
+
+/*
+This method is the "SIGPROF" handler.  It copies the stack's return addresses into "_pool",
+along with the test case being applied, and does nothing else -- not even allocate memory --
+because almost nothing else is safe in a signal handler.
+*/
+
+{
+  Profiler *const   profiler = _active;
+  const char *const testName = (profiler != NULL ? profiler->_testName : (const char*)NULL);
+
+  if (testName != NULL)
+  {
+    const int               savedErrno = errno;
+    const unsigned long int used       = profiler->_used;
+
+    if (used + headerSize + maxFrames + skipFrames > profiler->_capacity)
+      ++profiler->_numDropped;
+    else
+    {
+      void **const sample    = profiler->_pool + used;
+      const int    numFrames = backtrace(sample + headerSize, (int)(maxFrames + skipFrames));
+
+      sample[0] = (void*)testName;
+      sample[1] = (void*)(unsigned long int)profiler->_caseNum;
+      sample[2] = (void*)(unsigned long int)numFrames;
+
+      profiler->_used = used + headerSize + (unsigned long int)numFrames;
+      ++profiler->_numSamples;
+    }
+
+    errno = savedErrno;
+  }
+
+  return;
+}
+
+// ============================================================================================
+// STATIC FUNCTION DEFINITIONS
+// ============================================================================================
+
+/*********************************************************************************************/
+
+static const char *const symbolize
+(
+  const void *const address             // a return address
+)
+
+/*
+This function returns the name of the function that "address" returns into, as a string that
+the caller must de-allocate.  Semicolons (which separate frames) are replaced by colons.
+*/
+
+{
+  Dl_info    info;
+  ostrstream name;
+
+  // a return address can be just past the end of the calling function, so look one byte back
+
+  const bool        located = (dladdr((const char*)address - 1, &info) != 0);
+  const char *const found   = (located ? info.dli_sname : (const char*)NULL);  // mangled name
+
+  if (found != NULL)
+  {
+    #ifdef __GNUC__
+      int         status    = -1;
+      char *const demangled = abi::__cxa_demangle(found, NULL, NULL, &status);
+
+      if ((status == 0) && (demangled != NULL))
+        name << demangled;
+      else
+        name << found;
+
+      free(demangled);
+    #else
+      name << found;
+    #endif
+  }
+  else if (located && (info.dli_fname != NULL) && (info.dli_fbase != NULL))
+  {
+    const char *const slash = strrchr(info.dli_fname, '/');
+
+    name << (slash != NULL ? slash + 1 : info.dli_fname) << "+0x" << hex <<
+      (unsigned long int)((const char*)address - (const char*)info.dli_fbase) << dec;
+  }
+  else
+    name << "0x" << hex << (unsigned long int)address << dec;
+
+  name << '\0';
+
+  char *const text = name.str();
+
+  for (char* current = strchr(text, ';'); current != NULL; current = strchr(current, ';'))
+    *current = ':';
+
+  return text;
+}
+
+/*********************************************************************************************/
+
+static int compareAddresses
+(
+  const void* first,
+  const void* second
+)
+
+{
+  const unsigned long int a = (unsigned long int)*(const void *const *)first;
+  const unsigned long int b = (unsigned long int)*(const void *const *)second;
+
+  return (a < b ? -1 : (a > b ? 1 : 0));
+}
+
+/*********************************************************************************************/
+
+static int compareStrings
+(
+  const void* first,
+  const void* second
+)
+
+{
+  return strcmp(*(const char *const *)first, *(const char *const *)second);
+}
+
+#endif
@@ -0,0 +1,518 @@
+// ============================================================================================
+//
+// SOURCE FILE:  server.cpp
+//
+// ============================================================================================
+
+// ============================================================================================
+// DESCRIPTION
+// ============================================================================================
+
+/*
+This file implements "TestSuite::serve()", which turns a "TestSuite" object into a long-lived
+server.  Starting a test program and indexing a large test data stream can take far longer than
+the tests that are actually wanted (e.g. by an editor or a pre-commit hook), so a server keeps
+the registered test objects, their fixtures and the index of the test data stream in memory and
+performs whatever tests are requested of it.
+
+"serve(istream&, ostream&)" handles a single session:  it reads requests, one per line, from an
+input stream and sends each reply (i.e. everything that would otherwise have been logged) to an
+output stream.  It only uses ANSI C/C++ routines.
+
+"serve(const char *const)" listens on a Unix-domain socket and handles one session per
+connection, one connection at a time.  It needs POSIX and is only compiled if "TESTSUITE_POSIX"
+is defined.
+*/
+
+// ============================================================================================
+// REQUESTS
+// ============================================================================================
+
+/*
+Each request is a single line of text.  Words are separated by whitespace.
+
+one <test name>                       -- same as "one(testName)"
+one <test name> <test case no.>       -- same as "one(testName, caseNum)"
+group <test name> [<test name> ...]   -- same as "group(numTestNames, testNames)"
+tagged <expression>                   -- same as "tagged(expression)"
+shard <shard no.> <no. of shards>     -- same as "shard(shardNum, numShards)"
+all                                   -- same as "all()"
+list                                  -- same as "list()"
+index                                 -- same as "index()"; send after the test data changes
+load <module path>                    -- same as "load(path)" (only if "TESTSUITE_POSIX")
+unload <module path>                  -- same as "unload(path)" (only if "TESTSUITE_POSIX")
+reload <module path>                  -- same as "reload(path)"; send after a module is rebuilt
+quit                                  -- ends the session
+stop                                  -- ends the session and stops the server
+
+Blank lines and lines starting with two slashes are ignored.  Every reply (including the reply
+to a request that couldn't be understood) ends with whatever "logEndOfReply()" sends, so that
+clients can tell where one reply ends and the next begins.
+*/
+
+// ============================================================================================
+// INCLUDE FILES
+// ============================================================================================
+
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdlib.h>
+
+#ifdef FAT_FILENAMES
+  #include <strstrea.h>
+#else
+  #include <strstream.h>
+#endif
+
+#ifdef TESTSUITE_POSIX
+  #include <errno.h>
+  #include <signal.h>
+  #include <unistd.h>
+  #include <sys/socket.h>
+  #include <sys/un.h>
+#endif
+
+#ifdef FAT_FILENAMES
+  #include "testsuit.h"
+#else
+  #include "testsuite.h"
+#endif
+
+// ============================================================================================
+// STATIC FUNCTION DECLARATIONS
+// ============================================================================================
+
+static char *const        readRequest(istream&);
+static const unsigned int splitWords(char *const, const char** const, const unsigned int);
+
+// ============================================================================================
+// FDBUFFER CLASS DECLARATION
+// ============================================================================================
+
+#ifdef TESTSUITE_POSIX
+
+/*
+This is a "streambuf" that reads from and writes to a file descriptor (i.e. a connected
+socket).  Input and output are buffered separately.
+*/
+
+class FdBuffer:
+  public streambuf
+{
+  public:
+                FdBuffer(const int);
+                ~FdBuffer()
+                  {sync(); return;}
+
+  protected:
+    virtual int overflow(int = EOF);
+    virtual int underflow();
+    virtual int sync();
+
+  private:
+    enum
+    {
+      bufferSize = 4096
+    };
+
+    const int _fd;                         // the file descriptor to read from and write to
+    char      _input[bufferSize];          // characters read but not yet taken from the buffer
+    char      _output[bufferSize];         // characters put into the buffer but not yet written
+};
+
+#endif
+
+// ============================================================================================
+// PUBLIC METHOD DEFINITIONS FOR TESTSUITE CLASS
+// ============================================================================================
+
+/*********************************************************************************************/
+
+const bool TestSuite::serve
+(
+  istream& requests,                                   // source of requests (one per line)
+  ostream& replies                                     // where the replies are sent
+)
+
+/*
+This method handles a single session by performing each request read from "requests" and
+sending its reply to "replies".  See "REQUESTS", above.
+
+The test data stream is indexed first if it hasn't been already, and the index is kept for the
+next session.
+
+PRECONDITIONS:
+"requests" and "replies" must be open streams.
+
+POSTCONDITIONS:
+Every request up to the end of "requests" (or a "quit" or "stop" request) will have been
+performed.  True is returned if the session ended with a "stop" request.
+*/
+
+{
+  assertInvariants();
+
+  ostream *const log        = _log;             // where results are logged between sessions
+  bool           endSession = false;            // has a "quit" or "stop" request been read?
+  bool           stop       = false;            // has a "stop" request been read?
+  char*          request    = readRequest(requests);
+
+  _log = &replies;
+  sections();
+
+  while (!endSession && (request != NULL))
+  {
+    const unsigned int maxWords = (unsigned int)strlen(request) / 2U + 1U;
+    const char** const words    = new const char*[maxWords];      // the words in "request"
+    char *const        text     = new char[strlen(request) + 1U]; // "request" before splitting
+
+    assert(words != NULL);
+    assert(text != NULL);
+    strcpy(text, request);
+
+    const unsigned int numWords = splitWords(request, words, maxWords);
+
+    if ((numWords > 0U) && (strncmp(words[0], "//", 2U) != 0))
+    {
+      if ((strcmp(words[0], "one") == 0) && (numWords == 2U))
+        one(words[1]);
+      else if ((strcmp(words[0], "one") == 0) && (numWords == 3U) && (atoi(words[2]) > 0))
+        one(words[1], (unsigned int)atoi(words[2]));
+      else if ((strcmp(words[0], "group") == 0) && (numWords > 1U))
+        group(numWords - 1U, words + 1);
+      else if ((strcmp(words[0], "tagged") == 0) && (numWords > 1U))
+        tagged(text + (words[1] - request));           // the expression can contain spaces
+      else if ((strcmp(words[0], "shard") == 0) && (numWords == 3U) &&
+        (atoi(words[1]) >= 0) && (atoi(words[1]) < atoi(words[2])))
+      {
+        shard((unsigned int)atoi(words[1]), (unsigned int)atoi(words[2]));
+      }
+      else if ((strcmp(words[0], "all") == 0) && (numWords == 1U))
+        all();
+      else if ((strcmp(words[0], "list") == 0) && (numWords == 1U))
+        list();
+      else if ((strcmp(words[0], "index") == 0) && (numWords == 1U))
+        index();
+      #ifdef TESTSUITE_POSIX
+        else if ((strcmp(words[0], "load") == 0) && (numWords == 2U))
+          load(words[1]);
+        else if ((strcmp(words[0], "unload") == 0) && (numWords == 2U))
+          unload(words[1]);
+        else if ((strcmp(words[0], "reload") == 0) && (numWords == 2U))
+          reload(words[1]);
+      #endif
+      else if ((strcmp(words[0], "quit") == 0) && (numWords == 1U))
+        endSession = true;
+      else if ((strcmp(words[0], "stop") == 0) && (numWords == 1U))
+      {
+        endSession = true;
+        stop       = true;
+      }
+      else
+        logBadRequest(words[0]);
+
+      logEndOfReply();
+      replies.flush();
+    }
+
+    delete[] text;
+    delete[] words;
+    delete[] request;
+    request = (endSession ? NULL : readRequest(requests));
+  }
+
+  delete[] request;
+  _log = log;
+
+  assertInvariants();
+  return stop;
+}
+
+/*********************************************************************************************/
+
+#ifdef TESTSUITE_POSIX
+
+void TestSuite::serve
+(
+  const char *const socketPath              // the path of the Unix-domain socket to listen on
+)
+
+/*
+This method listens on a Unix-domain socket at "socketPath" and handles a session (see
+"serve(istream&, ostream&)") for each connection, one at a time, until a "stop" request is
+received.  Any existing file at "socketPath" is replaced, and it's removed again when this
+method returns.
+
+"SIGPIPE" is ignored while serving so that a client that disconnects early doesn't stop the
+server.
+
+PRECONDITIONS:
+"socketPath" can't be NULL and must be short enough to fit in a "sockaddr_un".
+
+POSTCONDITIONS:
+The server will have stopped, or a message will have been logged if it couldn't be started.
+*/
+
+{
+  assertInvariants();
+  assert(socketPath != NULL);
+
+  sockaddr_un address;                                       // where to listen for connections
+
+  assert(strlen(socketPath) < sizeof(address.sun_path));
+
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strncpy(address.sun_path, socketPath, sizeof(address.sun_path) - 1U);
+
+  const int listener = socket(AF_UNIX, SOCK_STREAM, 0);      // accepts connections
+
+  unlink(socketPath);
+
+  if ((listener < 0) || (bind(listener, (sockaddr*)&address, sizeof(address)) != 0) ||
+    (listen(listener, SOMAXCONN) != 0))
+  {
+    log() << "*** Can't listen on \"" << socketPath << "\":  " << strerror(errno) << " ***" <<
+      endl << endl;
+  }
+  else
+  {
+    void (*const sigpipeHandler)(int) = signal(SIGPIPE, SIG_IGN);
+    bool stop = false;                                  // has a "stop" request been received?
+
+    while (!stop)
+    {
+      const int connection = accept(listener, NULL, NULL);
+
+      if (connection >= 0)
+      {
+        FdBuffer buffer(connection);
+        istream  requests(&buffer);
+        ostream  replies(&buffer);
+
+        stop = serve(requests, replies);
+        replies.flush();
+        close(connection);
+      }
+      else if (errno != EINTR)
+      {
+        log() << "*** Can't accept connections on \"" << socketPath << "\":  " <<
+          strerror(errno) << " ***" << endl << endl;
+        stop = true;
+      }
+    }
+
+    signal(SIGPIPE, sigpipeHandler);
+    unlink(socketPath);
+  }
+
+  if (listener >= 0)
+    close(listener);
+
+  assertInvariants();
+  return;
+}
+
+#endif
+
+// ============================================================================================
+// PROTECTED METHOD DEFINITIONS FOR TESTSUITE CLASS
+// ============================================================================================
+
+/*********************************************************************************************/
+
+void TestSuite::logBadRequest
+(
+  const char *const request     // the first word of the request that wasn't understood
+)
+const
+
+/*
+This method sends a bad-request message to "report()".
+*/
+
+{
+  assert(request != NULL);
+
+  log() << "*** \"" << request << "\" is not a valid request. ***" << endl;
+  return;
+}
+
+/*********************************************************************************************/
+
+void TestSuite::logEndOfReply() const
+
+/*
+This method sends an end-of-reply message to "report()".
+
+It's called by "serve()" after each request has been performed.
+*/
+
+{
+  log() << "*** End of reply ***" << endl;
+  return;
+}
+
+// ============================================================================================
+// METHOD DEFINITIONS FOR FDBUFFER CLASS
+// ============================================================================================
+
+#ifdef TESTSUITE_POSIX
+
+/*********************************************************************************************/
+
+FdBuffer::FdBuffer
+(
+  const int fd
+):
+
+  _fd(fd)
+
+{
+  setg(_input, _input, _input);
+  setp(_output, _output + bufferSize);
+  return;
+}
+
+/*********************************************************************************************/
+
+int FdBuffer::overflow
+(
+  int character
+)
+
+{
+  int result = (sync() == 0 ? 0 : EOF);
+
+  if ((result != EOF) && (character != EOF))
+  {
+    *pptr() = (char)character;
+    pbump(1);
+    result  = character;
+  }
+
+  return result;
+}
+
+/*********************************************************************************************/
+
+int FdBuffer::underflow()
+{
+  int result = EOF;
+
+  if (gptr() < egptr())
+    result = (unsigned char)*gptr();
+  else
+  {
+    ssize_t numRead;
+
+    do
+      numRead = read(_fd, _input, bufferSize);
+    while ((numRead < 0) && (errno == EINTR));
+
+    if (numRead > 0)
+    {
+      setg(_input, _input, _input + numRead);
+      result = (unsigned char)*gptr();
+    }
+  }
+
+  return result;
+}
+
+/*********************************************************************************************/
+
+int FdBuffer::sync()
+{
+  const char* next   = pbase();
+  bool        failed = false;
+
+  while (!failed && (next < pptr()))
+  {
+    const ssize_t numWritten = write(_fd, next, (size_t)(pptr() - next));
+
+    if (numWritten > 0)
+      next += numWritten;
+    else
+      failed = (errno != EINTR);
+  }
+
+  setp(_output, _output + bufferSize);
+  return (failed ? -1 : 0);
+}
+
+#endif
+
+// ============================================================================================
+// STATIC FUNCTION DEFINITIONS
+// ============================================================================================
+
+/*********************************************************************************************/
+
+static char *const readRequest
+(
+  istream& requests
+)
+
+{
+  char* request = NULL;
+
+  if (requests.good())
+  {
+    char inputChar;
+
+    requests.get(inputChar);
+    if (requests.good())
+    {
+      ostrstream requestAsStream;
+
+      while (requests.good() && (inputChar != '\n'))
+      {
+        requestAsStream.put(inputChar);
+        requests.get(inputChar);
+      }
+
+      requestAsStream.put('\0');
+      request = requestAsStream.str();
+
+      assert(request != NULL);
+    }
+  }
+
+  return request;
+}
+
+/*********************************************************************************************/
+
+static const unsigned int splitWords
+(
+  char *const        text,
+  const char** const words,
+  const unsigned int maxWords
+)
+
+{
+  assert(text != NULL);
+  assert(words != NULL);
+
+  unsigned int numWords = 0U;
+  char*        position = text;
+
+  while (*position != '\0')
+  {
+    while ((*position != '\0') && isspace((unsigned char)*position))
+      *position++ = '\0';
+
+    if (*position != '\0')
+    {
+      assert(numWords < maxWords);
+      words[numWords++] = position;
+
+      while ((*position != '\0') && !isspace((unsigned char)*position))
+        ++position;
+    }
+  }
+
+  return numWords;
+}
@@ -73,6 +73,7 @@ indeterminate).
   #include <strstream.h>
 #endif
 
+#include <stdio.h>
 #include <string.h>
 #include <ctype.h>
 
@@ -86,11 +87,19 @@ indeterminate).
 // STATIC FUNCTION DECLARATIONS
 // ============================================================================================
 
-static char *const        newString(const char *const);
 static const char *const startOfData(const char *const);
 static const bool         isTestName(const char *const);
-static const char *const extractTestName(const char *const);
+static char *const        trimTestName(char *const);
 static const bool         isComment(const char *const);
+static const unsigned long hashChar(const unsigned long, const char);
+static const unsigned long hashLine(istream&, const unsigned long);
+
+// ============================================================================================
+// STATIC CONSTANTS
+// ============================================================================================
+
+static const unsigned long hashBasis = 2166136261UL;     // FNV-1a offset basis
+static const unsigned long hashPrime = 16777619UL;       // FNV-1a prime
 
 // ============================================================================================
 // METHOD DEFINITIONS FOR TESTSUITE::TESTDATARAW
@@ -104,7 +113,8 @@ TestSuite::TestDataRaw::TestDataRaw
 ):
 
   _dataStream(&dataStream),
-  _lineCounter(0UL)
+  _lineCounter(0UL),
+  _numReads(0UL)
 
 {
   assert(_dataStream != NULL);
@@ -134,6 +144,8 @@ const char *const TestSuite::TestDataRaw::readLine()
 
   char* line = NULL;
 
+  ++_numReads;
+
   if (_dataStream->good())
   {
     char inputChar;
@@ -213,7 +225,7 @@ const char *const TestSuite::TestData::readTestName()
 
     if (isTestName(cookedLine))
     {
-      testName = extractTestName(cookedLine);
+      testName = trimTestName(newString(cookedLine + 1));
       assert(testName != NULL);
 
       delete[] (char*)line;
@@ -262,6 +274,173 @@ const char *const TestSuite::TestData::readTestCase()
   return testCase;
 }
 
+/*********************************************************************************************/
+
+const TestSuite::Section *const TestSuite::TestData::indexSections()
+
+/*
+This method scans the whole test data stream and returns a list of its sections in the order in
+which they appear.  It is the caller's responsibility to eventually de-allocate the list.
+
+Only the test names are copied -- test cases, comments and blank lines are recognized by their
+first non-whitespace characters and skipped without being copied, so the stream is indexed
+about as fast as it can be read.  Since there's no way to tell a test case from the extra
+information that its test method will read, both are counted as test cases.
+
+The text of each section's test cases (without leading whitespace) is hashed as it's skipped so
+that changes to a section can be detected by comparing indexes.
+
+POSTCONDITIONS:
+A list of sections is returned (which will be NULL if there are none) and the stream will be
+positioned at its end.
+*/
+
+{
+  if (_lastLineRead != NULL)
+  {
+    delete[] (char*)_lastLineRead;
+    _lastLineRead = NULL;
+  }
+
+  reset();
+
+  Section* sections = NULL;                               // the first section in the stream
+  Section* current  = NULL;                               // the last section found so far
+  int      nextChar = _dataStream->peek();                // first unread character of a line
+
+  while (nextChar != EOF)
+  {
+    ++_lineCounter;
+
+    while ((nextChar != EOF) && (nextChar != '\n') && isspace(nextChar))
+    {
+      _dataStream->get();
+      nextChar = _dataStream->peek();
+    }
+
+    if (nextChar == ':')
+    {
+      --_lineCounter;                                     // readLine() counts it instead
+
+      const char *const line     = readLine();
+      const char *const testName = trimTestName(newString(line + 1));
+
+      assert(testName != NULL);
+
+      Section *const section = new Section(testName, _dataStream->tellg(), _lineCounter);
+
+      assert(section != NULL);
+      delete[] (char*)testName;
+      delete[] (char*)line;
+
+      if (current == NULL)
+        sections = section;
+      else
+        current->_next = section;
+
+      current = section;
+    }
+    else if (nextChar != EOF)
+    {
+      _dataStream->get();
+
+      const bool blank   = (nextChar == '\n');
+      const bool comment = (nextChar == '/') && (_dataStream->peek() == '/');
+
+      if (!blank && !comment && (current != NULL))
+      {
+        ++current->_numCases;
+        current->_hash = hashLine(*_dataStream, hashChar(current->_hash, (char)nextChar));
+      }
+      else if (!blank)
+        _dataStream->ignore(INT_MAX, '\n');
+    }
+
+    nextChar = _dataStream->peek();
+  }
+
+  return sections;
+}
+
+/*********************************************************************************************/
+
+void TestSuite::TestData::seek
+(
+  const Section& section                             // a section from "indexSections()"
+)
+
+/*
+This method positions the test data stream so that the next call to "readTestCase()" will read
+the first test case in "section".
+*/
+
+{
+  assert(_dataStream != NULL);
+
+  if (_lastLineRead != NULL)
+  {
+    delete[] (char*)_lastLineRead;
+    _lastLineRead = NULL;
+  }
+
+  _dataStream->clear();
+  _dataStream->seekg(section.offset());
+  _lineCounter = section.lineCounter();
+
+  return;
+}
+
+/*********************************************************************************************/
+
+void TestSuite::TestData::redirect
+(
+  istream&                dataStream,     // the stream to read test cases from from now on
+  const unsigned long int lineCounter     // the line number of the line before its first
+)
+
+/*
+This method makes the test data stream read from "dataStream" instead, numbering its lines from
+"lineCounter" + 1.  A worker process uses it to read the test cases it's handed (see
+"parallel.cpp").
+*/
+
+{
+  if (_lastLineRead != NULL)
+  {
+    delete[] (char*)_lastLineRead;
+    _lastLineRead = NULL;
+  }
+
+  _dataStream  = &dataStream;
+  _lineCounter = lineCounter;
+
+  return;
+}
+
+// ============================================================================================
+// METHOD DEFINITIONS FOR TESTSUITE::SECTION CLASS
+// ============================================================================================
+
+/*********************************************************************************************/
+
+TestSuite::Section::Section
+(
+  const char *const       testName,
+  const streampos         offset,
+  const unsigned long int lineCounter
+):
+
+  _name(newString(testName)),
+  _offset(offset),
+  _lineCounter(lineCounter),
+  _numCases(0UL),
+  _hash(hashBasis),
+  _next(NULL)
+
+{
+  return;
+}
+
 // ============================================================================================
 // METHOD DEFINITIONS FOR TESTSUITE::TESTCASE CLASS
 // ============================================================================================
@@ -292,9 +471,171 @@ TestSuite::TestCase::TestCase
 
 /*********************************************************************************************/
 
-TestSuite::Test::Test()
+TestSuite::Test::Test
+(
+  const char *const tagList
+):
+
+  _tags(0UL),
+  _virtualClock(NULL),
+  _tokenizer(NULL)
+
+{
+  TestSuite::registerTest(this, tagList);
+  return;
+}
+
+/*********************************************************************************************/
+
+TestSuite::Test::~Test()
+{
+  TestSuite::unregisterTest(this);
+  return;
+}
+
+// ============================================================================================
+// METHOD DEFINITIONS FOR TESTSUITE::RUNRESULT CLASS
+// ============================================================================================
+
+/*********************************************************************************************/
+
+TestSuite::RunResult::RunResult():
+
+  _firstTest(NULL),
+  _lastTest(NULL),
+  _records(NULL),
+  _capacity(0UL),
+  _numCases(0UL),
+  _numFailedCases(0UL),
+  _numDuplicates(0UL),
+  _allAborted(false),
+  _cancelled(false),
+  _duration(0.0)
+
+{
+  return;
+}
+
+/*********************************************************************************************/
+
+const TestSuite::RunResult::TestRecord *const TestSuite::RunResult::test
+(
+  const char *const testName
+)
+const
+
+/*
+This method returns the record for the test named "testName", or NULL if it wasn't performed.
+*/
+
+{
+  assert(testName != NULL);
+
+  const unsigned long int number = _names.find(testName);
+
+  return (number < _names.numNames() ? _records[number] : NULL);
+}
+
+/*********************************************************************************************/
+
+void TestSuite::RunResult::reset()
+{
+  while (_firstTest != NULL)
+  {
+    TestRecord *const victim = _firstTest;
+
+    _firstTest = _firstTest->_next;
+    delete victim;
+  }
+
+  _names.clear();
+  delete[] _records;
+
+  _records        = NULL;
+  _capacity       = 0UL;
+  _lastTest       = NULL;
+  _numCases       = 0UL;
+  _numFailedCases = 0UL;
+  _numDuplicates  = 0UL;
+  _allAborted     = false;
+  _cancelled      = false;
+  _duration       = 0.0;
+
+  return;
+}
+
+/*********************************************************************************************/
+
+TestSuite::RunResult::TestRecord& TestSuite::RunResult::record
+(
+  const Test& test
+)
+
+/*
+This method returns the record for "test", appending a new one if "test" hasn't been performed
+yet.  Records are found through "_names", which numbers them in the order they were added.
+*/
+
+{
+  assert(test.name() != NULL);
+
+  const unsigned long int numRecords = _names.numNames();
+  const unsigned long int number     = _names.number(test.name());
+  TestRecord*             current    = (number < numRecords ? _records[number] : NULL);
+
+  if (current == NULL)
+  {
+    if (number == _capacity)
+    {
+      TestRecord **const larger = new TestRecord*[_capacity * 2UL + 64UL];
+
+      for (unsigned long int i = 0UL; i < number; ++i)
+        larger[i] = _records[i];
+
+      delete[] _records;
+      _records  = larger;
+      _capacity = _capacity * 2UL + 64UL;
+    }
+
+    current = new TestRecord(test.name());
+    assert(current != NULL);
+
+    _records[number] = current;
+
+    if (_lastTest == NULL)
+      _firstTest = current;
+    else
+      _lastTest->_next = current;
+
+    _lastTest = current;
+  }
+
+  return *current;
+}
+
+// ============================================================================================
+// METHOD DEFINITIONS FOR TESTSUITE::RUNRESULT::TESTRECORD CLASS
+// ============================================================================================
+
+/*********************************************************************************************/
+
+TestSuite::RunResult::TestRecord::TestRecord
+(
+  const char *const testName
+):
+
+  _name(newString(testName)),
+  _numSections(0UL),
+  _numCases(0UL),
+  _numFailedCases(0UL),
+  _numDuplicates(0UL),
+  _aborted(false),
+  _duration(0.0),
+  _firstFailedCase(0U),
+  _firstFailedLine(0UL),
+  _next(NULL)
+
 {
-  TestSuite::registerTest(this);
   return;
 }
 
@@ -319,29 +660,459 @@ TestSuite::ListNode::ListNode
 }
 
 // ============================================================================================
-// STATIC FUNCTION DEFINITIONS
+// METHOD DEFINITIONS FOR TESTSUITE::CASESET
+// ============================================================================================
+
+/*********************************************************************************************/
+
+TestSuite::CaseSet::CaseSet():
+
+/*
+This is the constructor for class "CaseSet", which remembers which test cases have been applied
+to which tests (see "SKIPPING DUPLICATE TEST CASES" in "testsuite.cpp").  It's an open
+addressing hash table of copies of the test cases' text.
+*/
+
+  _entries(NULL),
+  _capacity(0UL),
+  _numEntries(0UL),
+  _extraReaders(NULL)
+
+{
+  return;
+}
+
+/*********************************************************************************************/
+
+const bool TestSuite::CaseSet::insert
+(
+  const Test&       test,
+  const char *const testCase            // the text of a test case for "test"
+)
+
+/*
+This method adds "testCase" to the test cases that have been applied to "test" and returns
+"true", or returns "false" if it's already there (i.e. it's a duplicate).  Nothing is added
+for a test that's been marked by "markReadsExtra()", and "true" is returned.
+
+Entries are found by hash, but the text is compared too, so a hash collision can't make a test
+case be skipped.
+*/
+
+{
+  assert(testCase != NULL);
+
+  bool isNew = true;                            // isn't "testCase" a duplicate?
+
+  if (!readsExtra(test))
+  {
+    unsigned long int hash = hashBasis;         // hash of the test's name and "testCase"
+    const char*       current;
+    Entry*            entry;
+
+    for (current = test.name(); *current != '\0'; current++)
+      hash = hashChar(hash, *current);
+
+    for (current = testCase, hash = hashChar(hash, '\n'); *current != '\0'; current++)
+      hash = hashChar(hash, *current);
+
+    if ((_numEntries + 1UL) * 4UL > _capacity * 3UL)
+      grow();
+
+    entry = &_entries[hash % _capacity];
+
+    while ((entry->text != NULL) &&
+      ((entry->hash != hash) || (entry->test != &test) || (strcmp(entry->text, testCase) != 0)))
+      entry = (entry == &_entries[_capacity - 1UL] ? _entries : entry + 1);
+
+    isNew = (entry->text == NULL);
+
+    if (isNew)
+    {
+      entry->test = &test;
+      entry->hash = hash;
+      entry->text = newString(testCase);
+      _numEntries++;
+    }
+  }
+
+  return isNew;
+}
+
+/*********************************************************************************************/
+
+void TestSuite::CaseSet::markReadsExtra
+(
+  const Test& test                      // a test whose test method read extra lines
+)
+
+/*
+This method notes that "test"'s test method reads extra lines from the test data stream, so
+that none of its test cases are treated as duplicates from now on.
+*/
+
+{
+  if (!readsExtra(test))
+    _extraReaders = new ListNode(&test, _extraReaders);
+
+  return;
+}
+
+/*********************************************************************************************/
+
+void TestSuite::CaseSet::clear()
+
+/*
+This method forgets every test case and every test marked by "markReadsExtra()".
+*/
+
+{
+  for (unsigned long int i = 0UL; i < _capacity; ++i)
+    delete[] (char*)_entries[i].text;
+
+  delete[] _entries;
+  _entries    = NULL;
+  _capacity   = 0UL;
+  _numEntries = 0UL;
+
+  while (_extraReaders != NULL)
+  {
+    ListNode *const victim = _extraReaders;
+
+    _extraReaders = victim->next();
+    delete victim;
+  }
+
+  return;
+}
+
+/*********************************************************************************************/
+
+const bool TestSuite::CaseSet::readsExtra
+(
+  const Test& test
+)
+const
+
+/*
+This method returns "true" if "test" has been marked by "markReadsExtra()".
+*/
+
+{
+  const ListNode* current = _extraReaders;
+
+  while ((current != NULL) && (current->test() != &test))
+    current = current->next();
+
+  return (current != NULL);
+}
+
+/*********************************************************************************************/
+
+void TestSuite::CaseSet::grow()
+
+/*
+This method doubles the size of the hash table (or allocates it, if it's empty) and re-inserts
+the entries.
+*/
+
+{
+  Entry *const            oldEntries  = _entries;
+  const unsigned long int oldCapacity = _capacity;
+
+  _capacity = (oldCapacity == 0UL ? 64UL : oldCapacity * 2UL);
+  _entries  = new Entry[_capacity];
+
+  for (unsigned long int i = 0UL; i < _capacity; ++i)
+    _entries[i].text = NULL;
+
+  for (unsigned long int i = 0UL; i < oldCapacity; ++i)
+  {
+    if (oldEntries[i].text != NULL)
+    {
+      Entry* entry = &_entries[oldEntries[i].hash % _capacity];
+
+      while (entry->text != NULL)
+        entry = (entry == &_entries[_capacity - 1UL] ? _entries : entry + 1);
+
+      *entry = oldEntries[i];
+    }
+  }
+
+  delete[] oldEntries;
+  return;
+}
+
 // ============================================================================================
+// METHOD DEFINITIONS FOR TESTSUITE::NAMETABLE
+// ============================================================================================
+
+/*********************************************************************************************/
+
+TestSuite::NameTable::NameTable():
+
+/*
+This is the constructor for class "NameTable", which numbers names (usually test names) in the
+order in which they're added, so that records can refer to a name by its number.  It's an open
+addressing hash table of the numbers (plus one, so that 0UL means an empty slot), kept at most
+half full.
+*/
+
+  _names(NULL),
+  _numNames(0UL),
+  _capacity(0UL),
+  _table(NULL),
+  _tableSize(0UL),
+  _lastName(0UL)
+
+{
+  return;
+}
 
 /*********************************************************************************************/
 
-static char *const newString
+const unsigned long int TestSuite::NameTable::number
 (
-  const char *const source
+  const char *const name
 )
 
+/*
+This method returns the number of "name", adding a copy of it first if it isn't in the table.
+Names tend to come in long runs of the same one, so the last one returned is checked first.
+*/
+
 {
-  assert(source != NULL);
+  assert(name != NULL);
+
+  if ((_lastName >= _numNames) || (strcmp(_names[_lastName], name) != 0))
+  {
+    if ((_numNames + 1UL) * 2UL > _tableSize)
+    {
+      delete[] _table;
+      _tableSize = (_tableSize == 0UL ? 256UL : _tableSize * 2UL);
+      _table     = new unsigned long int[_tableSize];
+
+      for (unsigned long int i = 0UL; i < _tableSize; ++i)
+        _table[i] = 0UL;
+
+      for (unsigned long int i = 0UL; i < _numNames; ++i)
+        _table[slot(_names[i])] = i + 1UL;
+    }
 
-  char *const duplicateString = new char[strlen(source) + 1U];
+    const unsigned long int position = slot(name);
 
-  if (duplicateString != NULL)
-    strcpy(duplicateString, source);
+    if (_table[position] == 0UL)
+    {
+      if (_numNames == _capacity)
+      {
+        char **const larger = new char*[_capacity * 2UL + 64UL];
+
+        for (unsigned long int i = 0UL; i < _numNames; ++i)
+          larger[i] = _names[i];
+
+        delete[] _names;
+        _names    = larger;
+        _capacity = _capacity * 2UL + 64UL;
+      }
+
+      _names[_numNames] = newString(name);
+      _table[position]  = ++_numNames;
+    }
 
-  return duplicateString;
+    _lastName = _table[position] - 1UL;
+  }
+
+  return _lastName;
 }
 
 /*********************************************************************************************/
 
+const unsigned long int TestSuite::NameTable::find
+(
+  const char *const name
+)
+const
+
+/*
+This method returns the number of "name", or "numNames()" if it isn't in the table.
+*/
+
+{
+  assert(name != NULL);
+
+  const unsigned long int position = (_tableSize == 0UL ? 0UL : slot(name));
+
+  return ((_tableSize == 0UL) || (_table[position] == 0UL) ? _numNames :
+    _table[position] - 1UL);
+}
+
+/*********************************************************************************************/
+
+void TestSuite::NameTable::clear()
+
+/*
+This method empties the table.
+*/
+
+{
+  for (unsigned long int i = 0UL; i < _numNames; ++i)
+    delete[] _names[i];
+
+  delete[] _names;
+  delete[] _table;
+
+  _names     = NULL;
+  _numNames  = 0UL;
+  _capacity  = 0UL;
+  _table     = NULL;
+  _tableSize = 0UL;
+  _lastName  = 0UL;
+
+  return;
+}
+
+/*********************************************************************************************/
+
+const unsigned long int TestSuite::NameTable::slot
+(
+  const char *const name
+)
+const
+
+/*
+This method returns where "name" is in "_table", or the empty slot where it belongs.
+*/
+
+{
+  unsigned long int hash = hashBasis;
+  unsigned long int position;
+
+  for (const char* current = name; *current != '\0'; current++)
+    hash = hashChar(hash, *current);
+
+  position = hash % _tableSize;
+
+  while ((_table[position] != 0UL) && (strcmp(_names[_table[position] - 1UL], name) != 0))
+    position = (position + 1UL) % _tableSize;
+
+  return position;
+}
+
+// ============================================================================================
+// METHOD DEFINITIONS FOR TESTSUITE::TAGEXPRESSION
+// ============================================================================================
+
+/*********************************************************************************************/
+
+TestSuite::TagExpression::TagExpression():
+
+  _program(NULL),
+  _length(0U),
+  _capacity(0U),
+  _depth(0U),
+  _maxDepth(0U)
+
+{
+  return;
+}
+
+/*********************************************************************************************/
+
+void TestSuite::TagExpression::append
+(
+  const Opcode opcode,
+  const TagSet mask
+)
+
+{
+  if (_length == _capacity)
+  {
+    const unsigned int newCapacity = (_capacity == 0U ? 8U : _capacity * 2U);
+    Instruction *const newProgram  = new Instruction[newCapacity];
+
+    assert(newProgram != NULL);
+
+    for (unsigned int i = 0U; i < _length; ++i)
+      newProgram[i] = _program[i];
+
+    delete[] _program;
+    _program  = newProgram;
+    _capacity = newCapacity;
+  }
+
+  _program[_length].opcode = opcode;
+  _program[_length].mask   = mask;
+  ++_length;
+
+  if (opcode == pushTag)
+    ++_depth;
+  else if (opcode != notOp)
+  {
+    assert(_depth >= 2U);
+    --_depth;
+  }
+
+  if (_depth > _maxDepth)
+    _maxDepth = _depth;
+
+  return;
+}
+
+/*********************************************************************************************/
+
+const bool TestSuite::TagExpression::matches
+(
+  const TagSet tags
+)
+const
+
+/*
+The evaluation stack is kept in a "TagSet", one bit per entry, with the top of the stack in
+bit 0.  "fits()" guarantees that the stack never grows past the bits that are available.
+*/
+
+{
+  assert(_length > 0U);
+  assert(_maxDepth <= maxTags);
+
+  TagSet stack = 0UL;
+
+  for (unsigned int i = 0U; i < _length; ++i)
+  {
+    const Instruction& instruction = _program[i];
+    TagSet             top;
+
+    switch (instruction.opcode)
+    {
+      case pushTag:
+        stack = (stack << 1) | ((tags & instruction.mask) != 0UL ? 1UL : 0UL);
+        break;
+
+      case notOp:
+        stack ^= 1UL;
+        break;
+
+      case andOp:
+        top   = stack & 1UL;
+        stack = (stack >> 1) & (top | ~1UL);
+        break;
+
+      case orOp:
+        top   = stack & 1UL;
+        stack = (stack >> 1) | top;
+        break;
+    }
+  }
+
+  return ((stack & 1UL) != 0UL);
+}
+
+// ============================================================================================
+// STATIC FUNCTION DEFINITIONS
+// ============================================================================================
+
+/*********************************************************************************************/
+
 static const char *const startOfData
 (
   const char *const text
@@ -374,17 +1145,12 @@ static const bool isTestName
 
 /*********************************************************************************************/
 
-static const char *const extractTestName
+static char *const trimTestName
 (
-  const char *const text
+  char *const testName                  // a copy of a test name line, without the colon
 )
 
 {
-  assert(text != NULL);
-  assert(text[0] == ':');
-
-  char* testName = newString(text + 1);
-
   assert(testName != NULL);
 
   size_t length = strlen(testName);
@@ -410,3 +1176,42 @@ static const bool isComment
 
   return (strncmp(stringToCheck, commentId, commentIdLength) == 0);
 }
+
+/*********************************************************************************************/
+
+static const unsigned long hashChar
+(
+  const unsigned long hash,
+  const char          character
+)
+
+{
+  return ((hash ^ (unsigned char)character) * hashPrime);
+}
+
+/*********************************************************************************************/
+
+static const unsigned long hashLine
+(
+  istream&            stream,
+  const unsigned long hash
+)
+
+/*
+This function hashes the rest of the current line in "stream", including the newline.  The
+newline is consumed.  Characters are taken straight from the stream's buffer since this is
+called for every test case line when indexing.
+*/
+
+{
+  streambuf *const buffer  = stream.rdbuf();
+  unsigned long    newHash = hash;
+  int              inputChar;
+
+  assert(buffer != NULL);
+
+  while (((inputChar = buffer->sbumpc()) != EOF) && (inputChar != '\n'))
+    newHash = hashChar(newHash, (char)inputChar);
+
+  return hashChar(newHash, '\n');
+}
@@ -76,6 +76,149 @@ bitmap) then "testData.readLine()" can be called to read in additional lines fro
 stream.  Human-readable test results (or any useful information) can be shifted out into "log".
 
 The test method's return type is "TestSuite::TestResult".
+
+A test object can also be given tags by defining it with the "TAGGED_TEST()" macro instead.
+The second argument is a string literal of tag names separated by spaces or commas -- like this:
+
+  TAGGED_TEST(anyOtherName, "slow io nightly")
+  {
+    // body of test method goes here.
+    return result;
+  }
+
+Tag names are entered into a tag table as the test objects are registered, and each distinct
+tag name is given its own bit in a "TestSuite::TagSet".  No more than "TestSuite::maxTags"
+distinct tag names can be used by the whole program.
+*/
+
+// ============================================================================================
+// RESULTS
+// ============================================================================================
+
+/*
+The methods that perform tests ("one()", "group()", "tagged()", "shard()", "all()" and
+"update()") return a "TestSuite::RunResult" that describes what happened, so that a program
+that drives the tests can act on the results without reading the log.  It's built up as the
+test cases are applied and contains the total number of test cases applied and failed, whether
+testing was aborted and how long it took, plus a "TestRecord" for each test performed with its
+number of sections, test cases and failed test cases, whether it was aborted, how long it took
+and where its first failed test case is in the test data stream.
+
+The returned object belongs to the "TestSuite" object and is replaced the next time tests are
+performed.  "result()" returns the latest one (e.g. from within "logFooter()").
+
+Durations are measured for whole sections rather than for each test case, so timing adds
+nothing to the cost of very short test cases.  If "TESTSUITE_POSIX" is defined then they're
+elapsed (wall clock) times; otherwise they're processor times from "clock()".
+*/
+
+// ============================================================================================
+// LISTING TESTS WITHOUT PERFORMING THEM
+// ============================================================================================
+
+/*
+"TestSuite::list()" is a dry run:  it indexes the test data stream and logs every section in
+it (with its test name, line number and number of test cases) followed by every registered test
+object (with its total number of sections and test cases).  Sections whose test names haven't
+been registered are logged with "logUnknownTestName()", and registered test objects that have
+no test cases are pointed out.  No test methods are called.
+
+Indexing only copies test names, and the registered test objects are sorted by name once so
+that each section's test object is found by binary search, so listing a very large test data
+stream costs little more than reading it.  Lines of extra information that test methods would
+have read are counted as test cases, since there's no way to tell them apart without calling
+the test methods.
+*/
+
+// ============================================================================================
+// INDEXING THE TEST DATA STREAM
+// ============================================================================================
+
+/*
+Once the test data stream has been indexed -- by "index()", "list()", "shard()" or "serve()" --
+the index is kept and tests are performed by seeking straight to their sections instead of
+reading the whole stream, so the stream must be seekable (i.e. not "cin").  If the stream is
+changed after it has been indexed then "index()" must be called again.
+*/
+
+// ============================================================================================
+// RE-PERFORMING CHANGED SECTIONS
+// ============================================================================================
+
+/*
+Each section in the index carries a hash of the text of its test cases.  "update()" re-indexes
+the test data stream and performs only the sections that are new or whose hash has changed
+since the stream was last indexed, so after editing a large test data file only the edited
+sections are performed again.  A section is matched with its counterpart in the old index by
+its test name and by how many sections for that test name precede it.
+
+"watch()" (see "watch.cpp") calls "update()" every time the test data file is saved.
+*/
+
+// ============================================================================================
+// SELECTING TESTS BY TAG
+// ============================================================================================
+
+/*
+"TestSuite::tagged()" performs every test whose tags satisfy a selection expression such as:
+
+  nightly & !slow
+  (io | net) & !flaky
+
+"!" (not) binds tightest, then "&" (and), then "|" (or), and parentheses can be used for
+grouping.  The expression is compiled once into a short sequence of bit operations over the tag
+table, so deciding whether a test is selected costs the same no matter how many tags or tests
+there are.  Tag names that don't appear in the tag table are logged and never match.
+
+The tag table holds "maxTags" distinct tag names (one for each bit of "TagSet").  Tag names
+declared after it's full aren't given to any test object; "tagged()" and "list()" log them.
+*/
+
+// ============================================================================================
+// FAILURES FIRST AND FAIL-FAST
+// ============================================================================================
+
+/*
+When a change breaks something, it's best to find out in seconds rather than at the end of a
+long "all()".  "TestSuite::setFailuresFirst(n)" makes the methods that perform tests look up
+how many test cases of each test failed in the last "n" runs of the results history (see
+"setHistory()" and "history.cpp") and perform the sections of the tests that failed most often
+first; the other sections follow in their usual order.  This needs the test data stream to be
+indexed, so it's indexed first if necessary (and therefore must be seekable).
+
+The test cases within a section are still applied in order, because a test case can read extra
+lines from the test data stream and only the test method knows how many.  The sections that
+failed recently are usually short enough that their failures still show up quickly.
+
+"TestSuite::setFailFast(true)" makes the first failed test case cancel all testing.
+"TestSuite::cancel()" does the same from outside, e.g. from a "SIGINT" handler or another
+thread -- it only sets a flag, so it's safe to call from a signal handler.  Cancellation is
+checked before each test case is applied, so the test case that's being applied finishes first.
+The results of everything applied before then are logged and returned as usual, with
+"RunResult::cancelled()" set, so the summary is correct for the part that was performed.  The
+flag is cleared when a series of tests that it cancelled finishes, so a "cancel()" that arrives
+between two series cancels the second one rather than being lost.
+*/
+
+// ============================================================================================
+// SKIPPING DUPLICATE TEST CASES
+// ============================================================================================
+
+/*
+Test data files that are generated or merged together often have the same test case more than
+once in a test's sections.  "TestSuite::setSkipDuplicates(true)" makes the methods that perform
+tests hash each test case's text as it's read and skip any test case that's already been
+applied to the same test during the same run.  Skipped test cases keep their numbers (so the
+numbers of the others don't change), aren't counted as applied and aren't logged; their number
+is reported by "logDuplicatesSkipped()" and returned by "RunResult::numDuplicates()" and
+"TestRecord::numDuplicates()".
+
+Whether a test case is a duplicate depends on its line of text only, and the lines that a test
+method reads with "testData().readLine()" can't be skipped without calling it.  Therefore once
+a test method has read extra lines, none of that test's test cases are skipped for the rest of
+the run.  Tests are performed in this process rather than in worker processes (see
+"setWorkers()") while duplicates are being skipped, because the workers couldn't see each
+other's test cases; "logWorkersNotUsed()" says so at the start of each series of tests.
 */
 
 // ============================================================================================
@@ -153,6 +296,7 @@ test "TestSuite" to make sure that it works properly!
 #include <string.h>
 #include <ctype.h>
 #include <stdlib.h>
+#include <time.h>
 
 #ifdef FAT_FILENAMES
   #include "testsuit.h"
@@ -162,12 +306,22 @@ test "TestSuite" to make sure that it works properly!
 
 #include <platform.h>
 
+// ============================================================================================
+// STATIC FUNCTION DECLARATIONS
+// ============================================================================================
+
+static const char *const skipSpaces(const char *const);
+static const bool        isTagChar(const char);
+
 // ============================================================================================
 // STATIC MEMBER INITIALIZATIONS FOR TESTSUITE CLASS
 // ============================================================================================
 
 TestSuite::ListNode* TestSuite::_tests            = NULL;
-bool                 TestSuite::_atExitRegistered = false;
+const char*          TestSuite::_tagNames[]       = {NULL};
+unsigned int         TestSuite::_numTags          = 0U;
+char*                TestSuite::_droppedTags      = NULL;
+volatile sig_atomic_t TestSuite::_cancelled       = 0;
 
 // ============================================================================================
 // PUBLIC METHOD DEFINITIONS FOR TESTSUITE CLASS
@@ -196,8 +350,24 @@ A valid "TestSuite" object is created and ready to test the test objects.
 
   _testData(testData),
   _log(&log),
-  _totalTestCases(0U),
-  _totalFailedTestCases(0U)
+  _sections(NULL),
+  _indexed(false),
+  _firstCase(1U),
+  _lastCase(UINT_MAX),
+  _caseBase(0U),
+  _modules(NULL),
+  _history(NULL),
+  _failureRuns(0U),
+  _failFast(false),
+  _skipDuplicates(false),
+  _logArchive(NULL),
+  _benchmark(NULL),
+  _numWorkers(1U),
+  _chunkSeconds(0.05),
+  #ifdef TESTSUITE_POSIX
+    _profiler(NULL),
+  #endif
+  _startTime(0.0)
 
 {
   assertInvariants();
@@ -206,7 +376,28 @@ A valid "TestSuite" object is created and ready to test the test objects.
 
 /*********************************************************************************************/
 
-void TestSuite::one
+TestSuite::~TestSuite()
+
+/*
+This is the destructor for class "TestSuite".  It de-allocates the index of the test data
+stream (if it was built) and unloads any modules that were loaded by "load()".
+*/
+
+{
+  deleteSections(_sections);
+
+  #ifdef TESTSUITE_POSIX
+    while (_modules != NULL)
+      unload(_modules->path());
+  #endif
+
+  assert(_modules == NULL);
+  return;
+}
+
+/*********************************************************************************************/
+
+const TestSuite::RunResult& TestSuite::one
 (
   const char *const testName                                 // the name of the test to perform
 )
@@ -223,6 +414,7 @@ PRECONDITIONS:
 POSTCONDITIONS:
 All test cases for "testName" in the test data stream (if any) will have been applied to the
 specified test object.
+The results are returned (see "RESULTS", above).
 */
 
 {
@@ -236,15 +428,54 @@ specified test object.
 
   runTests(tests);
   deleteList(tests);
+  finishTesting();
   logFooter();
 
   assertInvariants();
-  return;
+  return _result;
+}
+
+/*********************************************************************************************/
+
+const TestSuite::RunResult& TestSuite::one
+(
+  const char *const  testName,                               // the name of the test to perform
+  const unsigned int caseNum                                 // the test case to apply
+)
+
+/*
+This method performs a single test (whose name is given in "testName") by applying only test
+case number "caseNum" of each of its sections.  The test cases before it are skipped without
+calling the test method, so this isn't suitable for test methods that read extra information
+from the test data stream.
+
+PRECONDITIONS:
+"testName" can't be NULL and "caseNum" can't be 0U.
+
+POSTCONDITIONS:
+Test case "caseNum" of each section for "testName" in the test data stream (if any) will have
+been applied to the specified test object.
+The results are returned (see "RESULTS", above).
+*/
+
+{
+  assertInvariants();
+  assert(testName != NULL);
+  assert(caseNum > 0U);
+
+  _firstCase = caseNum;
+  _lastCase  = caseNum;
+  one(testName);
+  _firstCase = 1U;
+  _lastCase  = UINT_MAX;
+
+  assertInvariants();
+  return _result;
 }
 
 /*********************************************************************************************/
 
-void TestSuite::group
+const TestSuite::RunResult& TestSuite::group
 (
   const char *const firstTestName,                    // the name of the first test to perform
   ...
@@ -263,6 +494,7 @@ PRECONDITIONS:
 POSTCONDITIONS:
 All test cases in the test data stream (if any) will have been applied to the test objects
 specified in the argument list.
+The results are returned (see "RESULTS", above).
 */
 
 {
@@ -282,15 +514,16 @@ specified in the argument list.
 
   runTests(tests);
   deleteList(tests);
+  finishTesting();
   logFooter();
 
   assertInvariants();
-  return;
+  return _result;
 }
 
 /*********************************************************************************************/
 
-void TestSuite::group
+const TestSuite::RunResult& TestSuite::group
 (
   const unsigned int       numTestNames,     // the number of test names in the array
   const char *const *const testNames         // an array of test names of tests to be performed
@@ -309,6 +542,7 @@ either.
 POSTCONDITIONS:
 All test cases in the test data stream (if any) will have been applied to the test objects
 specified in "testNames".
+The results are returned (see "RESULTS", above).
 */
 
 {
@@ -323,183 +557,239 @@ specified in "testNames".
 
   runTests(tests);
   deleteList(tests);
+  finishTesting();
   logFooter();
 
   assertInvariants();
-  return;
+  return _result;
 }
 
 /*********************************************************************************************/
 
-void TestSuite::all()
+const TestSuite::RunResult& TestSuite::tagged
+(
+  const char *const expression                     // selects tests by the tags they were given
+)
 
 /*
-This method performs all the tests by applying their respective test cases to them.
+This method performs all the tests whose tags satisfy "expression" by applying their
+respective test cases to them.  See "SELECTING TESTS BY TAG", above, for the syntax of
+"expression".
 
 Tests are performed in the order in which they appear in the test data stream.
 
 PRECONDITIONS:
-None.
+"expression" can't be NULL.
 
 POSTCONDITIONS:
-All test cases in the test data stream (if any) will have been applied to all registered test
-objects.
+All test cases in the test data stream (if any) will have been applied to the test objects
+whose tags satisfy "expression".  If "expression" isn't valid then it's logged and no tests are
+performed.
+The results are returned (see "RESULTS", above).
 */
 
 {
   assertInvariants();
+  assert(expression != NULL);
 
   prepareForTesting();
   logHeader();
-  runTests(_tests);
+
+  if (_droppedTags != NULL)
+    logDroppedTags(_droppedTags);
+
+  TagExpression compiled;                                   // "expression" as bit operations
+  const char*   position = expression;                      // how much has been compiled
+
+  if (!compileTags(position, compiled) || (*skipSpaces(position) != '\0') || !compiled.fits())
+    logBadTagExpression(expression);
+  else
+  {
+    const ListNode *const tests = getTests(compiled);       // list of tests to perform
+
+    runTests(tests);
+    deleteList(tests);
+  }
+
+  finishTesting();
   logFooter();
 
   assertInvariants();
-  return;
+  return _result;
 }
 
-// ============================================================================================
-// PRIVATE METHOD DEFINITIONS FOR TESTSUITE CLASS
-// ============================================================================================
-
 /*********************************************************************************************/
 
-void TestSuite::registerTest
+const TestSuite::RunResult& TestSuite::shard
 (
-  const Test *const test                                    // the test object to be registered
+  const unsigned int shardNum,                        // which shard to perform (from 0U)
+  const unsigned int numShards                        // how many shards the work is split into
 )
 
 /*
-This method registers tests objects and is called by the "TestSuite::Test" constructor.
+This method performs every section of the test data stream whose position in the stream
+(counting from 0), modulo "numShards", is "shardNum".  Running every shard from 0U to
+"numShards - 1U" (e.g. in separate processes) is equivalent to calling "all()" once.
 
-At the same time, if it hasn't been done yet, the "atExit()" method is registered as a routine
-to be called when the program terminates.
+The test data stream is indexed first if it hasn't been already.
 
 PRECONDITIONS:
-"test" can't be NULL.
+"numShards" can't be 0U and "shardNum" must be less than "numShards".
 
 POSTCONDITIONS:
-The test object "test" is registered and test cases can be applied to it.
+All test cases in the shard's sections will have been applied to their test objects.
+The results are returned (see "RESULTS", above).
 */
 
 {
-  assert(test != NULL);
+  assertInvariants();
+  assert(numShards > 0U);
+  assert(shardNum < numShards);
 
-  if (!_atExitRegistered)
-  {
-    assert(_tests == NULL);
+  prepareForTesting();
+  logHeader();
+  sections();
+  runTests(_tests, shardNum, numShards);
+  finishTesting();
+  logFooter();
 
-    const int status = atexit(atExit);     // resulting status of atexit() registration attempt
+  assertInvariants();
+  return _result;
+}
 
-    assert(status == 0);
-    _atExitRegistered = (status == 0);
-  }
+/*********************************************************************************************/
 
-  _tests = new ListNode(test, _tests);
-  assert(_tests != NULL);
+const TestSuite::RunResult& TestSuite::all()
 
-  return;
+/*
+This method performs all the tests by applying their respective test cases to them.
+
+Tests are performed in the order in which they appear in the test data stream (unless
+"setFailuresFirst()" says otherwise -- see "FAILURES FIRST AND FAIL-FAST", above).
+
+PRECONDITIONS:
+None.
+
+POSTCONDITIONS:
+All test cases in the test data stream (if any) will have been applied to all registered test
+objects.
+The results are returned (see "RESULTS", above).
+*/
+
+{
+  assertInvariants();
+
+  prepareForTesting();
+  logHeader();
+  runTests(_tests);
+  finishTesting();
+  logFooter();
+
+  assertInvariants();
+  return _result;
 }
 
 /*********************************************************************************************/
 
-const TestSuite::Test *const TestSuite::getTest
+void TestSuite::setHistory
 (
-  const char *const     testName,
-  const ListNode *const tests
+  History *const history                        // where test case results are to be recorded
 )
 
 /*
-This function finds the test object in "tests" that has the same name as "testName".
-
-PRECONDITIONS:
-"testName" can't be NULL.
+This method makes this object record the result of every test case it applies in "history"
+(or stop recording them, if "history" is NULL).  Results are only recorded between calls to
+"history->beginRun()" and "history->endRun()" -- see "history.cpp".
 
 POSTCONDITIONS:
-Test object with the same name as "testName" is returned, or NULL is returned if no such object
-exists in "tests".
+Test case results will be recorded in "history".
 */
 
 {
-  assert(testName != NULL);
-
-  const ListNode* current = tests;                                    // iterates through tests
+  assertInvariants();
 
-  while ((current != NULL) && (strcmp(current->test()->name(), testName) != 0))
-    current = current->next();
+  _history = history;
 
-  return (current != NULL ? current->test() : NULL);
+  assertInvariants();
+  return;
 }
 
 /*********************************************************************************************/
 
-void TestSuite::deleteList
+void TestSuite::setFailuresFirst
 (
-  const ListNode *const list                    // the list of nodes to de-allocate from memory
+  const unsigned int numRuns      // no. of recent runs to look at, or 0U to keep stream order
 )
 
 /*
-This routine de-allocates all "ListNode's" in "list" from memory.
+This method makes this object perform the sections of the tests that failed most often in the
+last "numRuns" runs of its results history first.  See "FAILURES FIRST AND FAIL-FAST", above.
 
 PRECONDITIONS:
 None.
 
 POSTCONDITIONS:
-All "ListNode's" in "list" are de-allocated from memory.  It is an error to dereference "list"
-after this routine exits.
+Sections will be ordered by recent failures whenever a results history has been set.
 */
 
 {
-  const ListNode* current = list;                                      // iterates through list
-
-  while (current != NULL)
-  {
-    const ListNode *const victim = current;  // ListNode for de-allocation in current iteration
+  assertInvariants();
 
-    current = current->next();
-    delete (ListNode*)victim;
-  }
+  _failureRuns = numRuns;
 
+  assertInvariants();
   return;
 }
 
 /*********************************************************************************************/
 
-void TestSuite::atExit()
+void TestSuite::setFailFast
+(
+  const bool failFast                   // should the first failed test case cancel testing?
+)
 
 /*
-This routine de-allocates all "ListNode's" in "_tests" from memory.  It should be called after
-the program has terminated, which means that it must be registered with "atexit()".
+This method makes the first failed test case cancel all testing (or not).  See "FAILURES FIRST
+AND FAIL-FAST", above.
 
 PRECONDITIONS:
 None.
 
 POSTCONDITIONS:
-All "ListNode's" in "_tests" are de-allocated from memory, thus preventing a memory leak when
-the program terminates.
+The first failed test case will cancel testing if "failFast" is true.
 */
 
 {
-  deleteList(_tests);
+  assertInvariants();
+
+  _failFast = failFast;
+
+  assertInvariants();
   return;
 }
 
 /*********************************************************************************************/
 
-void TestSuite::prepareForTesting()
+void TestSuite::setSkipDuplicates
+(
+  const bool skipDuplicates             // should duplicate test cases be skipped?
+)
 
 /*
-This method prepares a "TestSuite" object to perform a series of tests by reseting a few member
-variables and the test data stream.
+This method makes the methods that perform tests skip test cases that have already been applied
+to the same test during the same run (or not).  See "SKIPPING DUPLICATE TEST CASES", above.
+
+PRECONDITIONS:
+None.
+
+POSTCONDITIONS:
+Duplicate test cases will be skipped and counted if "skipDuplicates" is true.
 */
 
 {
   assertInvariants();
 
-  _totalTestCases       = 0U;
-  _totalFailedTestCases = 0U;
-
-  _testData.reset();
+  _skipDuplicates = skipDuplicates;
 
   assertInvariants();
   return;
@@ -507,72 +797,819 @@ variables and the test data stream.
 
 /*********************************************************************************************/
 
-const TestSuite::ListNode *const TestSuite::getTests
-(
-  const char *const firstTestName,                // the first test name to look up
-  va_list&          argList                       // the remaining test names to look up
-)
-const
+void TestSuite::list()
 
 /*
-This method returns a NULL-terminated array of pointers to the test objects specified by the
-arguments.  It is the caller's responsibility to eventually de-allocate the array (but NOT the
-test objects).
-
-"firstTestName" and "argList" are test names for the test objects to be included in the
-returned array ("argList" should refer to a series of "const char *const" types).  Only test
-objects that match these test names will be included.  If no test object can be found then the
-offending test name is logged.
+This method logs the sections in the test data stream and the registered test objects without
+performing any tests.  See "LISTING TESTS WITHOUT PERFORMING THEM", above.
 
 PRECONDITIONS:
-"firstTestName" can't be NULL and "numTestNames" must be greater than zero.  Also,
-"firstTestName" and "argList" together must have as many test names as is specified in
-"numTestNames".
+None.
 
 POSTCONDITIONS:
-A NULL-terminated array of pointers to test objects is returned.
+Every section in the test data stream and every registered test object will have been logged.
 */
 
 {
   assertInvariants();
 
-  ListNode*   tests    = NULL;
-  const char* testName = firstTestName;                  // current test name to look up
+  prepareForTesting();
+  logHeader();
+
+  if (_droppedTags != NULL)
+    logDroppedTags(_droppedTags);
+
+  const Section*    section  = sections();                       // iterates through sections
+  const ListNode*   current  = _tests;                           // iterates through tests
+  unsigned long int numTests = 0UL;                              // no. of registered tests
+
+  for (; current != NULL; current = current->next())
+    ++numTests;
 
   /*
-  This is the main loop.  It iterates through all of the test names, finds their respective
-  test objects (if any) and adds them (if any) to the array to be returned.
+  The registered tests are sorted by name, so that each section's test can be found by binary
+  search and the sections can be totalled for each test in one pass.
   */
 
-  while (testName != NULL)
+  ListedTest *const listed   = new ListedTest[numTests + 1UL];  // the tests, sorted by name
+  unsigned long int position = 0UL;
+
+  for (current = _tests; current != NULL; current = current->next())
   {
-    const Test *const test = getTest(testName, _tests);
+    listed[position].test        = current->test();
+    listed[position].numSections = 0UL;
+    listed[position].numCases    = 0UL;
+    ++position;
+  }
 
-    if (test == NULL)
-      logUnknownTestName(testName);
+  qsort(listed, numTests, sizeof(ListedTest), compareListed);
+
+  for (; section != NULL; section = section->next())
+  {
+    const unsigned long int found = findListed(section->name(), listed, numTests);
+
+    if (found == numTests)
+      logUnknownTestName(section->name());
     else
     {
-      tests = new ListNode(test, tests);
-      assert(tests != NULL);
+      logListedSection(*section, *listed[found].test);
+      ++listed[found].numSections;
+      listed[found].numCases += section->numCases();
     }
+  }
 
-    testName = va_arg(argList, const char*);
+  for (current = _tests; current != NULL; current = current->next())
+  {
+    const ListedTest& entry = listed[findListed(current->test()->name(), listed, numTests)];
+
+    logListedTest(*entry.test, entry.numSections, entry.numCases);
   }
 
-  return tests;
+  delete[] listed;
+
+  logFooter();
+
+  assertInvariants();
+  return;
 }
 
 /*********************************************************************************************/
 
-const TestSuite::ListNode *const TestSuite::getTests
-(
-  const unsigned int       numTestNames,                 // the number of test names to look up
-  const char *const *const testNames                     // the test names to look up
-)
-const
+void TestSuite::index()
 
 /*
-This method returns a NULL-terminated array of pointers to the test objects specified by the
+This method (re-)indexes the test data stream.  It only needs to be called if the test data
+stream has changed since it was last indexed -- see "INDEXING THE TEST DATA STREAM", above.
+
+POSTCONDITIONS:
+The test data stream is indexed, and tests will be performed by seeking straight to their
+sections.
+*/
+
+{
+  assertInvariants();
+
+  deleteSections(_sections);
+  _sections = _testData.indexSections();
+  _indexed  = true;
+
+  assertInvariants();
+  return;
+}
+
+// ============================================================================================
+// PRIVATE METHOD DEFINITIONS FOR TESTSUITE CLASS
+// ============================================================================================
+
+/*********************************************************************************************/
+
+void TestSuite::registerTest
+(
+  Test *const       test,                                   // the test object to be registered
+  const char *const tagList                                 // the tags declared for "test"
+)
+
+/*
+This method registers tests objects and is called by the "TestSuite::Test" constructor.  The
+tag names in "tagList" are entered into the tag table (if they aren't there already) and
+"test" is given the matching tag bits.
+
+The registration lasts until "test" is destroyed -- see "unregisterTest()".
+
+PRECONDITIONS:
+"test" and "tagList" can't be NULL.
+
+POSTCONDITIONS:
+The test object "test" is registered and test cases can be applied to it.
+*/
+
+{
+  assert(test != NULL);
+  assert(tagList != NULL);
+
+  test->_tags = internTags(tagList);
+
+  _tests = new ListNode(test, _tests);
+  assert(_tests != NULL);
+
+  return;
+}
+
+/*********************************************************************************************/
+
+void TestSuite::unregisterTest
+(
+  const Test *const test                                  // the test object to be unregistered
+)
+
+/*
+This method unregisters a test object and is called by the "TestSuite::Test" destructor.  Test
+objects are destroyed when the program terminates or when the module that contains them is
+unloaded (see "modules.cpp"), so the list of registered tests always matches the test objects
+that exist.  The tag table is de-allocated when the last test object is unregistered.
+
+PRECONDITIONS:
+"test" can't be NULL and must be registered.
+
+POSTCONDITIONS:
+"test" is no longer registered.
+*/
+
+{
+  assert(test != NULL);
+
+  ListNode* previous = NULL;                      // the node before "current"
+  ListNode* current  = _tests;                    // iterates through tests
+
+  while ((current != NULL) && (current->test() != test))
+  {
+    previous = current;
+    current  = current->next();
+  }
+
+  assert(current != NULL);
+
+  if (current != NULL)
+  {
+    if (previous == NULL)
+      _tests = current->next();
+    else
+      previous->setNext(current->next());
+
+    delete current;
+  }
+
+  if (_tests == NULL)
+  {
+    while (_numTags > 0U)
+      delete[] (char*)_tagNames[--_numTags];
+
+    delete[] _droppedTags;
+    _droppedTags = NULL;
+  }
+
+  return;
+}
+
+/*********************************************************************************************/
+
+const TestSuite::Test *const TestSuite::getTest
+(
+  const char *const     testName,
+  const ListNode *const tests
+)
+
+/*
+This function finds the test object in "tests" that has the same name as "testName".
+
+PRECONDITIONS:
+"testName" can't be NULL.
+
+POSTCONDITIONS:
+Test object with the same name as "testName" is returned, or NULL is returned if no such object
+exists in "tests".
+*/
+
+{
+  assert(testName != NULL);
+
+  const ListNode* current = tests;                                    // iterates through tests
+
+  while ((current != NULL) && (strcmp(current->test()->name(), testName) != 0))
+    current = current->next();
+
+  return (current != NULL ? current->test() : NULL);
+}
+
+/*********************************************************************************************/
+
+char *const TestSuite::newString
+(
+  const char *const source
+)
+
+/*
+This function returns a copy of "source" on the heap.  It is the caller's responsibility to
+eventually de-allocate it.
+*/
+
+{
+  assert(source != NULL);
+
+  char *const duplicateString = new char[strlen(source) + 1U];
+
+  if (duplicateString != NULL)
+    strcpy(duplicateString, source);
+
+  return duplicateString;
+}
+
+/*********************************************************************************************/
+
+const double TestSuite::timeStamp()
+
+/*
+This routine returns the current time in seconds, measured from an arbitrary point.  If
+"TESTSUITE_POSIX" is defined then it's the elapsed (wall clock) time; otherwise it's processor
+time.
+*/
+
+{
+  #ifdef TESTSUITE_POSIX
+    timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((double)now.tv_sec + (double)now.tv_nsec / 1.0e9);
+  #else
+    return ((double)clock() / (double)CLOCKS_PER_SEC);
+  #endif
+}
+
+/*********************************************************************************************/
+
+void TestSuite::cancel()
+
+/*
+This method cancels the tests that are being performed by every "TestSuite" object, as soon as
+the test cases being applied finish.  It only sets a flag, so it can be called from a signal
+handler or from another thread.  See "FAILURES FIRST AND FAIL-FAST", above.
+*/
+
+{
+  _cancelled = 1;
+  return;
+}
+
+/*********************************************************************************************/
+
+void TestSuite::deleteList
+(
+  const ListNode *const list                    // the list of nodes to de-allocate from memory
+)
+
+/*
+This routine de-allocates all "ListNode's" in "list" from memory.
+
+PRECONDITIONS:
+None.
+
+POSTCONDITIONS:
+All "ListNode's" in "list" are de-allocated from memory.  It is an error to dereference "list"
+after this routine exits.
+*/
+
+{
+  const ListNode* current = list;                                      // iterates through list
+
+  while (current != NULL)
+  {
+    const ListNode *const victim = current;  // ListNode for de-allocation in current iteration
+
+    current = current->next();
+    delete (ListNode*)victim;
+  }
+
+  return;
+}
+
+/*********************************************************************************************/
+
+void TestSuite::deleteSections
+(
+  const Section *const sections           // the list of sections to de-allocate from memory
+)
+
+/*
+This routine de-allocates all "Section's" in "sections" from memory.
+
+POSTCONDITIONS:
+All "Section's" in "sections" are de-allocated from memory.  It is an error to dereference
+"sections" after this routine exits.
+*/
+
+{
+  const Section* current = sections;                               // iterates through sections
+
+  while (current != NULL)
+  {
+    const Section *const victim = current;    // Section for de-allocation in current iteration
+
+    current = current->next();
+    delete (Section*)victim;
+  }
+
+  return;
+}
+
+/*********************************************************************************************/
+
+int TestSuite::compareScheduled
+(
+  const void* first,
+  const void* second
+)
+
+/*
+This method is the comparison function for sorting "ScheduledSection"s with "qsort()":  the
+section with more recent failures comes first, and the one earlier in the index breaks ties.
+*/
+
+{
+  const ScheduledSection *const a = (const ScheduledSection*)first;
+  const ScheduledSection *const b = (const ScheduledSection*)second;
+
+  return (a->numFailures != b->numFailures ? (a->numFailures > b->numFailures ? -1 : 1) :
+    (a->position < b->position ? -1 : (a->position > b->position ? 1 : 0)));
+}
+
+/*********************************************************************************************/
+
+/*********************************************************************************************/
+
+int TestSuite::compareListed
+(
+  const void* first,
+  const void* second
+)
+
+/*
+This method is the comparison function for sorting "ListedTest"s by test name with "qsort()".
+*/
+
+{
+  return strcmp(((const ListedTest*)first)->test->name(),
+    ((const ListedTest*)second)->test->name());
+}
+
+/*********************************************************************************************/
+
+const unsigned long int TestSuite::findListed
+(
+  const char *const       testName,
+  const ListedTest *const listed,       // the tests, sorted by "compareListed()"
+  const unsigned long int numTests      // no. of entries in "listed"
+)
+
+/*
+This method returns the position of the test named "testName" in "listed" by binary search, or
+"numTests" if it isn't there.
+*/
+
+{
+  assert(testName != NULL);
+
+  unsigned long int low  = 0UL;                 // the first entry that could match
+  unsigned long int high = numTests;            // one past the last one
+
+  while (low < high)
+  {
+    const unsigned long int middle = low + (high - low) / 2UL;
+
+    if (strcmp(listed[middle].test->name(), testName) < 0)
+      low = middle + 1UL;
+    else
+      high = middle;
+  }
+
+  return ((low < numTests) && (strcmp(listed[low].test->name(), testName) == 0) ? low :
+    numTests);
+}
+
+const TestSuite::TagSet TestSuite::internTags
+(
+  const char *const tagList              // tag names separated by whitespace and/or commas
+)
+
+/*
+This routine returns the tag bits for the tag names in "tagList", entering any that haven't
+been seen before into the tag table.  Once the tag table is full, new tag names are added to
+"_droppedTags" instead, so that "tagged()" and "list()" can log them, and they aren't given to
+any test object.
+
+PRECONDITIONS:
+"tagList" can't be NULL.
+
+POSTCONDITIONS:
+The tag bits for the tag names in "tagList" that fit in the tag table are returned.
+*/
+
+{
+  assert(tagList != NULL);
+
+  TagSet      tags     = 0UL;
+  const char* position = tagList;                               // iterates through tagList
+
+  while (*position != '\0')
+  {
+    const char* end = position;                                 // end of the current tag name
+
+    while (isTagChar(*end))
+      ++end;
+
+    if (end == position)
+      ++position;
+    else
+    {
+      const size_t length = (size_t)(end - position);
+      int          tagNum = findTag(position, length);          // bit number of the tag
+
+      if ((tagNum < 0) && (_numTags < maxTags))
+      {
+        char *const tagName = new char[length + 1U];
+
+        assert(tagName != NULL);
+        strncpy(tagName, position, length);
+        tagName[length] = '\0';
+
+        tagNum                = (int)_numTags;
+        _tagNames[_numTags++] = tagName;
+      }
+
+      if (tagNum >= 0)
+        tags |= (1UL << tagNum);
+      else
+        dropTag(position, length);
+
+      position = end;
+    }
+  }
+
+  return tags;
+}
+
+/*********************************************************************************************/
+
+const int TestSuite::findTag
+(
+  const char *const tagName,                                 // the tag name to look up
+  const size_t      length                                   // how much of "tagName" to use
+)
+
+/*
+This routine returns the bit number of the first "length" characters of "tagName" in the tag
+table, or -1 if they aren't there.
+*/
+
+{
+  assert(tagName != NULL);
+
+  unsigned int tagNum = 0U;                                  // iterates through _tagNames
+
+  while ((tagNum < _numTags) && ((strncmp(_tagNames[tagNum], tagName, length) != 0) ||
+    (_tagNames[tagNum][length] != '\0')))
+  {
+    ++tagNum;
+  }
+
+  return (tagNum < _numTags ? (int)tagNum : -1);
+}
+
+/*********************************************************************************************/
+
+void TestSuite::dropTag
+(
+  const char *const tagName,                                 // the tag name that didn't fit
+  const size_t      length                                   // how much of "tagName" to use
+)
+
+/*
+This routine adds the first "length" characters of "tagName" to "_droppedTags" (a list of tag
+names separated by spaces) unless they're there already.
+*/
+
+{
+  assert(tagName != NULL);
+
+  const size_t oldLength = (_droppedTags == NULL ? 0U : strlen(_droppedTags));
+  const char*  position  = (_droppedTags == NULL ? "" : _droppedTags);
+  bool         found     = false;                            // is it there already?
+
+  while (!found && (*position != '\0'))
+  {
+    const char* end = position;
+
+    while ((*end != ' ') && (*end != '\0'))
+      ++end;
+
+    found    = (((size_t)(end - position) == length) && (strncmp(position, tagName,
+                 length) == 0));
+    position = (*end == ' ' ? end + 1 : end);
+  }
+
+  if (!found)
+  {
+    char *const newList = new char[oldLength + length + 2U];
+
+    if (_droppedTags == NULL)
+      newList[0] = '\0';
+    else
+    {
+      strcpy(newList, _droppedTags);
+      strcat(newList, " ");
+    }
+
+    strncat(newList, tagName, length);
+    delete[] _droppedTags;
+    _droppedTags = newList;
+  }
+
+  return;
+}
+
+/*********************************************************************************************/
+
+void TestSuite::prepareForTesting()
+
+/*
+This method prepares a "TestSuite" object to perform a series of tests by reseting a few member
+variables and the test data stream.
+*/
+
+{
+  assertInvariants();
+
+  _result.reset();
+  _caseSet.clear();
+  _startTime = timeStamp();
+
+  _testData.reset();
+
+  assertInvariants();
+  return;
+}
+
+/*********************************************************************************************/
+
+const TestSuite::RunResult& TestSuite::update()
+
+/*
+This method re-indexes the test data stream and performs the sections that have changed since
+it was last indexed.  See "RE-PERFORMING CHANGED SECTIONS", above.
+
+If the test data stream hadn't been indexed yet then every section is performed.
+
+PRECONDITIONS:
+None.
+
+POSTCONDITIONS:
+All test cases in new and changed sections will have been applied to their test objects, and
+the new index will be kept.
+The results are returned (see "RESULTS", above).
+*/
+
+{
+  assertInvariants();
+
+  prepareForTesting();
+  logHeader();
+
+  const Section *const oldSections = _sections;               // the index before this update
+  const bool           wasIndexed  = _indexed;
+
+  _sections = _testData.indexSections();
+  _indexed  = true;
+
+  bool               abortAll = false;                      // should all testing be stopped?
+  const Section*     section  = _sections;                  // iterates through the new index
+  const Section*     parallel = oldSections;                // same position in the old index
+  bool               aligned  = wasIndexed;                 // have all test names matched?
+  NameTable          oldNames;                              // the old sections' test names
+  unsigned long int  numOld   = 0UL;                        // no. of sections in the old index
+  unsigned long int  numNames = 0UL;                        // no. of names in "oldNames"
+  unsigned long int* firsts   = NULL;                       // where names start in "byName"
+  unsigned long int* seen     = NULL;                       // no. of sections seen per name
+  const Section**    byName   = NULL;                       // the old sections, grouped by name
+
+  /*
+  As long as the test names in the two indexes match section for section, each section's
+  counterpart is simply the one in the same position.  Once they don't match (i.e. a section
+  has been added, removed or renamed), a section's counterpart is the old section for the same
+  test name that has as many sections for that name before it.  So the old sections are grouped
+  by test name (in order), and the sections for each name in the new index are counted as they
+  go by, which makes finding a counterpart a matter of a hash lookup.
+  */
+
+  if (wasIndexed)
+  {
+    const Section* current;
+
+    for (current = oldSections; current != NULL; current = current->next(), numOld++)
+      oldNames.number(current->name());
+
+    numNames = oldNames.numNames();
+    firsts   = new unsigned long int[numNames + 1UL];
+    seen     = new unsigned long int[numNames + 1UL];
+    byName   = new const Section*[numOld + 1UL];
+
+    for (unsigned long int i = 0UL; i <= numNames; ++i)
+    {
+      firsts[i] = 0UL;
+      seen[i]   = 0UL;
+    }
+
+    for (current = oldSections; current != NULL; current = current->next())
+      firsts[oldNames.find(current->name()) + 1UL]++;
+
+    for (unsigned long int i = 0UL; i < numNames; ++i)
+      firsts[i + 1UL] += firsts[i];
+
+    for (current = oldSections; current != NULL; current = current->next())
+    {
+      const unsigned long int name = oldNames.find(current->name());
+
+      byName[firsts[name] + seen[name]++] = current;
+    }
+
+    for (unsigned long int i = 0UL; i < numNames; ++i)
+      seen[i] = 0UL;
+  }
+
+  while (!abortAll && (section != NULL))
+  {
+    aligned = aligned && (parallel != NULL) && (strcmp(parallel->name(), section->name()) == 0);
+
+    const Test *const       test       = getTest(section->name(), _tests);
+    const unsigned long int name       = oldNames.find(section->name());
+    const unsigned long int occurrence = (name < numNames ? seen[name]++ : 0UL);
+
+    if (test != NULL)
+    {
+      const Section* oldSection = (aligned ? parallel : NULL);   // counterpart in old index
+
+      if (!aligned && (name < numNames) && (occurrence < firsts[name + 1UL] - firsts[name]))
+        oldSection = byName[firsts[name] + occurrence];
+
+      if ((oldSection == NULL) || (oldSection->hash() != section->hash()) ||
+        (oldSection->numCases() != section->numCases()))
+      {
+        _testData.seek(*section);
+        abortAll = !runTest(*test);
+      }
+    }
+
+    section = section->next();
+
+    if (parallel != NULL)
+      parallel = parallel->next();
+  }
+
+  delete[] firsts;
+  delete[] seen;
+  delete[] byName;
+
+  deleteSections(oldSections);
+  finishTesting();
+  logFooter();
+
+  assertInvariants();
+  return _result;
+}
+
+/*********************************************************************************************/
+
+const TestSuite::Section *const TestSuite::sections()
+
+/*
+This method returns the index of the test data stream, building it first if necessary.
+*/
+
+{
+  if (!_indexed)
+    index();
+
+  return _sections;
+}
+
+/*********************************************************************************************/
+
+void TestSuite::finishTesting()
+
+/*
+This method completes "_result" after a series of tests has been performed.  If the series was
+cancelled then the cancellation has been dealt with, so the flag is cleared; otherwise a
+"cancel()" that came after the last test case was applied is left for the next series.
+*/
+
+{
+  assertInvariants();
+
+  _result._duration = timeStamp() - _startTime;
+
+  if (_result._cancelled)
+    _cancelled = 0;
+
+  assertInvariants();
+  return;
+}
+
+/*********************************************************************************************/
+
+const TestSuite::ListNode *const TestSuite::getTests
+(
+  const char *const firstTestName,                // the first test name to look up
+  va_list&          argList                       // the remaining test names to look up
+)
+const
+
+/*
+This method returns a NULL-terminated array of pointers to the test objects specified by the
+arguments.  It is the caller's responsibility to eventually de-allocate the array (but NOT the
+test objects).
+
+"firstTestName" and "argList" are test names for the test objects to be included in the
+returned array ("argList" should refer to a series of "const char *const" types).  Only test
+objects that match these test names will be included.  If no test object can be found then the
+offending test name is logged.
+
+PRECONDITIONS:
+"firstTestName" can't be NULL and "numTestNames" must be greater than zero.  Also,
+"firstTestName" and "argList" together must have as many test names as is specified in
+"numTestNames".
+
+POSTCONDITIONS:
+A NULL-terminated array of pointers to test objects is returned.
+*/
+
+{
+  assertInvariants();
+
+  ListNode*   tests    = NULL;
+  const char* testName = firstTestName;                  // current test name to look up
+
+  /*
+  This is the main loop.  It iterates through all of the test names, finds their respective
+  test objects (if any) and adds them (if any) to the array to be returned.
+  */
+
+  while (testName != NULL)
+  {
+    const Test *const test = getTest(testName, _tests);
+
+    if (test == NULL)
+      logUnknownTestName(testName);
+    else
+    {
+      tests = new ListNode(test, tests);
+      assert(tests != NULL);
+    }
+
+    testName = va_arg(argList, const char*);
+  }
+
+  return tests;
+}
+
+/*********************************************************************************************/
+
+const TestSuite::ListNode *const TestSuite::getTests
+(
+  const unsigned int       numTestNames,                 // the number of test names to look up
+  const char *const *const testNames                     // the test names to look up
+)
+const
+
+/*
+This method returns a NULL-terminated array of pointers to the test objects specified by the
 "testNames".  It is the caller's responsibility to eventually de-allocate the array (but NOT
 the test objects).
 
@@ -622,28 +1659,318 @@ A NULL-terminated array of pointers to test objects is returned.
 
 /*********************************************************************************************/
 
+const TestSuite::ListNode *const TestSuite::getTests
+(
+  const TagExpression& expression               // selects test objects by their tags
+)
+const
+
+/*
+This method returns a list of the registered test objects whose tags satisfy "expression".  It
+is the caller's responsibility to eventually de-allocate the list (but NOT the test objects).
+
+POSTCONDITIONS:
+A list of test objects is returned, which will be NULL if no test objects are selected.
+*/
+
+{
+  assertInvariants();
+
+  ListNode*       tests   = NULL;
+  const ListNode* current = _tests;                                   // iterates through tests
+
+  while (current != NULL)
+  {
+    if (expression.matches(current->test()->tags()))
+    {
+      tests = new ListNode(current->test(), tests);
+      assert(tests != NULL);
+    }
+
+    current = current->next();
+  }
+
+  return tests;
+}
+
+/*********************************************************************************************/
+
+const bool TestSuite::compileTags
+(
+  const char*&   position,                     // where to start compiling; updated on return
+  TagExpression& expression                    // the compiled instructions are appended here
+)
+const
+
+/*
+This method compiles a series of terms separated by "|" from "position" into "expression".  It
+returns false if a syntax error was found.
+*/
+
+{
+  bool valid = compileTagTerm(position, expression);
+
+  position = skipSpaces(position);
+
+  while (valid && (*position == '|'))
+  {
+    ++position;
+    valid = compileTagTerm(position, expression);
+
+    if (valid)
+      expression.append(TagExpression::orOp);
+
+    position = skipSpaces(position);
+  }
+
+  return valid;
+}
+
+/*********************************************************************************************/
+
+const bool TestSuite::compileTagTerm
+(
+  const char*&   position,                     // where to start compiling; updated on return
+  TagExpression& expression                    // the compiled instructions are appended here
+)
+const
+
+/*
+This method compiles a series of factors separated by "&" from "position" into "expression".
+It returns false if a syntax error was found.
+*/
+
+{
+  bool valid = compileTagFactor(position, expression);
+
+  position = skipSpaces(position);
+
+  while (valid && (*position == '&'))
+  {
+    ++position;
+    valid = compileTagFactor(position, expression);
+
+    if (valid)
+      expression.append(TagExpression::andOp);
+
+    position = skipSpaces(position);
+  }
+
+  return valid;
+}
+
+/*********************************************************************************************/
+
+const bool TestSuite::compileTagFactor
+(
+  const char*&   position,                     // where to start compiling; updated on return
+  TagExpression& expression                    // the compiled instructions are appended here
+)
+const
+
+/*
+This method compiles a single tag name, a negated factor or a parenthesized expression from
+"position" into "expression".  It returns false if a syntax error was found.
+
+Unknown tag names are logged and compiled as a tag that no test has.
+*/
+
+{
+  bool valid = true;
+
+  position = skipSpaces(position);
+
+  if (*position == '!')
+  {
+    ++position;
+    valid = compileTagFactor(position, expression);
+
+    if (valid)
+      expression.append(TagExpression::notOp);
+  }
+  else if (*position == '(')
+  {
+    ++position;
+    valid = compileTags(position, expression) && (*position == ')');
+
+    if (valid)
+      ++position;
+  }
+  else
+  {
+    const char* end = position;                                 // end of the tag name
+
+    while (isTagChar(*end))
+      ++end;
+
+    valid = (end != position);
+
+    if (valid)
+    {
+      const size_t length = (size_t)(end - position);
+      const int    tagNum = findTag(position, length);          // bit number of the tag
+
+      if (tagNum >= 0)
+        expression.append(TagExpression::pushTag, 1UL << tagNum);
+      else
+      {
+        char *const tagName = new char[length + 1U];
+
+        assert(tagName != NULL);
+        strncpy(tagName, position, length);
+        tagName[length] = '\0';
+
+        logUnknownTagName(tagName);
+        delete[] tagName;
+
+        expression.append(TagExpression::pushTag, 0UL);
+      }
+
+      position = end;
+    }
+  }
+
+  return valid;
+}
+
+/*********************************************************************************************/
+
 void TestSuite::runTests
 (
-  const ListNode *const tests
+  const ListNode *const tests,
+  const unsigned int    shardNum,             // which sections of "_testData" to perform...
+  const unsigned int    numShards             // ...when "_testData" is split into this many
 )
 
 /*
 This method applies the test data in "_testData" to the tests in "tests".  Any tests that are
 mentioned in "_testData" but haven't been registered will be logged.
 
+If "_testData" has been indexed then only the sections for "tests" are read, by seeking
+straight to them, and "shardNum" and "numShards" select which of them are performed.  If
+sections are to be ordered by recent failures then "_testData" is indexed first and the
+selected sections are sorted before any are performed.  If there's more than one worker
+process (and duplicate test cases aren't being skipped and nothing is being benchmarked) then
+"_testData" is indexed first, too, and the selected sections are handed to "runInParallel()".
+Otherwise "_testData" is read from beginning to end and "numShards" must be 1U.
+
 PRECONDITIONS:
 "tests" can't be NULL, and there must be a NULL sentinal in the array that "tests" points to.
 
-POSTCONDITIONS:
-All test cases in the test data stream (if any) will have been applied to the test objects
-pointed to by "tests".
-*/
+POSTCONDITIONS:
+All test cases in the test data stream (if any) will have been applied to the test objects
+pointed to by "tests".
+*/
+
+{
+  assertInvariants();
+  assert(shardNum < numShards);
+  assert(_indexed || (numShards == 1U));
+
+  const bool failuresFirst = (_history != NULL) && (_failureRuns > 0U);
+  const bool inParallel    = (_numWorkers > 1U) && !_skipDuplicates &&
+                               (_benchmark == NULL);
+
+  if ((tests != NULL) && (_numWorkers > 1U) && !inParallel)
+    logWorkersNotUsed(_skipDuplicates ? "duplicate test cases are being skipped" :
+      "test cases are being benchmarked");
+
+  if (tests == NULL)
+    *_log << "*** No valid test names were provided! ***" << endl << endl;
+  else if (_indexed && !failuresFirst && !inParallel)
+  {
+    bool           abortAll   = false;                      // should all testing be stopped?
+    const Section* section    = _sections;                  // iterates through the index
+    unsigned int   sectionNum = 0U;                         // position of "section" in index
+
+    while (!abortAll && (section != NULL))
+    {
+      const Test *const test = ((sectionNum % numShards) == shardNum ?
+        getTest(section->name(), tests) : NULL);
+
+      if (test != NULL)
+      {
+        _testData.seek(*section);
+        abortAll = !runTest(*test);
+      }
+
+      section = section->next();
+      ++sectionNum;
+    }
+
+    assertInvariants();
+  }
+  else if (failuresFirst || inParallel)
+  {
+    unsigned long int numSections = 0UL;                    // no. of sections in the index
+    const Section*    section     = sections();             // iterates through the index
+
+    for (; section != NULL; section = section->next())
+      ++numSections;
+
+    ScheduledSection *const schedule = new ScheduledSection[numSections + 1UL];
+    const char**            names    = new const char*[numSections + 1UL];
+    unsigned long int*      counts   = new unsigned long int[numSections + 1UL];
+    unsigned long int       numScheduled = 0UL;            // no. of entries in "schedule"
+
+    assert((schedule != NULL) && (names != NULL) && (counts != NULL));
+
+    /*
+    The sections for "tests" that belong to this shard are collected in index order.  If
+    they're to be ordered by recent failures then their tests' failures are counted in a single
+    pass through the results history and they're sorted by those counts (keeping index order
+    among equals).
+    */
+
+    section = _sections;
+
+    for (unsigned long int position = 0UL; section != NULL; ++position)
+    {
+      if (((position % numShards) == shardNum) && (getTest(section->name(), tests) != NULL))
+      {
+        schedule[numScheduled].section     = section;
+        schedule[numScheduled].numFailures = 0UL;
+        schedule[numScheduled].position    = position;
+        names[numScheduled]                = section->name();
+        ++numScheduled;
+      }
+
+      section = section->next();
+    }
+
+    if (failuresFirst)
+    {
+      _history->failureCounts(names, numScheduled, _failureRuns, counts);
+
+      for (unsigned long int i = 0UL; i < numScheduled; ++i)
+        schedule[i].numFailures = counts[i];
+
+      qsort(schedule, numScheduled, sizeof(ScheduledSection), compareScheduled);
+    }
+
+    #ifdef TESTSUITE_POSIX
+      if (inParallel)
+        runInParallel(schedule, numScheduled, tests);
+      else
+    #endif
+    {
+      bool abortAll = false;                                // should all testing be stopped?
+
+      for (unsigned long int i = 0UL; !abortAll && (i < numScheduled); ++i)
+      {
+        const Test *const test = getTest(schedule[i].section->name(), tests);
 
-{
-  assertInvariants();
+        _testData.seek(*schedule[i].section);
+        abortAll = !runTest(*test);
+      }
+    }
 
-  if (tests == NULL)
-    *_log << "*** No valid test names were provided! ***" << endl << endl;
+    delete[] counts;
+    delete[] names;
+    delete[] schedule;
+
+    assertInvariants();
+  }
   else
   {
     bool        abortAll = false;                           // should all testing be stopped?
@@ -692,19 +2019,70 @@ stops when it detects either a new section of test cases or an error state
 "_testData" will be left ready to read the first test case for the next section
 of test cases (if any).  "_testName" will contain the test function name for
 the next section of test cases (if any).
+
+The results are added to "_result".
 */
 
 {
   assertInvariants();
 
-  unsigned int testCaseNum = 0U;
+  if (_cancelled != 0)
+  {
+    cancelTesting();
+    return false;
+  }
 
-  bool         abortTest = false;        // should the current test be stopped?
-  bool         abortAll  = false;
-  unsigned int numFailedTestCases = 0U;  // total number of failed test cases
-  const char*  testCaseData = _testData.readTestCase();
+  CaseTally tally;                                        // the results of this section
+
+  if (_logArchive != NULL)
+    _logArchive->mark(test.name(), 0U);
 
   logTestHeader(test);
+  applyTestCases(test, tally);
+
+  if (_cancelled != 0)
+    cancelTesting();
+
+  addTally(test, tally);
+
+  return !tally.abortAll && (_cancelled == 0);
+}
+
+/*********************************************************************************************/
+
+void TestSuite::applyTestCases
+(
+  TestSuite::Test& test,
+  CaseTally&       tally                  // where the results are returned
+)
+
+/*
+This method applies the test cases in "_testData", up to the start of the next section (or the
+end of the stream), to "test", and tallies the results in "tally".  Test case numbers continue
+on from "_caseBase".
+
+"_testData" must be ready to read a test case.
+
+If "_benchmark" is set, the test cases that are to be timed are run again after the whole
+section has been applied and its duration taken, so that the re-runs don't count toward the
+duration and can't disturb the state that later test cases in the section see.
+*/
+
+{
+  const double startTime   = timeStamp();                 // when this section was started
+  unsigned int testCaseNum = _caseBase;
+  const char*  testCaseData = _testData.readTestCase();
+  CaseNode*    timedCases   = NULL;                       // the test cases to benchmark
+  CaseNode*    lastTimed    = NULL;                       // the last entry in "timedCases"
+
+  tally.numCases        = 0U;
+  tally.numFailedCases  = 0U;
+  tally.numDuplicates   = 0U;
+  tally.firstFailedCase = 0U;
+  tally.firstFailedLine = 0UL;
+  tally.abortTest       = false;
+  tally.abortAll        = false;
+  tally.readExtra       = false;
 
   /*
   This is the main loop.  During each iteration, a test case is read from
@@ -712,51 +2090,192 @@ the next section of test cases (if any).
   is then called and its result code processed.
 
   The loop terminates when either a new test function name or an error state
-  (including EOF) is detected in "_testData".
+  (including EOF) is detected in "_testData", or when testing is cancelled.  Test cases
+  outside of "_firstCase" to "_lastCase" are read but not applied, and so are duplicates if
+  they're being skipped.
   */
 
-  while (!abortTest && (testCaseData != NULL))
+  while (!tally.abortTest && (_cancelled == 0) && (testCaseData != NULL))
   {
     testCaseNum++;
 
-    TestCase testCase(testCaseNum, _testData.lineCounter(), testCaseData);
+    if ((testCaseNum >= _firstCase) && _skipDuplicates && !_caseSet.insert(test, testCaseData))
+      tally.numDuplicates++;
+    else if (testCaseNum >= _firstCase)
+    {
+      tally.numCases++;
 
-    test.setData(testCase, _testData, *_log);
+      TestCase                testCase(testCaseNum, _testData.lineCounter(), testCaseData);
+      const unsigned long int numReads = _testData._numReads;
 
-    const Test::TestResult testResult = test.testMethod();
+      test.setData(testCase, _testData, *_log);
+      _virtualClock.reset();
+      test._virtualClock = &_virtualClock;
+      _tokenizer.reset(testCase.text());
+      test._tokenizer = &_tokenizer;
 
-    if (testResult == Test::pass)
-      logTestCasePassed(test, testCase);
-    else
-    {
-      numFailedTestCases++;
-      logTestCaseFailed(test, testCase);
+      if (_logArchive != NULL)
+        _logArchive->mark(test.name(), testCaseNum);
+
+      if (_history != NULL)
+        _history->startCase();
+
+      #ifdef TESTSUITE_POSIX
+        if (_profiler != NULL)
+          _profiler->enterCase(test.name(), testCaseNum);
+      #endif
+
+      const Test::TestResult testResult = test.testMethod();
+
+      #ifdef TESTSUITE_POSIX
+        if (_profiler != NULL)
+          _profiler->leaveCase();
+      #endif
+
+      if (_history != NULL)
+        _history->endCase(test.name(), testCaseNum, testResult);
+
+      if (_testData._numReads != numReads)
+      {
+        tally.readExtra = true;
 
-      if (testResult != Test::fail)
+        if (_skipDuplicates)
+          _caseSet.markReadsExtra(test);
+      }
+
+      if ((_benchmark != NULL) && (_testData._numReads == numReads) &&
+        ((testResult == Test::pass) || (testResult == Test::fail)))
+      {
+        CaseNode *const node = new CaseNode;
+
+        node->testCase = new TestCase(testCaseNum, testCase.lineCounter(), testCase.text());
+        node->next     = NULL;
+
+        if (lastTimed == NULL)
+          timedCases = node;
+        else
+          lastTimed->next = node;
+
+        lastTimed = node;
+      }
+
+      if (testResult == Test::pass)
+        logTestCasePassed(test, testCase);
+      else
       {
-        abortTest = true;
+        tally.numFailedCases++;
+        logTestCaseFailed(test, testCase);
 
-        if (testResult == Test::abortAllTests)
+        if (tally.firstFailedCase == 0U)
         {
-          abortAll = true;
-          logAllTestsAborted();
+          tally.firstFailedCase = testCaseNum;
+          tally.firstFailedLine = testCase.lineCounter();
+        }
+
+        if (_failFast)
+          cancel();
+
+        if (testResult != Test::fail)
+        {
+          tally.abortTest = true;
+
+          if (testResult == Test::abortAllTests)
+          {
+            tally.abortAll = true;
+            logAllTestsAborted();
+          }
+          else
+            logTestAborted(test);
+
+          if (_logArchive != NULL)
+            _logArchive->flushBlock();
         }
-        else
-          logTestAborted(test);
       }
     }
 
     delete[] (char*)testCaseData;
-    testCaseData = _testData.readTestCase();
+    testCaseData = (testCaseNum < _lastCase ? _testData.readTestCase() : NULL);
   }
 
   delete[] (char*)testCaseData;
-  logTestFooter(test, testCaseNum, numFailedTestCases);
 
-  _totalTestCases       += testCaseNum;
-  _totalFailedTestCases += numFailedTestCases;
+  tally.duration = timeStamp() - startTime;
+
+  while (timedCases != NULL)
+  {
+    CaseNode *const node = timedCases;
+
+    if (_cancelled == 0)
+      benchmarkCase(test, *node->testCase);
+
+    timedCases = node->next;
+    delete node->testCase;
+    delete node;
+  }
+
+  return;
+}
+
+/*********************************************************************************************/
+
+void TestSuite::addTally
+(
+  const Test&      test,
+  const CaseTally& tally                  // the results of a section of "test"
+)
+
+/*
+This method adds the results of a section of "test" to "_result" and logs its footer.
+*/
+
+{
+  RunResult::TestRecord& record = _result.record(test);      // where this test's results go
+
+  if ((record._firstFailedCase == 0U) && (tally.firstFailedCase != 0U))
+  {
+    record._firstFailedCase = tally.firstFailedCase;
+    record._firstFailedLine = tally.firstFailedLine;
+  }
+
+  record._numSections++;
+  record._numCases       += tally.numCases;
+  record._numFailedCases += tally.numFailedCases;
+  record._numDuplicates  += tally.numDuplicates;
+  record._aborted         = record._aborted || tally.abortTest;
+  record._duration       += tally.duration;
+
+  _result._numCases       += tally.numCases;
+  _result._numFailedCases += tally.numFailedCases;
+  _result._numDuplicates  += tally.numDuplicates;
+  _result._allAborted      = _result._allAborted || tally.abortAll;
+
+  if (_logArchive != NULL)
+    _logArchive->mark(test.name(), 0U);
+
+  if (tally.numDuplicates > 0U)
+    logDuplicatesSkipped(test, tally.numDuplicates);
+
+  logTestFooter(test, tally.numCases, tally.numFailedCases);
+
+  return;
+}
+
+/*********************************************************************************************/
+
+void TestSuite::cancelTesting()
+
+/*
+This method notes in "_result" that testing has been cancelled, logging it the first time.
+*/
+
+{
+  if (!_result._cancelled)
+  {
+    _result._cancelled = true;
+    logCancelled();
+  }
 
-  return !abortAll;
+  return;
 }
 
 /*********************************************************************************************/
@@ -807,6 +2326,126 @@ This method sends an unknown-test-function message to "report()".
 
 /*********************************************************************************************/
 
+void TestSuite::logUnknownTagName
+(
+  const char *const tagName     // name of the tag that no test object has been given
+)
+const
+
+/*
+This method sends an unknown-tag message to "report()".
+*/
+
+{
+  assert(tagName != NULL);
+
+  log() << "-------------------------------------------------------------------------------" <<
+    endl;
+  log() << "\"" << tagName << "\" is not a tag of any registered test object." << endl;
+  log() << endl;
+  return;
+}
+
+/*********************************************************************************************/
+
+void TestSuite::logBadTagExpression
+(
+  const char *const expression  // the tag selection expression that couldn't be compiled
+)
+const
+
+/*
+This method sends a bad-tag-expression message to "report()".
+*/
+
+{
+  assert(expression != NULL);
+
+  log() << "-------------------------------------------------------------------------------" <<
+    endl;
+  log() << "\"" << expression << "\" is not a valid tag selection expression." << endl;
+  log() << endl;
+  return;
+}
+
+/*********************************************************************************************/
+
+void TestSuite::logDroppedTags
+(
+  const char *const tagNames    // the tag names that didn't fit, separated by spaces
+)
+const
+
+/*
+This method sends a too-many-tags message to "report()".
+*/
+
+{
+  assert(tagNames != NULL);
+
+  log() << "-------------------------------------------------------------------------------" <<
+    endl;
+  log() << "*** More than " << (unsigned int)maxTags << " distinct tag names were declared, so "
+    "these weren't given to any test object:  " << tagNames << " ***" << endl;
+  log() << endl;
+  return;
+}
+
+/*********************************************************************************************/
+
+void TestSuite::logListedSection
+(
+  const Section& section,
+  const Test&
+)
+const
+
+/*
+This method sends a description of a section of the test data stream to "report()".
+
+It's called by "list()" for each section whose test name has been registered.
+*/
+
+{
+  log() << "\"" << section.name() << "\" (line " << section.lineCounter() << "):  " <<
+    section.numCases() << " test case" << (section.numCases() == 1UL ? "" : "s") << endl;
+  return;
+}
+
+/*********************************************************************************************/
+
+void TestSuite::logListedTest
+(
+  const Test&             test,
+  const unsigned long int numSections,     // no. of sections for "test" in the test data stream
+  const unsigned long int numCases         // no. of test cases in those sections
+)
+const
+
+/*
+This method sends a summary of a registered test object's test data to "report()".
+
+It's called by "list()" for each registered test object after all the sections have been
+listed.
+*/
+
+{
+  assert(test.name() != NULL);
+
+  if (numSections == 0UL)
+    log() << "Test \"" << test.name() << "\" has no test data." << endl;
+  else
+  {
+    log() << "Test \"" << test.name() << "\":  " << numCases << " test case" <<
+      (numCases == 1UL ? "" : "s") << " in " << numSections << " section" <<
+      (numSections == 1UL ? "" : "s") << endl;
+  }
+
+  return;
+}
+
+/*********************************************************************************************/
+
 void TestSuite::logTestCaseFailed
 (
   const TestSuite::Test&     test,
@@ -870,6 +2509,45 @@ no further tests should be performed.
 
 /*********************************************************************************************/
 
+void TestSuite::logCancelled() const
+
+/*
+This method sends a testing-cancelled message to "report()".
+
+It's called when testing is cancelled, either by "cancel()" or by the first failed test case
+when "setFailFast()" is in effect.
+*/
+
+{
+  log() << "*** Testing has been cancelled. ***" << endl;
+  log() << endl;
+  return;
+}
+
+/*********************************************************************************************/
+
+void TestSuite::logDuplicatesSkipped
+(
+  const Test&        test,
+  const unsigned int numDuplicates    // number of duplicate test cases that were skipped
+)
+const
+
+/*
+This method sends the number of duplicate test cases that were skipped to "report()".
+
+It's called just before "logTestFooter()" when duplicate test cases are being skipped (see
+"setSkipDuplicates()") and some of a section's test cases were duplicates.
+*/
+
+{
+  log() << numDuplicates << " duplicate test case" << (numDuplicates == 1 ? " was" : "s were")
+    << " skipped for test \"" << test.name() << "\"." << endl;
+  return;
+}
+
+/*********************************************************************************************/
+
 void TestSuite::logTestFooter
 (
   const Test&        test,
@@ -896,22 +2574,82 @@ It's called after the last test case has been applied to a test function.
 
 /*********************************************************************************************/
 
+void TestSuite::logWorkersNotUsed
+(
+  const char *const reason            // why tests are being performed in this process
+)
+const
+
+/*
+This method sends a message to "report()" saying that worker processes aren't being used.
+
+It's called at the start of a series of tests when "setWorkers()" asked for worker processes
+but the tests have to be performed in this process instead.
+*/
+
+{
+  assert(reason != NULL);
+
+  log() << "-------------------------------------------------------------------------------" <<
+    endl;
+  log() << "*** Tests are being performed in this process rather than in worker processes, " <<
+    "because " << reason << ". ***" << endl;
+  log() << endl;
+  return;
+}
+
+/*********************************************************************************************/
+
 void TestSuite::assertInvariants() const
 
 {
   /*
-  INVARIANTS:  "_testData", "_log" and "_tests" can't be NULL.
+  INVARIANT:  "_log" can't be NULL.  ("_tests" can be NULL if the only test objects are in
+  modules that haven't been loaded yet.)
   */
 
   assert(_log != NULL);
-  assert(_tests != NULL);
 
   /*
   INVARIANT:  The total number of test cases applied cannot be less than the total number that
   failed.
   */
 
-  assert(_totalTestCases >= _totalFailedTestCases);
+  assert(_result.numCases() >= _result.numFailedCases());
 
   return;
 }
+
+// ============================================================================================
+// STATIC FUNCTION DEFINITIONS
+// ============================================================================================
+
+/*********************************************************************************************/
+
+static const char *const skipSpaces
+(
+  const char *const text
+)
+
+{
+  assert(text != NULL);
+
+  const char* position = text;
+
+  while ((*position != '\0') && isspace((unsigned char)*position))
+    ++position;
+
+  return position;
+}
+
+/*********************************************************************************************/
+
+static const bool isTagChar
+(
+  const char character
+)
+
+{
+  return (isalnum((unsigned char)character) || (character == '_') || (character == '-') ||
+    (character == '.'));
+}
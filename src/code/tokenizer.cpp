@@ -0,0 +1,413 @@
+// ============================================================================================
+//
+// SOURCE FILE:  tokenizer.cpp
+//
+// ============================================================================================
+
+// ============================================================================================
+// DESCRIPTION
+// ============================================================================================
+
+/*
+This file implements "TestSuite::Tokenizer", which splits a test case's text into tokens
+without copying it.  A test method reaches the tokenizer for the test case being applied with
+"tokenizer()":
+
+  TEST(lookUp)
+  {
+    TestSuite::Tokenizer& tokens = tokenizer();
+    long int              expected;
+
+    if (!tokens.next() || !tokens.toLong(expected) || !tokens.next())
+      return abortThisTest;                       // the test case is malformed
+
+    return (table.find(tokens.text(), tokens.length()) == expected ? pass : fail);
+  }
+
+Each call to "next()" moves to the next token and returns "true", or returns "false" at the end
+of the text.  A token is either a run of characters other than whitespace or a string in double
+quotes, which can contain whitespace and C escape sequences ("\n", "\t", "\"", "\\", "\x41",
+"\101", etc.).  A quoted string's token is what it denotes, without the quotes.  "quoted()"
+says which kind the current token was, and "bad()" says whether "next()" stopped at a quoted
+string with no closing quote.
+
+"text()" and "length()" are a view of the current token.  Unless it's a quoted string with an
+escape sequence in it, the view points straight into the test case's text, so it isn't
+NUL-terminated.  Escape sequences are decoded into a buffer that's kept from one token (and one
+test case) to the next, so it's only reallocated when a longer string comes along; the view is
+only good until the next call to "next()".  "equals()", "copy()", "toLong()" and "toDouble()"
+do the usual things with a view.  A decoded string can contain NUL characters (e.g. "\0"), so
+"length()" is the only reliable measure of a token.
+
+"testCase().data()" can still be used alongside the tokenizer; they don't affect each other.
+*/
+
+// ============================================================================================
+// INCLUDE FILES
+// ============================================================================================
+
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <errno.h>
+
+#ifdef FAT_FILENAMES
+  #include "testsuit.h"
+#else
+  #include "testsuite.h"
+#endif
+
+// ============================================================================================
+// STATIC CONSTANTS
+// ============================================================================================
+
+static const char escapeLetters[] = "abfnrtv";          // letters that follow a backslash
+static const char escapeCodes[]   = "\a\b\f\n\r\t\v";   // the characters they denote
+
+// ============================================================================================
+// STATIC FUNCTION DECLARATIONS
+// ============================================================================================
+
+static const int digitValue(const char, const unsigned int);
+
+// ============================================================================================
+// METHOD DEFINITIONS FOR TESTSUITE::TOKENIZER CLASS
+// ============================================================================================
+
+/*********************************************************************************************/
+
+TestSuite::Tokenizer::Tokenizer
+(
+  const char *const text                // the text to split into tokens
+):
+
+/*
+This is the constructor for class "Tokenizer".  "text" isn't copied, so it has to stay put
+for as long as it's being tokenized.
+
+PRECONDITIONS:
+"text" mustn't be NULL.
+*/
+
+  _position(text),
+  _token(text),
+  _length(0U),
+  _quoted(false),
+  _bad(false),
+  _buffer(NULL),
+  _capacity(0U)
+
+{
+  assert(text != NULL);
+
+  return;
+}
+
+/*********************************************************************************************/
+
+void TestSuite::Tokenizer::reset
+(
+  const char *const text                // the text to split into tokens
+)
+
+/*
+This method starts tokenizing "text" (which isn't copied).  The decoding buffer is kept.
+
+PRECONDITIONS:
+"text" mustn't be NULL.
+*/
+
+{
+  assert(text != NULL);
+
+  _position = text;
+  _token    = text;
+  _length   = 0U;
+  _quoted   = false;
+  _bad      = false;
+
+  return;
+}
+
+/*********************************************************************************************/
+
+const bool TestSuite::Tokenizer::next()
+
+/*
+This method moves to the next token and returns "true", or returns "false" if there are no more
+tokens or the next one is a quoted string with no closing quote (in which case "bad()" returns
+"true" and the rest of the text is skipped).
+*/
+
+{
+  bool found = false;                           // has a token been found?
+
+  while (isspace((unsigned char)*_position))
+    _position++;
+
+  _token  = _position;
+  _length = 0U;
+  _quoted = (*_position == '"');
+
+  if (_quoted)
+    found = nextQuoted();
+  else if (*_position != '\0')
+  {
+    while ((*_position != '\0') && !isspace((unsigned char)*_position))
+      _position++;
+
+    _length = (size_t)(_position - _token);
+    found   = true;
+  }
+
+  return found;
+}
+
+/*********************************************************************************************/
+
+const bool TestSuite::Tokenizer::equals
+(
+  const char *const string              // what to compare the current token to
+) const
+
+/*
+This method returns "true" if the current token is the same as "string".
+*/
+
+{
+  assert(string != NULL);
+
+  return ((strlen(string) == _length) && (memcmp(_token, string, _length) == 0));
+}
+
+/*********************************************************************************************/
+
+const bool TestSuite::Tokenizer::copy
+(
+  char *const  destination,             // where to copy the current token to
+  const size_t size                     // no. of characters allocated in "destination"
+) const
+
+/*
+This method copies the current token into "destination" as a NUL-terminated string and returns
+"true", or copies as much as will fit and returns "false" if it's too long.
+
+PRECONDITIONS:
+"destination" must point to at least "size" characters, and "size" must be positive.
+*/
+
+{
+  assert(destination != NULL);
+  assert(size > 0U);
+
+  const bool   fits   = (_length < size);
+  const size_t length = (fits ? _length : size - 1U);   // no. of characters to copy
+
+  memcpy(destination, _token, length);
+  destination[length] = '\0';
+
+  return fits;
+}
+
+/*********************************************************************************************/
+
+const bool TestSuite::Tokenizer::toLong
+(
+  long int& value                       // where the number is returned
+) const
+
+/*
+This method returns "true" and puts the current token in "value" if it's an integer (in
+decimal, or in hexadecimal or octal with a C prefix) that fits in a "long int"; otherwise it
+returns "false" and leaves "value" alone.
+*/
+
+{
+  const size_t maxLength = 63U;                  // no integer that fits is this long
+  char         digits[maxLength + 1U];           // the token as a NUL-terminated string
+  char*        end;                              // where "strtol()" stopped
+  bool         converted = false;
+
+  if ((_length > 0U) && copy(digits, sizeof(digits)))
+  {
+    errno = 0;
+
+    const long int number = strtol(digits, &end, 0);
+
+    if ((*end == '\0') && (errno != ERANGE))
+    {
+      value     = number;
+      converted = true;
+    }
+  }
+
+  return converted;
+}
+
+/*********************************************************************************************/
+
+const bool TestSuite::Tokenizer::toDouble
+(
+  double& value                         // where the number is returned
+) const
+
+/*
+This method returns "true" and puts the current token in "value" if it's a floating-point
+number; otherwise it returns "false" and leaves "value" alone.
+*/
+
+{
+  const size_t maxLength = 127U;                 // longer than any sensible number
+  char         digits[maxLength + 1U];           // the token as a NUL-terminated string
+  char*        end;                              // where "strtod()" stopped
+  bool         converted = false;
+
+  if ((_length > 0U) && copy(digits, sizeof(digits)))
+  {
+    const double number = strtod(digits, &end);
+
+    if (*end == '\0')
+    {
+      value     = number;
+      converted = true;
+    }
+  }
+
+  return converted;
+}
+
+/*********************************************************************************************/
+
+const bool TestSuite::Tokenizer::nextQuoted()
+
+/*
+This method finishes "next()" for a quoted string, which "_position" points to the opening
+quote of.  If there are no escape sequences then the token is a view of the text between the
+quotes; otherwise the string is decoded into "_buffer".
+*/
+
+{
+  const char* end     = _position + 1;          // looks for the closing quote
+  bool        escaped = false;                  // does the string have an escape sequence?
+
+  while ((*end != '"') && (*end != '\0'))
+  {
+    if ((*end == '\\') && (end[1] != '\0'))
+    {
+      escaped = true;
+      end++;
+    }
+
+    end++;
+  }
+
+  _bad = (*end == '\0');
+
+  if (_bad)
+  {
+    _token    = end;
+    _position = end;
+  }
+  else if (!escaped)
+  {
+    _token    = _position + 1;
+    _length   = (size_t)(end - _token);
+    _position = end + 1;
+  }
+  else
+  {
+    const char* source = _position + 1;         // the next character to decode
+    size_t      length = 0U;                    // no. of characters decoded so far
+
+    if (_capacity < (size_t)(end - source))
+    {
+      delete[] _buffer;
+      _capacity = (size_t)(end - source);
+      _buffer   = new char[_capacity];
+    }
+
+    while (source < end)
+    {
+      if (*source != '\\')
+        _buffer[length] = *source++;
+      else
+      {
+        const char        escape    = *++source;  // the character after the backslash
+        const char *const letter    = strchr(escapeLetters, escape);
+        int               code      = 0;          // the value of a numeric escape sequence
+        int               digit;                  // the value of the next digit (or -1)
+        unsigned int      numDigits = 1U;         // no. of octal digits so far
+
+        source++;
+
+        if (escape == 'x')
+        {
+          digit = digitValue(*source, 16U);
+
+          while ((source < end) && (digit >= 0))
+          {
+            code  = code * 16 + digit;
+            digit = digitValue(*++source, 16U);
+          }
+
+          _buffer[length] = (char)code;
+        }
+        else if ((escape >= '0') && (escape <= '7'))
+        {
+          code  = escape - '0';
+          digit = digitValue(*source, 8U);
+
+          while ((source < end) && (digit >= 0) && (numDigits < 3U))
+          {
+            code  = code * 8 + digit;
+            digit = digitValue(*++source, 8U);
+            numDigits++;
+          }
+
+          _buffer[length] = (char)code;
+        }
+        else if (letter != NULL)
+          _buffer[length] = escapeCodes[letter - escapeLetters];
+        else
+          _buffer[length] = escape;             // "\\", "\"", "\'", "\?" and anything else
+      }
+
+      length++;
+    }
+
+    _token    = _buffer;
+    _length   = length;
+    _position = end + 1;
+  }
+
+  return !_bad;
+}
+
+// ============================================================================================
+// STATIC FUNCTION DEFINITIONS
+// ============================================================================================
+
+/*********************************************************************************************/
+
+static const int digitValue
+(
+  const char         character,         // a character that might be a digit
+  const unsigned int base               // 8U or 16U
+)
+
+/*
+This function returns the value of "character" as a digit in "base", or -1 if it isn't one.
+*/
+
+{
+  int value = -1;
+
+  if ((character >= '0') && (character <= '9'))
+    value = character - '0';
+  else if ((character >= 'a') && (character <= 'f'))
+    value = character - 'a' + 10;
+  else if ((character >= 'A') && (character <= 'F'))
+    value = character - 'A' + 10;
+
+  return (value < (int)base ? value : -1);
+}
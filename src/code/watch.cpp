@@ -0,0 +1,153 @@
+// ============================================================================================
+//
+// SOURCE FILE:  watch.cpp
+//
+// ============================================================================================
+
+// ============================================================================================
+// DESCRIPTION
+// ============================================================================================
+
+/*
+This file implements "TestSuite::watch()", which performs the sections of a test data file that
+have changed every time the file is saved.  It's meant to be left running while a large test
+data file is being edited.
+
+The work of finding and performing the changed sections is done by "TestSuite::update()" -- see
+"RE-PERFORMING CHANGED SECTIONS" in "testsuite.cpp".  This file only waits for the file to
+change, which needs Linux's "inotify" facility, so it's only compiled if "TESTSUITE_POSIX" is
+defined and the target is Linux.
+*/
+
+// ============================================================================================
+// INCLUDE FILES
+// ============================================================================================
+
+#ifdef FAT_FILENAMES
+  #include "testsuit.h"
+#else
+  #include "testsuite.h"
+#endif
+
+#if defined(TESTSUITE_POSIX) && defined(__linux__)
+
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+
+// ============================================================================================
+// PUBLIC METHOD DEFINITIONS FOR TESTSUITE CLASS
+// ============================================================================================
+
+/*********************************************************************************************/
+
+void TestSuite::watch
+(
+  ifstream&         dataFile,           // the stream that this object reads test data from
+  const char *const fileName            // the name of the file that "dataFile" was opened on
+)
+
+/*
+This method performs every section of the test data file, then waits for the file to be saved
+and performs the sections that have changed, over and over.  The results for each save are
+logged as soon as they're available.
+
+The directory that contains the file is watched rather than the file itself so that editors
+that save by writing a new file and renaming it over the old one are noticed, too.  "dataFile"
+is re-opened after each save.
+
+This method only returns if the file can't be watched, in which case a message is logged.
+
+PRECONDITIONS:
+"dataFile" must be the stream that was passed to this object's constructor, and it must have
+been opened on "fileName".  "fileName" can't be NULL.
+
+POSTCONDITIONS:
+None.
+*/
+
+{
+  assertInvariants();
+  assert(fileName != NULL);
+
+  const char *const slash     = strrchr(fileName, '/');       // end of the directory name
+  const char *const baseName  = (slash == NULL ? fileName : slash + 1);
+  const size_t      dirLength = (slash == NULL ? 0U : (slash == fileName ? 1U :
+                                  (size_t)(slash - fileName)));
+  char *const       directory = new char[dirLength + 2U];     // the directory to watch
+
+  assert(directory != NULL);
+
+  if (dirLength == 0U)
+    strcpy(directory, ".");
+  else
+  {
+    strncpy(directory, fileName, dirLength);
+    directory[dirLength] = '\0';
+  }
+
+  const int watcher = inotify_init();                 // where file system events are read from
+  const int watched = (watcher < 0 ? -1 :
+                        inotify_add_watch(watcher, directory, IN_CLOSE_WRITE | IN_MOVED_TO));
+
+  if (watched < 0)
+  {
+    log() << "*** Can't watch \"" << fileName << "\":  " << strerror(errno) << " ***" <<
+      endl << endl;
+  }
+  else
+  {
+    union
+    {
+      inotify_event first;
+      char          bytes[4096];
+    }    events;                                            // events read from "watcher"
+    bool stop = false;                                      // has watching failed?
+
+    update();
+
+    while (!stop)
+    {
+      const ssize_t numRead = read(watcher, events.bytes, sizeof(events.bytes));
+      bool          changed = false;        // has "fileName" been saved since the last update?
+
+      if ((numRead < 0) && (errno != EINTR))
+      {
+        log() << "*** Can't watch \"" << fileName << "\":  " << strerror(errno) << " ***" <<
+          endl << endl;
+        stop = true;
+      }
+
+      for (ssize_t offset = 0; offset < numRead; )
+      {
+        const inotify_event *const event = (const inotify_event*)(events.bytes + offset);
+
+        if ((event->len > 0U) && (strcmp(event->name, baseName) == 0))
+          changed = true;
+
+        offset += (ssize_t)(sizeof(inotify_event) + event->len);
+      }
+
+      if (changed)
+      {
+        dataFile.close();
+        dataFile.clear();
+        dataFile.open(fileName);
+
+        if (dataFile.good())
+          update();
+      }
+    }
+  }
+
+  if (watcher >= 0)
+    close(watcher);
+
+  delete[] directory;
+
+  assertInvariants();
+  return;
+}
+
+#endif
@@ -22,14 +22,16 @@ any ANSI-complient C++ compiler.
 // ============================================================================
 
 #include <fstream.h>
+#include <strstream.h>
 #include <string.h>
+#include <stdio.h>
 #include <limits.h>
+#include <time.h>
 #include <assert.h>
 
 #include "testsuite.h"
 
 #include <platform.h>
-#include <shiftstringin.h>
 
 //#if ((PF_COMPILER == PF_BORLAND) && (PF_COMPILER_VER > 0x0520))
 //  #include <vcl\condefs.h>
@@ -49,6 +51,165 @@ any ANSI-complient C++ compiler.
 // ============================================================================
 
 static const char testDataFileName[] = "testData.txt";    // test data filename
+static const char historyFileName[]  = "testHist.hst";    // scratch history file
+static const char archiveFileName[]  = "testLog.tsl";     // scratch log archive
+
+static char firedTimers[81] = "";       // the labels of the timers that expired
+
+/*
+Test data for the tests that perform tests with a "TestSuite" object of their own.  The
+helper tests below only pass, so that what's being checked is which of them were performed.
+*/
+
+static const char helperData[] =
+  ":tagFast\n1\n2\n"
+  ":tagSlow\n1\n"
+  ":tagNightly\n1\n2\n3\n";
+
+static const char listData[] =
+  ":tagFast\n1\n2\n"
+  ":unknownTest\n1\n"
+  ":tagFast\n3\n4\n5\n"
+  ":tagSlow\n1\n";
+
+// ============================================================================
+// STATIC FUNCTIONS
+// ============================================================================
+
+/*****************************************************************************/
+
+static void joinTestNames
+ (
+  const TestSuite::RunResult& result,   // the results of the tests performed
+  char *const                 names,    // where the names are returned
+  const size_t                size      // no. of characters allocated in "names"
+ )
+
+/*
+This function returns the names of the tests in "result", in the order in
+which they were performed and separated by spaces, in "names".
+*/
+
+ {
+  const TestSuite::RunResult::TestRecord* record = result.tests();
+
+  names[0] = '\0';
+
+  while (record != NULL)
+   {
+    if ((strlen(names) + strlen(record->name()) + 2U) <= size)
+     {
+      if (names[0] != '\0')
+        strcat(names, " ");
+
+      strcat(names, record->name());
+     }
+
+    record = record->next();
+   }
+
+  return;
+ }
+
+/*****************************************************************************/
+
+static const bool logContains
+ (
+  ostrstream&       log,                // what a "TestSuite" object logged
+  const char *const text                // what to look for in it
+ )
+
+/*
+This function returns "true" if "text" appears in "log".
+*/
+
+ {
+  log << ends;
+
+  const bool found = (strstr(log.str(), text) != NULL);
+
+  log.rdbuf()->freeze(0);
+  log.seekp(-1L, ios::cur);
+  return found;
+ }
+
+/*****************************************************************************/
+
+static const bool sameText
+ (
+  ostrstream&       written,            // what was read back
+  const char *const text                // what should have been
+ )
+
+/*
+This function returns "true" if exactly "text" was written to "written".
+*/
+
+ {
+  written << ends;
+
+  const bool same = (strcmp(written.str(), text) == 0);
+
+  written.rdbuf()->freeze(0);
+  return same;
+ }
+
+/*****************************************************************************/
+
+static void noteTimer
+ (
+  void *const context                   // the timer's label
+ )
+
+/*
+This function is the timer callback for "virtualTime".  It appends the
+timer's label to "firedTimers".
+*/
+
+ {
+  if ((strlen(firedTimers) + strlen((const char*)context) + 2U) <= sizeof(firedTimers))
+   {
+    if (firedTimers[0] != '\0')
+      strcat(firedTimers, " ");
+
+    strcat(firedTimers, (const char*)context);
+   }
+
+  return;
+ }
+
+// ============================================================================
+// HELPER CLASSES
+// ============================================================================
+
+/*
+This is a "TestSuite" object of a test's own, which performs "testData" and
+logs to a string stream that "logged()" looks in.  It's what the tests that
+perform tests themselves use, so that they only have to set it up and call
+the method being tested.  "testData" isn't copied, so it must outlive this
+object.
+*/
+
+class InnerSuite
+ {
+  public:
+                     InnerSuite(const char *const testData):
+                       _data(testData), _log(), _suite(_data, _log)
+                       {return;}
+
+    TestSuite&       suite()
+                       {return _suite;}
+    const bool       logged(const char *const text)
+                       {return logContains(_log, text);}
+
+  private:
+    istrstream       _data;              // the test data being performed
+    ostrstream       _log;               // what "_suite" logs
+    TestSuite        _suite;
+
+                     InnerSuite(const InnerSuite&);
+    InnerSuite&      operator=(const InnerSuite&);
+ };
 
 // ============================================================================
 // TEST OBJECTS
@@ -80,13 +241,13 @@ where "first" and "second" are two equal numbers.
   unsigned int first =  1U;             // the first unsigned integer variable
   unsigned int second = 2U;             // the second unsigned integer variable
 
- testCase.data() >> first >> second;
+ testCase().data() >> first >> second;
 
   if (first == second)
     return pass;
   else
    {
-    log << "  " << first << " != " << second << endl;
+    log() << "  " << first << " != " << second << endl;
     return abortAllTests;
    }
  }
@@ -111,14 +272,12 @@ Only one test case is needed.
   it's equal to what the "testName()" method returns.
   */
 
-  const size_t testNameSize = 81U;           // max. size of a test name string
-  char         testName[testNameSize] = "";  // the parsed test name
-
-  testCase.data() >> ShiftASCIIStringIn(testName, testNameSize);
+  TestSuite::Tokenizer& tokens = tokenizer();  // the test case, split into tokens
 
-  if (strcmp(testName, name()) != 0)
+  if (!tokens.next() || !tokens.equals(name()))
   {
-    log << "  Expected \"" << name() << "\" but got \"" << testName << "\"." << endl;
+    log() << "  Expected \"" << name() << "\" but got \"";
+    log().write(tokens.text(), tokens.length()) << "\"." << endl;
     return fail;
   }
   else
@@ -147,11 +306,11 @@ where "testCaseNum" is the test case number, starting at 0.
 
   unsigned int caseNum = UINT_MAX;               // the parsed test case number
 
-  testCase.data() >> caseNum;
+  testCase().data() >> caseNum;
 
-  if (caseNum != testCase.number())
+  if (caseNum != testCase().number())
   {
-    log << "  Expected " << testCase.number() << ", but got " << caseNum << "." << endl;
+    log() << "  Expected " << testCase().number() << ", but got " << caseNum << "." << endl;
     return fail;
   }
   else
@@ -181,38 +340,43 @@ meaning that the test case should be applied to this test function.
 */
 
  {
-  const size_t testResultSize = 81U;
-  char         testResult[testResultSize] = "";
-  bool         testCaseShouldBeApplied = false;
+  const size_t          testResultSize = 81U;
+  char                  testResult[testResultSize] = "";
+  long int              testCaseShouldBeApplied = 0L;
+  TestSuite::Tokenizer& tokens = tokenizer();
 
-  testCase.data() >> ShiftASCIIStringIn(testResult, testResultSize) >> testCaseShouldBeApplied;
+  if (tokens.next())
+    tokens.copy(testResult, testResultSize);
 
-  if (!testCaseShouldBeApplied)
+  if (tokens.next())
+    tokens.toLong(testCaseShouldBeApplied);
+
+  if (testCaseShouldBeApplied == 0L)
    {
-    log << "  Something went wrong -- test case " << testCase.number() << " shouldn't have "
+    log() << "  Something went wrong -- test case " << testCase().number() << " shouldn't have "
       "been applied." << endl;
     return fail;
    }
   else if (strcmp(testResult, "fail") == 0)
    {
-    log << "  Test case " << testCase.number() << " should fail..." << endl;
+    log() << "  Test case " << testCase().number() << " should fail..." << endl;
     return fail;
    }
   else if (strcmp(testResult, "abortThisTest") == 0)
    {
-    log << "  Test case " << testCase.number() << " should fail and abort this test..." <<
+    log() << "  Test case " << testCase().number() << " should fail and abort this test..." <<
       endl;
     return abortThisTest;
    }
   else if (strcmp(testResult, "abortAllTests") == 0)
    {
-    log << "  Test case " << testCase.number() << " should fail and abort all testing..." <<
+    log() << "  Test case " << testCase().number() << " should fail and abort all testing..." <<
       endl;
     return abortAllTests;
    }
   else
    {
-    log << "  Test case " << testCase.number() << " should pass..." << endl;
+    log() << "  Test case " << testCase().number() << " should pass..." << endl;
     return pass;
    }
  }
@@ -222,8 +386,8 @@ meaning that the test case should be applied to this test function.
 TEST(stringPulling)
 
 /*
-This test function tests a "quoted" manipulator's ability to correctly extract
-a quoted string from an input stream.
+This test function tests the tokenizer's ability to correctly extract a quoted
+string, with its C escape sequences decoded, from a test case.
 
 Test case format:
 
@@ -231,8 +395,8 @@ Test case format:
 
 where "stringSelector" is an index to an element in the "strings" array (which
 is defined within this test functioN) and "stringText" is a quoted string that,
-when parsed by the "quoted" manipulator, should be exactly the same as the
-selected string in "strings".
+when extracted by the tokenizer, should be exactly the same as the selected
+string in "strings".
 */
 
  {
@@ -245,16 +409,22 @@ selected string in "strings".
     "Escaped symbols:  \' \" \\"
    };
 
-  const size_t stringTextSize = 81U;
-  char         stringText[stringTextSize] = "";
-  unsigned int stringSelector = 0U;
+  const long int        numStrings = (long int)(sizeof(strings) / sizeof(strings[0]));
+  long int              stringSelector = -1L;
+  TestSuite::Tokenizer& tokens = tokenizer();
 
-  testCase.data() >> stringSelector >> ShiftCStringIn(stringText, stringTextSize);
-  if (strcmp(stringText, strings[stringSelector]) == 0)
+  if (!tokens.next() || !tokens.toLong(stringSelector) || (stringSelector < 0L) ||
+    (stringSelector >= numStrings) || !tokens.next() || !tokens.quoted())
+   {
+    log() << "  Malformed test case:  " << testCase().text() << endl;
+    return abortThisTest;
+   }
+  else if (tokens.equals(strings[stringSelector]))
     return pass;
   else
    {
-    log << "  Test case string = \"" << stringText << "\"; expected = \""
+    log() << "  Test case string = \"";
+    log().write(tokens.text(), tokens.length()) << "\"; expected = \""
       << strings[stringSelector] << "\"" << endl;
     return fail;
    }
@@ -262,6 +432,1305 @@ selected string in "strings".
 
 /*****************************************************************************/
 
+TAGGED_TEST(tagFast, "fast unit")
+
+/*
+This is a helper test for "tagSelection" (and others).  It always passes.
+*/
+
+ {
+  return pass;
+ }
+
+/*****************************************************************************/
+
+TAGGED_TEST(tagSlow, "slow io nightly")
+
+/*
+This is a helper test for "tagSelection" (and others).  It always passes.
+*/
+
+ {
+  return pass;
+ }
+
+/*****************************************************************************/
+
+TAGGED_TEST(tagNightly, "nightly unit")
+
+/*
+This is a helper test for "tagSelection" (and others).  It always passes.
+*/
+
+ {
+  return pass;
+ }
+
+/*****************************************************************************/
+
+TEST(outcome)
+
+/*
+This is a helper test for "runResults".  Its test cases are the result to
+return:  "pass", "fail", "abortThisTest" or "abortAllTests".
+*/
+
+ {
+  TestSuite::Tokenizer& tokens = tokenizer();
+
+  if (!tokens.next() || tokens.equals("pass"))
+    return pass;
+  else if (tokens.equals("abortThisTest"))
+    return abortThisTest;
+  else if (tokens.equals("abortAllTests"))
+    return abortAllTests;
+  else
+    return fail;
+ }
+
+/*****************************************************************************/
+
+TEST(tagSelection)
+
+/*
+This test object tests "TestSuite::tagged()":  the parsing of tag selection
+expressions and the precedence of their operators.
+
+Test case format:
+
+<quoted expression> <quoted testNames>
+
+where "expression" is given to "tagged()" for "helperData" and "testNames" is
+the names of the tests that should be performed, in order, or "invalid" if
+"expression" should be rejected.
+*/
+
+ {
+  const size_t          size = 81U;
+  char                  expression[size];
+  char                  expected[size];
+  char                  performed[size];
+  TestSuite::Tokenizer& tokens = tokenizer();
+
+  if (!tokens.next() || !tokens.copy(expression, size) || !tokens.next() ||
+    !tokens.copy(expected, size))
+   {
+    log() << "  Malformed test case:  " << testCase().text() << endl;
+    return abortThisTest;
+   }
+
+  InnerSuite inner(helperData);
+
+  joinTestNames(inner.suite().tagged(expression), performed, size);
+
+  if (strcmp(expected, "invalid") == 0)
+   {
+    if ((performed[0] == '\0') && inner.logged("is not a valid"))
+      return pass;
+   }
+  else if (strcmp(performed, expected) == 0)
+    return pass;
+
+  log() << "  \"" << expression << "\" performed \"" << performed << "\"; expected \"" <<
+    expected << "\"" << endl;
+  return fail;
+ }
+
+/*****************************************************************************/
+
+TEST(listing)
+
+/*
+This test object tests "TestSuite::list()" by listing "listData" and looking
+for lines in the log.
+
+Test case format:
+
+<quoted line>
+
+where "line" should appear in the log.
+*/
+
+ {
+  const size_t          size = 121U;
+  char                  line[size];
+  TestSuite::Tokenizer& tokens = tokenizer();
+
+  if (!tokens.next() || !tokens.copy(line, size))
+   {
+    log() << "  Malformed test case:  " << testCase().text() << endl;
+    return abortThisTest;
+   }
+
+  InnerSuite inner(listData);
+
+  inner.suite().list();
+
+  if (inner.logged(line))
+    return pass;
+  else
+   {
+    log() << "  \"" << line << "\" wasn't logged." << endl;
+    return fail;
+   }
+ }
+
+/*****************************************************************************/
+
+TEST(sharding)
+
+/*
+This test object tests "TestSuite::shard()" with "helperData", whose three
+sections are at positions 0, 1 and 2.
+
+Test case format:
+
+<unsigned int shardNum> <unsigned int numShards> <quoted testNames>
+
+where "testNames" is the names of the tests that should be performed, in
+order.
+*/
+
+ {
+  const size_t size      = 81U;
+  unsigned int shardNum  = 0U;
+  unsigned int numShards = 0U;
+  char         expected[size];
+  char         performed[size];
+
+  testCase().data() >> shardNum >> numShards;
+
+  TestSuite::Tokenizer& tokens = tokenizer();
+
+  if ((shardNum >= numShards) || !tokens.next() || !tokens.next() || !tokens.next() ||
+    !tokens.copy(expected, size))
+   {
+    log() << "  Malformed test case:  " << testCase().text() << endl;
+    return abortThisTest;
+   }
+
+  InnerSuite inner(helperData);
+
+  joinTestNames(inner.suite().shard(shardNum, numShards), performed, size);
+
+  if (strcmp(performed, expected) == 0)
+    return pass;
+  else
+   {
+    log() << "  Shard " << shardNum << " of " << numShards << " performed \"" << performed <<
+      "\"; expected \"" << expected << "\"" << endl;
+    return fail;
+   }
+ }
+
+/*****************************************************************************/
+
+TEST(updating)
+
+/*
+This test object tests "TestSuite::update()" by updating with a copy of
+"helperData", editing the copy in place and updating again.
+
+Test case format:
+
+<quoted oldText> <quoted newText> <quoted testNames>
+
+where "newText" (which must be as long as "oldText") replaces the first
+occurrence of "oldText" and "testNames" is the names of the tests that the
+second update should perform, in order.
+*/
+
+ {
+  const size_t          size = 81U;
+  char                  oldText[size];
+  char                  newText[size];
+  char                  expected[size];
+  char                  performed[size];
+  char                  edited[sizeof(helperData)];
+  TestSuite::Tokenizer& tokens = tokenizer();
+
+  if (!tokens.next() || !tokens.copy(oldText, size) || !tokens.next() ||
+    !tokens.copy(newText, size) || !tokens.next() || !tokens.copy(expected, size) ||
+    (strlen(newText) != strlen(oldText)))
+   {
+    log() << "  Malformed test case:  " << testCase().text() << endl;
+    return abortThisTest;
+   }
+
+  strcpy(edited, helperData);
+
+  char *const position = strstr(edited, oldText);
+
+  if (position == NULL)
+   {
+    log() << "  \"" << oldText << "\" isn't in the test data." << endl;
+    return abortThisTest;
+   }
+
+  InnerSuite inner(edited);
+
+  joinTestNames(inner.suite().update(), performed, size);
+
+  if (strcmp(performed, "tagFast tagSlow tagNightly") != 0)
+   {
+    log() << "  The first update performed \"" << performed << "\"" << endl;
+    return fail;
+   }
+
+  memcpy(position, newText, strlen(newText));
+  joinTestNames(inner.suite().update(), performed, size);
+
+  if (strcmp(performed, expected) == 0)
+    return pass;
+  else
+   {
+    log() << "  The second update performed \"" << performed << "\"; expected \"" <<
+      expected << "\"" << endl;
+    return fail;
+   }
+ }
+
+/*****************************************************************************/
+
+TEST(loading)
+
+/*
+This test object tests the failures of "TestSuite::load()", "unload()" and
+"reload()".  They're only tested if "TESTSUITE_POSIX" is defined.
+
+Test case format:
+
+<quoted method> <quoted path> <quoted line>
+
+where "method" is "load", "unload" or "reload", "path" is the module that it
+should fail with and "line" should appear in the log.
+*/
+
+ {
+#ifdef TESTSUITE_POSIX
+  const size_t          size = 121U;
+  char                  method[size];
+  char                  path[size];
+  char                  line[size];
+  TestSuite::Tokenizer& tokens = tokenizer();
+
+  if (!tokens.next() || !tokens.copy(method, size) || !tokens.next() ||
+    !tokens.copy(path, size) || !tokens.next() || !tokens.copy(line, size))
+   {
+    log() << "  Malformed test case:  " << testCase().text() << endl;
+    return abortThisTest;
+   }
+
+  InnerSuite inner(helperData);
+  bool       succeeded = false;
+
+  if (strcmp(method, "load") == 0)
+    succeeded = inner.suite().load(path);
+  else if (strcmp(method, "unload") == 0)
+    succeeded = inner.suite().unload(path);
+  else if (strcmp(method, "reload") == 0)
+    succeeded = inner.suite().reload(path);
+  else
+   {
+    log() << "  Malformed test case:  " << testCase().text() << endl;
+    return abortThisTest;
+   }
+
+  if (succeeded)
+   {
+    log() << "  \"" << path << "\" shouldn't have been found." << endl;
+    return fail;
+   }
+  else if (!inner.logged(line))
+   {
+    log() << "  \"" << line << "\" wasn't logged." << endl;
+    return fail;
+   }
+#endif
+
+  return pass;
+ }
+
+/*****************************************************************************/
+
+TEST(runResults)
+
+/*
+This test object tests the "TestSuite::RunResult" returned by
+"TestSuite::all()":  the totals and the record of the "outcome" test.
+
+Test case format:
+
+<quoted testData> <unsigned long numCases> <unsigned long numFailedCases>
+  <bool allAborted> <unsigned long numSections> <bool aborted>
+  <unsigned int firstFailedCase> <unsigned long firstFailedLine>
+
+where "testData" is the test data to perform, the next three values are the
+totals and the rest are from the record of "outcome".
+*/
+
+ {
+  const size_t          size = 121U;
+  const size_t          numValues = 7U;
+  const char *const     names[numValues] =
+   {
+    "numCases", "numFailedCases", "allAborted", "numSections", "aborted",
+    "firstFailedCase", "firstFailedLine"
+   };
+  char                  testData[size];
+  long int              expected[numValues];
+  long int              actual[numValues];
+  size_t                index = 0U;
+  TestSuite::Tokenizer& tokens = tokenizer();
+
+  bool wellFormed = tokens.next() && tokens.copy(testData, size);
+
+  for (index = 0U; wellFormed && (index < numValues); ++index)
+    wellFormed = tokens.next() && tokens.toLong(expected[index]);
+
+  if (!wellFormed)
+   {
+    log() << "  Malformed test case:  " << testCase().text() << endl;
+    return abortThisTest;
+   }
+
+  InnerSuite inner(testData);
+
+  const TestSuite::RunResult&             result = inner.suite().all();
+  const TestSuite::RunResult::TestRecord* record = result.test("outcome");
+
+  if (record == NULL)
+   {
+    log() << "  \"outcome\" wasn't performed." << endl;
+    return fail;
+   }
+
+  actual[0] = (long int)result.numCases();
+  actual[1] = (long int)result.numFailedCases();
+  actual[2] = (result.allAborted() ? 1L : 0L);
+  actual[3] = (long int)record->numSections();
+  actual[4] = (record->aborted() ? 1L : 0L);
+  actual[5] = (long int)record->firstFailedCase();
+  actual[6] = (long int)record->firstFailedLine();
+
+  for (index = 0U; index < numValues; ++index)
+   {
+    if (actual[index] != expected[index])
+     {
+      log() << "  \"" << names[index] << "\" is " << actual[index] << "; expected " <<
+        expected[index] << endl;
+      return fail;
+     }
+   }
+
+  return pass;
+ }
+
+/*****************************************************************************/
+
+TEST(historyRuns)
+
+/*
+This test object tests "TestSuite::History" by recording two runs in a
+history file, reading them back and listing the new failures of the second.
+
+Test case format:
+
+<quoted baselineData> <quoted latestData> <quoted newFailures>
+
+where the baseline run (build "b1") performs "baselineData", the latest run
+(build "b2") performs "latestData" and "newFailures" is what
+"newFailures("b1")" should list, separated by spaces.
+*/
+
+ {
+  const size_t          size = 121U;
+  char                  baselineData[size];
+  char                  latestData[size];
+  char                  expected[size];
+  TestSuite::Tokenizer& tokens = tokenizer();
+
+  if (!tokens.next() || !tokens.copy(baselineData, size) || !tokens.next() ||
+    !tokens.copy(latestData, size) || !tokens.next() || !tokens.copy(expected, size))
+   {
+    log() << "  Malformed test case:  " << testCase().text() << endl;
+    return abortThisTest;
+   }
+
+  remove(historyFileName);
+
+  TestSuite::History history(historyFileName);
+  InnerSuite         baseline(baselineData);
+  InnerSuite         latest(latestData);
+
+  baseline.suite().setHistory(&history);
+  history.beginRun("run1", "b1");
+  baseline.suite().all();
+
+  const bool wroteBaseline = history.endRun();
+
+  latest.suite().setHistory(&history);
+  history.beginRun("run2", "b2");
+  latest.suite().all();
+
+  const bool wroteLatest = history.endRun();
+
+  ostrstream              runs;
+  ostrstream              report;
+  const unsigned long int numRuns = history.listRuns(runs);
+
+  history.newFailures("b1", report);
+  report << ends;
+
+  char *const listed = report.str();
+
+  for (char* position = listed; *position != '\0'; ++position)
+   {
+    if ((*position == '\n') && (position[1] != '\0'))
+      *position = ' ';
+    else if (*position == '\n')
+      *position = '\0';
+   }
+
+  const bool matched = (strcmp(listed, expected) == 0);
+
+  report.rdbuf()->freeze(0);
+  remove(historyFileName);
+
+  if (!wroteBaseline || !wroteLatest || (numRuns != 2UL))
+   {
+    log() << "  The runs weren't written and read back." << endl;
+    return fail;
+   }
+  else if (!matched)
+   {
+    log() << "  The wrong new failures were listed; expected \"" << expected << "\"" <<
+      endl;
+    return fail;
+   }
+  else
+    return pass;
+ }
+
+/*****************************************************************************/
+
+TEST(failuresFirst)
+
+/*
+This test object tests "TestSuite::setFailuresFirst()", "setFailFast()" and
+"cancel()".  A run of "historyData" is recorded in a history file and then
+"testData" is performed with "setFailuresFirst(5U)".
+
+Test case format:
+
+<quoted historyData> <quoted testData> <bool failFast> <bool cancelFirst>
+  <quoted testNames>
+
+where "failFast" is given to "setFailFast()", "cancelFirst" is 1 if
+"cancel()" should be called before "testData" is performed (0 otherwise) and
+"testNames" is the names of the tests that should be performed, in order.
+*/
+
+ {
+  const size_t          size = 121U;
+  char                  historyData[size];
+  char                  testData[size];
+  char                  expected[size];
+  char                  performed[size];
+  long int              failFast = 0L;
+  long int              cancelFirst = 0L;
+  TestSuite::Tokenizer& tokens = tokenizer();
+
+  if (!tokens.next() || !tokens.copy(historyData, size) || !tokens.next() ||
+    !tokens.copy(testData, size) || !tokens.next() || !tokens.toLong(failFast) ||
+    !tokens.next() || !tokens.toLong(cancelFirst) || !tokens.next() ||
+    !tokens.copy(expected, size))
+   {
+    log() << "  Malformed test case:  " << testCase().text() << endl;
+    return abortThisTest;
+   }
+
+  remove(historyFileName);
+
+  TestSuite::History history(historyFileName);
+  InnerSuite         earlier(historyData);
+  InnerSuite         inner(testData);
+
+  earlier.suite().setHistory(&history);
+  history.beginRun("run1", "b1");
+  earlier.suite().all();
+  history.endRun();
+
+  inner.suite().setHistory(&history);
+  inner.suite().setFailuresFirst(5U);
+  inner.suite().setFailFast(failFast != 0L);
+
+  if (cancelFirst != 0L)
+    TestSuite::cancel();
+
+  const TestSuite::RunResult& result = inner.suite().all();
+  const bool                  cancelled = (cancelFirst != 0L) ||
+                                ((failFast != 0L) && (result.numFailedCases() > 0UL));
+
+  joinTestNames(result, performed, size);
+  remove(historyFileName);
+
+  if (strcmp(performed, expected) != 0)
+   {
+    log() << "  \"" << performed << "\" was performed; expected \"" << expected << "\"" <<
+      endl;
+    return fail;
+   }
+  else if (result.cancelled() != cancelled)
+   {
+    log() << "  The run should " << (result.cancelled() ? "not " : "") << "have been " <<
+      "cancelled." << endl;
+    return fail;
+   }
+  else
+    return pass;
+ }
+
+/*****************************************************************************/
+
+TEST(parallelRuns)
+
+/*
+This test object tests "TestSuite::setWorkers()" by performing "testData" in
+one process and then in worker processes, recording both runs in a history
+file, and comparing them.  It's only tested if "TESTSUITE_POSIX" is defined.
+
+Test case format:
+
+<quoted testData> <unsigned int numWorkers> <quoted summary>
+
+where "summary" is what "History::listRuns()" should list for each run (e.g.
+"1 of 5 test cases failed").
+*/
+
+ {
+#ifdef TESTSUITE_POSIX
+  const size_t          size = 121U;
+  char                  testData[size];
+  char                  summary[size];
+  char                  serialNames[size];
+  char                  parallelNames[size];
+  long int              numWorkers = 0L;
+  TestSuite::Tokenizer& tokens = tokenizer();
+
+  if (!tokens.next() || !tokens.copy(testData, size) || !tokens.next() ||
+    !tokens.toLong(numWorkers) || (numWorkers < 2L) || !tokens.next() ||
+    !tokens.copy(summary, size))
+   {
+    log() << "  Malformed test case:  " << testCase().text() << endl;
+    return abortThisTest;
+   }
+
+  remove(historyFileName);
+
+  TestSuite::History history(historyFileName);
+  InnerSuite         serial(testData);
+  InnerSuite         parallel(testData);
+  ostrstream         runs;
+  ostrstream         newFailures;
+
+  serial.suite().setHistory(&history);
+  history.beginRun("serial", "b1");
+  joinTestNames(serial.suite().all(), serialNames, size);
+  history.endRun();
+
+  parallel.suite().setHistory(&history);
+  parallel.suite().setWorkers((unsigned int)numWorkers, 0.0001);
+  history.beginRun("parallel", "b2");
+  joinTestNames(parallel.suite().all(), parallelNames, size);
+  history.endRun();
+
+  history.listRuns(runs);
+
+  const unsigned long int numNew = history.newFailures("b1", newFailures);
+
+  runs << ends;
+
+  const char *const first  = strstr(runs.str(), summary);
+  const bool        listed = (first != NULL) && (strstr(first + 1, summary) != NULL);
+
+  runs.rdbuf()->freeze(0);
+  remove(historyFileName);
+
+  if (strcmp(serialNames, parallelNames) != 0)
+   {
+    log() << "  The workers performed \"" << parallelNames << "\"; expected \"" <<
+      serialNames << "\"" << endl;
+    return fail;
+   }
+  else if (!listed || (numNew != 0UL))
+   {
+    log() << "  The runs weren't both recorded as \"" << summary << "\"" << endl;
+    return fail;
+   }
+#endif
+
+  return pass;
+ }
+
+/*****************************************************************************/
+
+TEST(busy)
+
+/*
+This is a helper test for "profiling".  Each test case is the number of
+milliseconds of processor time to use up before passing.
+*/
+
+ {
+  long int              milliseconds = 0L;
+  TestSuite::Tokenizer& tokens = tokenizer();
+
+  if (tokens.next())
+    tokens.toLong(milliseconds);
+
+  const clock_t end = clock() + (clock_t)(milliseconds * (long int)CLOCKS_PER_SEC / 1000L);
+
+  while (clock() < end)
+    ;
+
+  return pass;
+ }
+
+/*****************************************************************************/
+
+TEST(profiling)
+
+/*
+This test object tests "TestSuite::Profiler" by sampling "testData" and
+looking for a line in the folded stacks.  It's only tested if
+"TESTSUITE_POSIX" is defined on Linux.
+
+Test case format:
+
+<quoted testData> <quoted text> <bool found>
+
+where "found" is 1 if "text" should appear in the folded stacks (0
+otherwise).
+*/
+
+ {
+#if defined(TESTSUITE_POSIX) && defined(__linux__)
+  const size_t          size = 121U;
+  char                  testData[size];
+  char                  text[size];
+  long int              found = 0L;
+  TestSuite::Tokenizer& tokens = tokenizer();
+
+  if (!tokens.next() || !tokens.copy(testData, size) || !tokens.next() ||
+    !tokens.copy(text, size) || !tokens.next() || !tokens.toLong(found))
+   {
+    log() << "  Malformed test case:  " << testCase().text() << endl;
+    return abortThisTest;
+   }
+
+  InnerSuite           inner(testData);
+  ostrstream           folded;
+  TestSuite::Profiler  profiler;
+
+  inner.suite().setProfiler(&profiler);
+
+  if (!profiler.start())
+   {
+    log() << "  The profiler couldn't be started." << endl;
+    return abortThisTest;
+   }
+
+  inner.suite().all();
+  profiler.stop();
+  profiler.write(folded);
+
+  if (logContains(folded, text) != (found != 0L))
+   {
+    log() << "  \"" << text << "\" was " << (found != 0L ? "not " : "") << "sampled." << endl;
+    return fail;
+   }
+#endif
+
+  return pass;
+ }
+
+/*****************************************************************************/
+
+TEST(virtualTime)
+
+/*
+This test object tests the virtual clock:  timers are added, the time is
+moved forward and the timers that expire are noted in order.  Each test case
+should also start at time 0.0 with no timers pending, even though the one
+before it left some.
+
+Test case format:
+
+<quoted dueTimes> <double seconds> <quoted fired> <double now>
+
+where "dueTimes" is when the timers are due (the first is labelled "1", the
+second "2" and so on), the time is moved forward "seconds" (or until there
+are no timers left if "seconds" is negative), "fired" is the labels of the
+timers that should expire, in order, and "now" is the time it should be
+afterward.
+*/
+
+ {
+  static const char *const labels[] = {"1", "2", "3", "4", "5", "6", "7", "8"};
+
+  const size_t          size = 81U;
+  char                  dueTimes[size];
+  char                  expected[size];
+  double                seconds = 0.0;
+  double                now = 0.0;
+  double                due = 0.0;
+  unsigned int          numTimers = 0U;
+  TestSuite::Tokenizer& tokens = tokenizer();
+
+  if (!tokens.next() || !tokens.copy(dueTimes, size) || !tokens.next() ||
+    !tokens.toDouble(seconds) || !tokens.next() || !tokens.copy(expected, size) ||
+    !tokens.next() || !tokens.toDouble(now))
+   {
+    log() << "  Malformed test case:  " << testCase().text() << endl;
+    return abortThisTest;
+   }
+
+  TestSuite::VirtualClock& testClock = virtualClock();
+
+  if ((testClock.now() != 0.0) || (testClock.numTimers() != 0UL))
+   {
+    log() << "  The virtual clock wasn't reset." << endl;
+    return fail;
+   }
+
+  istrstream times(dueTimes);
+
+  while ((numTimers < sizeof(labels) / sizeof(labels[0])) && (times >> due))
+    testClock.addTimer(due, noteTimer, (void*)labels[numTimers++]);
+
+  firedTimers[0] = '\0';
+
+  if (seconds < 0.0)
+    testClock.runUntilIdle();
+  else
+    testClock.advance(seconds);
+
+  if (strcmp(firedTimers, expected) != 0)
+   {
+    log() << "  \"" << firedTimers << "\" expired; expected \"" << expected << "\"" <<
+      endl;
+    return fail;
+   }
+  else if (testClock.now() != now)
+   {
+    log() << "  The time is " << testClock.now() << "; expected " << now << endl;
+    return fail;
+   }
+  else
+    return pass;
+ }
+
+/*****************************************************************************/
+
+TEST(tokenizing)
+
+/*
+This test object tests how "TestSuite::Tokenizer" splits text into tokens.
+
+Test case format:
+
+<quoted text> <quoted tokens>
+
+where "tokens" is the tokens that "text" should be split into, each followed
+by "|", with "!" at the end if the last one is a quoted string with no
+closing quote.
+*/
+
+ {
+  const size_t          size = 121U;
+  char                  text[size];
+  char                  expected[size];
+  char                  token[size];
+  char                  found[size];
+  TestSuite::Tokenizer& tokens = tokenizer();
+
+  if (!tokens.next() || !tokens.copy(text, size) || !tokens.next() ||
+    !tokens.copy(expected, size))
+   {
+    log() << "  Malformed test case:  " << testCase().text() << endl;
+    return abortThisTest;
+   }
+
+  TestSuite::Tokenizer split(text);
+
+  found[0] = '\0';
+
+  while (split.next() && split.copy(token, size) &&
+    (strlen(found) + strlen(token) + 2U <= size))
+   {
+    strcat(found, token);
+    strcat(found, "|");
+   }
+
+  if (split.bad() && (strlen(found) + 2U <= size))
+    strcat(found, "!");
+
+  if (strcmp(found, expected) == 0)
+    return pass;
+  else
+   {
+    log() << "  \"" << found << "\" was found; expected \"" << expected << "\"" << endl;
+    return fail;
+   }
+ }
+
+/*****************************************************************************/
+
+TEST(duplicates)
+
+/*
+This test object tests "TestSuite::setSkipDuplicates()" by performing
+"testData" with duplicates being skipped (and, if "TESTSUITE_POSIX" is
+defined, with two worker processes asked for).
+
+Test case format:
+
+<quoted testData> <unsigned long numCases> <unsigned long numDuplicates>
+  <quoted line>
+
+where "numCases" and "numDuplicates" are the numbers of test cases that
+should be applied and skipped and "line" should appear in the log.
+*/
+
+ {
+  const size_t          size = 121U;
+  char                  testData[size];
+  char                  line[size];
+  long int              numCases = 0L;
+  long int              numDuplicates = 0L;
+  TestSuite::Tokenizer& tokens = tokenizer();
+
+  if (!tokens.next() || !tokens.copy(testData, size) || !tokens.next() ||
+    !tokens.toLong(numCases) || !tokens.next() || !tokens.toLong(numDuplicates) ||
+    !tokens.next() || !tokens.copy(line, size))
+   {
+    log() << "  Malformed test case:  " << testCase().text() << endl;
+    return abortThisTest;
+   }
+
+  InnerSuite inner(testData);
+
+  inner.suite().setSkipDuplicates(true);
+
+#ifdef TESTSUITE_POSIX
+  inner.suite().setWorkers(2U);
+#endif
+
+  const TestSuite::RunResult& result = inner.suite().all();
+
+  if (((long int)result.numCases() != numCases) ||
+    ((long int)result.numDuplicates() != numDuplicates))
+   {
+    log() << "  " << result.numCases() << " test cases were applied and " <<
+      result.numDuplicates() << " were skipped; expected " << numCases << " and " <<
+      numDuplicates << endl;
+    return fail;
+   }
+  else if (!inner.logged(line))
+   {
+    log() << "  \"" << line << "\" wasn't logged." << endl;
+    return fail;
+   }
+  else
+    return pass;
+ }
+
+/*****************************************************************************/
+
+TEST(coverageMapping)
+
+/*
+This test object tests "TestSuite::CoverageMap" and "TestSuite::changed()" by
+reading "map", writing it out and reading that back, marking "changedFiles"
+as changed in the copy and performing "helperData" with it.
+
+Test case format:
+
+<quoted map> <quoted changedFiles> <quoted testNames>
+
+where "changedFiles" is separated by spaces and "testNames" is the names of
+the tests that should be performed, separated by spaces, or "!" if "map"
+isn't a valid map.
+*/
+
+ {
+  const size_t           size = 121U;
+  char                   mapText[size];
+  char                   changedFiles[size];
+  char                   expected[size];
+  char                   found[size];
+  char                   path[size];
+  TestSuite::Tokenizer&  tokens = tokenizer();
+  TestSuite::CoverageMap map;
+  TestSuite::CoverageMap copy;
+
+  if (!tokens.next() || !tokens.copy(mapText, size) || !tokens.next() ||
+    !tokens.copy(changedFiles, size) || !tokens.next() || !tokens.copy(expected, size))
+   {
+    log() << "  Malformed test case:  " << testCase().text() << endl;
+    return abortThisTest;
+   }
+
+  istrstream mapStream(mapText);
+
+  if (!map.read(mapStream))
+   {
+    if (strcmp(expected, "!") == 0)
+      return pass;
+
+    log() << "  The map wasn't read." << endl;
+    return fail;
+   }
+
+  ostrstream written;
+  ostrstream rewritten;
+
+  map.write(written);
+  written << ends;
+
+  istrstream copyStream(written.str());
+  const bool copied = copy.read(copyStream);
+
+  copy.write(rewritten);
+  rewritten << ends;
+
+  const bool same = (strcmp(written.str(), rewritten.str()) == 0);
+
+  written.rdbuf()->freeze(0);
+  rewritten.rdbuf()->freeze(0);
+
+  if (!copied || !same)
+   {
+    log() << "  The map that was written wasn't read back the same." << endl;
+    return fail;
+   }
+
+  TestSuite::Tokenizer changed(changedFiles);
+
+  while (changed.next() && changed.copy(path, size))
+    copy.addChanged(path);
+
+  InnerSuite inner(helperData);
+
+  joinTestNames(inner.suite().changed(copy), found, size);
+
+  if (strcmp(found, expected) != 0)
+   {
+    log() << "  \"" << found << "\" were performed; expected \"" << expected << "\"" <<
+      endl;
+    return fail;
+   }
+  else if ((copy.numUnmatched() > 0UL) && !inner.logged(copy.unmatched(0UL)))
+   {
+    log() << "  The unmatched file \"" << copy.unmatched(0UL) << "\" wasn't logged." <<
+      endl;
+    return fail;
+   }
+  else
+    return pass;
+ }
+
+/*****************************************************************************/
+
+TEST(logArchiving)
+
+/*
+This test object tests "TestSuite::LogArchive" and "TestSuite::LogReader" by
+writing "numCopies" copies of "text" to an archive whose blocks hold
+"blockSize" characters, each copy marked as a test case of the test "copy",
+and reading them back, both before and after the archive is closed.
+
+Test case format:
+
+<quoted text> <unsigned long numCopies> <unsigned long blockSize>
+*/
+
+ {
+  const size_t          size = 121U;
+  char                  text[size];
+  long int              numCopies = 0L;
+  long int              blockSize = 0L;
+  TestSuite::Tokenizer& tokens = tokenizer();
+
+  if (!tokens.next() || !tokens.copy(text, size) || (text[0] == '\0') ||
+    !tokens.next() || !tokens.toLong(numCopies) || (numCopies <= 0L) ||
+    !tokens.next() || !tokens.toLong(blockSize) || (blockSize <= 0L))
+   {
+    log() << "  Malformed test case:  " << testCase().text() << endl;
+    return abortThisTest;
+   }
+
+  ostrstream            all;
+  TestSuite::LogArchive archive(archiveFileName, (unsigned long int)blockSize);
+  ostream               archiveLog(&archive);
+  bool                  ok = true;
+
+  for (long int i = 1L; i <= numCopies; ++i)
+   {
+    archive.mark("copy", (unsigned int)i);
+    archiveLog << text;
+    all << text;
+   }
+
+  all << ends;
+  archive.flushBlock();
+
+  TestSuite::LogReader unclosed(archiveFileName);
+  ostrstream           unclosedText;
+
+  if (!unclosed.good() || unclosed.indexed() || !unclosed.extractAll(unclosedText) ||
+    !sameText(unclosedText, all.str()))
+   {
+    log() << "  The text wasn't read back before the archive was closed." << endl;
+    ok = false;
+   }
+
+  if (!archive.close())
+   {
+    log() << "  The archive wasn't closed." << endl;
+    ok = false;
+   }
+
+  TestSuite::LogReader reader(archiveFileName);
+  ostrstream           allText;
+  ostrstream           testText;
+  ostrstream           extraText;
+
+  if (!reader.good() || !reader.indexed() || !reader.extractAll(allText) ||
+    !sameText(allText, all.str()) || !reader.extractTest(testText, "copy") ||
+    !sameText(testText, all.str()))
+   {
+    log() << "  The text wasn't read back after the archive was closed." << endl;
+    ok = false;
+   }
+
+  for (long int i = 1L; ok && (i <= numCopies); ++i)
+   {
+    ostrstream caseText;
+
+    if (!reader.extractCase(caseText, "copy", (unsigned int)i) ||
+      !sameText(caseText, text))
+     {
+      log() << "  Copy " << i << " wasn't read back." << endl;
+      ok = false;
+     }
+   }
+
+  if (ok && reader.extractCase(extraText, "copy", (unsigned int)numCopies + 1U))
+   {
+    log() << "  A copy that wasn't written was read back." << endl;
+    ok = false;
+   }
+
+  all.rdbuf()->freeze(0);
+  remove(archiveFileName);
+
+  return (ok ? pass : fail);
+ }
+
+/*****************************************************************************/
+
+TEST(benchmarkMedians)
+
+/*
+This test object tests how "TestSuite::Benchmark" sums up the times of a
+test case's timed runs.
+
+Test case format:
+
+<quoted line> <double time>...
+
+where "times" are the times of the runs (at most 10 of them) and "line" is
+what "write()" should write for them, for test case 1 of the test "x" in the
+warm state.
+*/
+
+ {
+  const size_t          size = 121U;
+  const unsigned int    maxRuns = 10U;
+  char                  expected[size];
+  double                times[maxRuns];
+  unsigned int          numRuns = 0U;
+  TestSuite::Tokenizer& tokens = tokenizer();
+  bool                  ok = tokens.next() && tokens.copy(expected, size);
+
+  while (ok && tokens.next())
+    ok = (numRuns < maxRuns) && tokens.toDouble(times[numRuns++]);
+
+  if (!ok || (numRuns == 0U))
+   {
+    log() << "  Malformed test case:  " << testCase().text() << endl;
+    return abortThisTest;
+   }
+
+  TestSuite::Benchmark benchmark(TestSuite::Benchmark::warm, numRuns);
+  ostrstream           written;
+
+  benchmark.record("x", 1U, TestSuite::Benchmark::warm, times);
+  benchmark.write(written);
+
+  if (!logContains(written, expected))
+   {
+    written << ends;
+    log() << "  \"" << written.str() << "\" was written; expected \"" << expected << "\"" <<
+      endl;
+    written.rdbuf()->freeze(0);
+    return fail;
+   }
+  else
+    return pass;
+ }
+
+/*****************************************************************************/
+
+TEST(benchmarking)
+
+/*
+This test object tests "TestSuite::setBenchmark()" by performing "testData"
+with each test case timed in "states", 3 times in each, and checking that
+the re-runs aren't counted in the tests' durations.
+
+Test case format:
+
+<quoted testData> <unsigned long states> <unsigned long numMeasurements>
+
+where "states" is 1 for cold, 2 for warm, 3 for both or 0 for neither and
+"numMeasurements" is how many test case and state pairs should be timed.
+*/
+
+ {
+  const size_t          size = 121U;
+  char                  testData[size];
+  long int              states = 0L;
+  long int              numMeasurements = 0L;
+  TestSuite::Tokenizer& tokens = tokenizer();
+
+  if (!tokens.next() || !tokens.copy(testData, size) || !tokens.next() ||
+    !tokens.toLong(states) || !tokens.next() || !tokens.toLong(numMeasurements))
+   {
+    log() << "  Malformed test case:  " << testCase().text() << endl;
+    return abortThisTest;
+   }
+
+  InnerSuite           inner(testData);
+  TestSuite::Benchmark benchmark((unsigned int)states, 3U, 1048576UL);
+
+  inner.suite().setBenchmark(&benchmark);
+
+  const TestSuite::RunResult&             result = inner.suite().all();
+  const TestSuite::RunResult::TestRecord* record = result.tests();
+
+  if ((long int)benchmark.numMeasurements() != numMeasurements)
+   {
+    log() << "  " << benchmark.numMeasurements() << " were timed; expected " <<
+      numMeasurements << endl;
+    return fail;
+   }
+
+  /*
+  A test's duration should come to about the total of its test cases' median
+  times in one state, and so no more than the total in all of them, whereas
+  it would be several times that if the re-runs were counted.
+  */
+
+  for (; record != NULL; record = record->next())
+   {
+    ostrstream        written;
+    double            median;
+    double            totalMedians = 0.0;
+    unsigned long int numFields = 0UL;
+
+    benchmark.write(written, record->name());
+    written << ends;
+
+    TestSuite::Tokenizer fields(written.str());
+
+    /*
+    Each line is the name, test case, state, fastest, median and mean.
+    */
+
+    while (fields.next())
+     {
+      if ((numFields++ % 6UL == 4UL) && fields.toDouble(median))
+        totalMedians += median;
+     }
+
+    written.rdbuf()->freeze(0);
+
+    if ((numFields > 0UL) && (record->duration() > totalMedians + 0.02))
+     {
+      log() << "  \"" << record->name() << "\" took " << record->duration() <<
+        " seconds; its medians came to " << totalMedians << endl;
+      return fail;
+     }
+   }
+
+  return pass;
+ }
+
+/*****************************************************************************/
+
+TEST(serving)
+
+/*
+This test object tests "TestSuite::serve()" by sending it requests for
+"helperData" and looking for a line in the replies.
+
+Test case format:
+
+<quoted requests> <bool stopped> <quoted line>
+
+where "requests" is the session's requests (separated by "\n"), "stopped"
+is 1 if the session should end with a "stop" request (0 otherwise) and
+"line" should appear in the replies.
+*/
+
+ {
+  const size_t          size = 121U;
+  char                  requests[size];
+  char                  line[size];
+  long int              stopped = -1L;
+  TestSuite::Tokenizer& tokens = tokenizer();
+
+  if (!tokens.next() || !tokens.copy(requests, size) || !tokens.next() ||
+    !tokens.toLong(stopped) || !tokens.next() || !tokens.copy(line, size))
+   {
+    log() << "  Malformed test case:  " << testCase().text() << endl;
+    return abortThisTest;
+   }
+
+  InnerSuite inner(helperData);
+  istrstream requestStream(requests);
+  ostrstream replies;
+
+  if (inner.suite().serve(requestStream, replies) != (stopped != 0L))
+   {
+    log() << "  The session should " << (stopped != 0L ? "" : "not ") << "have stopped the "
+      "server." << endl;
+    return fail;
+   }
+  else if (!logContains(replies, line))
+   {
+    log() << "  \"" << line << "\" wasn't in the replies." << endl;
+    return fail;
+   }
+  else
+    return pass;
+ }
+
+/*****************************************************************************/
+
 int main
  (
   const unsigned int argc,
@@ -13,7 +13,9 @@
 
 #include <iostream.h>
 #include <stdarg.h>
+#include <limits.h>
 #include <assert.h>
+#include <signal.h>
 
 #ifdef FAT_FILENAMES
   #include <strstrea.h>
@@ -21,6 +23,10 @@
   #include <strstream.h>
 #endif
 
+#if defined(TESTSUITE_POSIX) && defined(__linux__)
+  #include <fstream.h>
+#endif
+
 #include <platform.h>
 
 // ============================================================================================
@@ -28,10 +34,16 @@
 // ============================================================================================
 
 #define TEST(testName)                                                                        \
+  TAGGED_TEST(testName, "")
+
+#define TAGGED_TEST(testName, tagList)                                                        \
   class TestSuite_Test_##testName##:                                                          \
     public TestSuite::Test                                                                    \
   {                                                                                           \
     public:                                                                                   \
+                                TestSuite_Test_##testName##():                                \
+                                  TestSuite::Test(tagList)                                    \
+                                  {return;}                                                   \
       virtual const char *const name() const                                                  \
                                   {return #testName;}                                         \
       virtual const TestResult  testMethod();                                                 \
@@ -48,6 +60,12 @@
 class TestSuite
 {
   public:
+    typedef unsigned long TagSet;       // one bit for each tag in the tag table
+
+    enum
+    {
+      maxTags = sizeof(TagSet) * CHAR_BIT   // the most distinct tags that can be declared
+    };
 
     // ----------------------------------------------------------------------------------------
 
@@ -60,26 +78,66 @@ class TestSuite
         const unsigned long int lineCounter() const
                                   {return _lineCounter;}
 
-      private:
+      protected:
         friend class TestSuite;
 
-        istream *const    _dataStream;
+        istream*          _dataStream;
         unsigned long int _lineCounter;
+        unsigned long int _numReads;        // no. of calls to "readLine()" (even at the end)
 
         void reset();
     };
 
     // ----------------------------------------------------------------------------------------
 
+    class TestData;
+
+    class Section
+    {
+      public:
+                                Section(const char *const, const streampos,
+                                  const unsigned long int);
+                                ~Section()
+                                  {delete[] (char*)_name; return;}
+
+        const char *const       name() const
+                                  {return _name;}
+        const streampos         offset() const
+                                  {return _offset;}
+        const unsigned long int lineCounter() const
+                                  {return _lineCounter;}
+        const unsigned long int numCases() const
+                                  {return _numCases;}
+        const unsigned long int hash() const
+                                  {return _hash;}
+        const Section *const    next() const
+                                  {return _next;}
+
+      private:
+        friend class TestData;
+
+        const char *const       _name;          // the test name that starts the section
+        const streampos         _offset;        // where the line after the test name starts
+        const unsigned long int _lineCounter;   // the line number of the test name
+        unsigned long int       _numCases;      // no. of test case (and extra data) lines
+        unsigned long int       _hash;          // hash of the text of the test case lines
+        Section*                _next;          // the next section in the test data stream
+    };
+
+    // ----------------------------------------------------------------------------------------
+
     class TestData:
       public TestDataRaw
     {
       public:
-                          TestData(istream&);
-                          ~TestData();
+                             TestData(istream&);
+                             ~TestData();
 
-        const char *const readTestName();
-        const char *const readTestCase();
+        const char *const    readTestName();
+        const char *const    readTestCase();
+        const Section *const indexSections();
+        void                 seek(const Section&);
+        void                 redirect(istream&, const unsigned long int);
 
       private:
         const char* _lastLineRead;       // the last line of text that was read from readLine()
@@ -98,6 +156,8 @@ class TestSuite
                              {return _number;}
         const unsigned int lineCounter() const
                              {return _lineCounter;}
+        const char *const  text() const
+                             {return _dataAsText;}
         istream&           data()
                              {return _data;}
 
@@ -110,6 +170,140 @@ class TestSuite
 
     // ----------------------------------------------------------------------------------------
 
+    class Tokenizer
+    {
+      public:
+                          Tokenizer(const char *const = "");
+                          ~Tokenizer()
+                            {delete[] _buffer; return;}
+
+        void              reset(const char *const);
+        const bool        next();
+        const char *const text() const
+                            {return _token;}
+        const size_t      length() const
+                            {return _length;}
+        const bool        quoted() const
+                            {return _quoted;}
+        const bool        bad() const
+                            {return _bad;}
+        const bool        equals(const char *const) const;
+        const bool        copy(char *const, const size_t) const;
+        const bool        toLong(long int&) const;
+        const bool        toDouble(double&) const;
+
+      private:
+        const char* _position;                  // where the next token is looked for
+        const char* _token;                     // the current token (not NUL-terminated)
+        size_t      _length;                    // no. of characters in "_token"
+        bool        _quoted;                    // was "_token" a quoted string?
+        bool        _bad;                       // was a quoted string left unterminated?
+        char*       _buffer;                    // where escape sequences are decoded into
+        size_t      _capacity;                  // no. of characters allocated in "_buffer"
+
+                          Tokenizer(const Tokenizer&);
+        Tokenizer&        operator=(const Tokenizer&);
+        const bool        nextQuoted();
+    };
+
+    // ----------------------------------------------------------------------------------------
+
+    class NameTable
+    {
+      public:
+                                NameTable();
+                                ~NameTable()
+                                  {clear(); return;}
+
+        const unsigned long int number(const char *const);
+        const unsigned long int find(const char *const) const;
+        const char *const       name(const unsigned long int i) const
+                                  {assert(i < _numNames); return _names[i];}
+        const unsigned long int numNames() const
+                                  {return _numNames;}
+        void                    clear();
+
+      private:
+        char**             _names;                      // the names, in the order added
+        unsigned long int  _numNames;                   // no. of entries in use in "_names"
+        unsigned long int  _capacity;                   // no. of entries allocated in "_names"
+        unsigned long int* _table;                      // "_names" indices + 1, by name hash
+        unsigned long int  _tableSize;                  // no. of entries in "_table"
+        unsigned long int  _lastName;                   // the entry "number()" last returned
+
+                                NameTable(const NameTable&);
+        NameTable&              operator=(const NameTable&);
+        const unsigned long int slot(const char *const) const;
+    };
+
+    // ----------------------------------------------------------------------------------------
+
+    class Clock
+    {
+      public:
+        virtual              ~Clock()
+                               {return;}
+        virtual const double now() = 0;
+        virtual void         sleep(const double) = 0;
+    };
+
+    // ----------------------------------------------------------------------------------------
+
+    class RealClock:
+      public Clock
+    {
+      public:
+        virtual const double now()
+                               {return timeStamp();}
+        virtual void         sleep(const double);
+    };
+
+    // ----------------------------------------------------------------------------------------
+
+    class VirtualClock:
+      public Clock
+    {
+      public:
+        typedef void (*Callback)(void *const);  // called when a timer expires
+
+                                VirtualClock();
+                                ~VirtualClock()
+                                  {reset(); return;}
+
+        virtual const double    now()
+                                  {return _now;}
+        virtual void            sleep(const double);
+        const unsigned long int addTimer(const double, const Callback, void *const = NULL);
+        const bool              cancelTimer(const unsigned long int);
+        const unsigned long int advance(const double);
+        const unsigned long int runUntilIdle(const double = 31536000.0);
+        const unsigned long int numTimers() const
+                                  {return _numTimers;}
+        void                    reset();
+
+      private:
+        class Timer
+        {
+          public:
+            double            due;                       // when it expires
+            unsigned long int id;                        // what "addTimer()" returned for it
+            Callback          callback;                  // what to call when it expires
+            void*             context;                   // what to pass to "callback"
+            Timer*            next;                      // the timer that expires after it
+        };
+
+        double            _now;                          // seconds since the test case began
+        unsigned long int _lastId;                       // the latest timer id handed out
+        Timer*            _timers;                       // pending timers, soonest first
+        unsigned long int _numTimers;                    // no. of timers in "_timers"
+
+                          VirtualClock(const VirtualClock&);
+        VirtualClock&     operator=(const VirtualClock&);
+        const bool        fireNext(const double);
+    };
+
+    // ----------------------------------------------------------------------------------------
+
     class Test
     {
       public:
@@ -121,8 +315,11 @@ class TestSuite
           abortAllTests   // the test failed, and testing should cease (a catastrophe occurred)
         };
 
-                                  Test();
+                                  Test(const char *const = "");
+        virtual                   ~Test();
         virtual const char *const name() const = 0;
+        const TagSet              tags() const
+                                    {return _tags;}
 
 	    protected:
 	      TestSuite::TestCase&      testCase()
@@ -131,13 +328,20 @@ class TestSuite
 	                                  {return *_testData;}
 	      ostream&                  log()
 	                                  {return *_log;}
+        TestSuite::VirtualClock&  virtualClock() const
+                                    {assert(_virtualClock != NULL); return *_virtualClock;}
+        TestSuite::Tokenizer&     tokenizer() const
+                                    {assert(_tokenizer != NULL); return *_tokenizer;}
 
       private:
         friend class TestSuite;
 
-        TestSuite::TestCase*    _testCase;
-        TestSuite::TestDataRaw* _testData;
-        ostream*                _log;
+        TestSuite::TestCase*     _testCase;
+        TestSuite::TestDataRaw*  _testData;
+        ostream*                 _log;
+        TagSet                   _tags;          // the tags declared with "TAGGED_TEST()"
+        TestSuite::VirtualClock* _virtualClock;  // the clock for the test case being applied
+        TestSuite::Tokenizer*    _tokenizer;     // the test case being applied, as tokens
 
         void                     setData(TestSuite::TestCase&, TestSuite::TestDataRaw,
                                    ostream);
@@ -149,29 +353,479 @@ class TestSuite
 
     // ----------------------------------------------------------------------------------------
 
-    static void registerTest(const Test *const);
+    class RunResult
+    {
+      public:
+        class TestRecord
+        {
+          public:
+                                    TestRecord(const char *const);
+                                    ~TestRecord()
+                                      {delete[] (char*)_name; return;}
+
+            const char *const       name() const
+                                      {return _name;}
+            const unsigned long int numSections() const
+                                      {return _numSections;}
+            const unsigned long int numCases() const
+                                      {return _numCases;}
+            const unsigned long int numFailedCases() const
+                                      {return _numFailedCases;}
+            const unsigned long int numDuplicates() const
+                                      {return _numDuplicates;}
+            const bool              aborted() const
+                                      {return _aborted;}
+            const double            duration() const
+                                      {return _duration;}
+            const unsigned int      firstFailedCase() const
+                                      {return _firstFailedCase;}
+            const unsigned long int firstFailedLine() const
+                                      {return _firstFailedLine;}
+            const TestRecord *const next() const
+                                      {return _next;}
+
+          private:
+            friend class TestSuite;
+            friend class RunResult;
+
+            const char *const _name;            // the test's name
+            unsigned long int _numSections;     // no. of sections performed
+            unsigned long int _numCases;        // no. of test cases applied
+            unsigned long int _numFailedCases;  // no. of test cases that failed
+            unsigned long int _numDuplicates;   // no. of duplicate test cases skipped
+            bool              _aborted;         // did a test case abort the test (or testing)?
+            double            _duration;        // seconds spent performing the test
+            unsigned int      _firstFailedCase; // no. of the first test case to fail (or 0U)
+            unsigned long int _firstFailedLine; // where it is in the test data stream
+            TestRecord*       _next;            // the next test performed
+        };
+
+                                RunResult();
+                                ~RunResult()
+                                  {reset(); return;}
+
+        const TestRecord *const tests() const
+                                  {return _firstTest;}
+        const TestRecord *const test(const char *const) const;
+        const unsigned long int numCases() const
+                                  {return _numCases;}
+        const unsigned long int numFailedCases() const
+                                  {return _numFailedCases;}
+        const unsigned long int numDuplicates() const
+                                  {return _numDuplicates;}
+        const bool              allAborted() const
+                                  {return _allAborted;}
+        const bool              cancelled() const
+                                  {return _cancelled;}
+        const double            duration() const
+                                  {return _duration;}
+
+      private:
+        friend class TestSuite;
+
+        TestRecord*       _firstTest;           // the tests performed, in order of first section
+        TestRecord*       _lastTest;            // the last test in "_firstTest"
+        NameTable         _names;               // the tests' names, in the same order
+        TestRecord**      _records;             // the tests, by their numbers in "_names"
+        unsigned long int _capacity;            // no. of entries allocated in "_records"
+        unsigned long int _numCases;            // total no. of test cases applied
+        unsigned long int _numFailedCases;      // total no. of failed test cases
+        unsigned long int _numDuplicates;       // total no. of duplicate test cases skipped
+        bool              _allAborted;          // did a test case abort all testing?
+        bool              _cancelled;           // was testing cancelled before it finished?
+        double            _duration;            // seconds spent testing
+
+                    RunResult(const RunResult&);
+        RunResult&  operator=(const RunResult&);
+        void        reset();
+        TestRecord& record(const Test&);
+    };
+
+    // ----------------------------------------------------------------------------------------
+
+    class History
+    {
+      public:
+                           History(const char *const);
+                           ~History();
+
+        void               beginRun(const char *const, const char *const);
+        const bool         endRun();
+        const bool         recording() const
+                             {return (_run != NULL);}
+        void               startCase();
+        void               endCase(const char *const, const unsigned int,
+                             const Test::TestResult);
+        void               startRelay();
+        char *const        endRelay(unsigned long int&);
+        void               addRelayed(const char *const, const char *const,
+                             const unsigned long int);
+
+        const unsigned int durations(const char *const, const unsigned int, double *const)
+                             const;
+        const bool         percentile(const char *const, const unsigned int, const double,
+                             double&) const;
+        const unsigned long int newFailures(const char *const, ostream&) const;
+        const unsigned long int listRuns(ostream&) const;
+        void               failureCounts(const char *const *const, const unsigned long int,
+                             const unsigned int, unsigned long int *const) const;
+
+      private:
+        const char *const  _fileName;          // the file that the history is stored in
+        ostrstream*        _run;               // the run being recorded (if any)
+        ostrstream*        _relay;             // where test cases go instead (if anywhere)
+        NameTable          _names;             // test names recorded so far in the run
+        double             _caseStartTime;     // when the current test case was started
+        double             _caseStartCpuTime;  // processor time when it was started
+        unsigned long int  _caseStartFaults;   // no. of page faults when it was started
+
+                           History(const History&);
+        History&           operator=(const History&);
+        const unsigned long int nameIndex(const char *const);
+    };
+
+    // ----------------------------------------------------------------------------------------
+
+    class CoverageMap
+    {
+      public:
+                                CoverageMap();
+                                ~CoverageMap()
+                                  {clear(); return;}
+
+        const bool              read(istream&);
+        void                    write(ostream&) const;
+        const unsigned long int addTrace(const char *const, istream&);
+        void                    clearChanged();
+        const unsigned long int addChanged(const char *const);
+        const unsigned long int readChanged(istream&);
+        const bool              contains(const char *const testName) const
+                                  {return (findTest(testName) != NULL);}
+        const bool              affects(const char *const) const;
+        const unsigned long int listAffected(ostream&) const;
+        const unsigned long int numUnmatched() const
+                                  {return _numUnmatched;}
+        const char *const       unmatched(const unsigned long int i) const
+                                  {assert(i < _numUnmatched); return _unmatched[i];}
+        const unsigned long int numTests() const
+                                  {return _testNames.numNames();}
+        const unsigned long int numFiles() const
+                                  {return _numFiles;}
+        void                    clear();
+
+      private:
+        class TestEntry
+        {
+          public:
+            const char*        name;                    // the test's name (in "_testNames")
+            unsigned long int* files;                   // the files it executes, ascending
+            unsigned long int  numFiles;                // no. of entries in "files"
+            TestEntry*         next;                    // the next test in the map
+        };
+
+        char**             _files;                      // the source files' paths
+        bool*              _changed;                    // which of "_files" have changed
+        unsigned long int  _numFiles;                   // no. of entries in use in "_files"
+        unsigned long int  _capacity;                   // no. allocated in "_files", "_changed"
+        unsigned long int* _table;                      // "_files" indices + 1, by path hash
+        unsigned long int  _tableSize;                  // no. of entries in "_table"
+        TestEntry*         _tests;                      // the tests, in the order added
+        TestEntry*         _lastTest;                   // the last entry in "_tests"
+        NameTable          _testNames;                  // the tests' names, in the same order
+        TestEntry**        _entries;                    // the tests, by "_testNames" number
+        unsigned long int  _entriesCapacity;            // no. allocated in "_entries"
+        char**             _unmatched;                  // changed files that matched nothing
+        unsigned long int  _numUnmatched;               // no. of entries in "_unmatched"
+
+                                CoverageMap(const CoverageMap&);
+        CoverageMap&            operator=(const CoverageMap&);
+        const unsigned long int fileIndex(const char *const);
+        TestEntry *const        findTest(const char *const) const;
+        TestEntry&              test(const char *const);
+        void                    addFiles(TestEntry&, const unsigned long int *const,
+                                  const unsigned long int);
+    };
+
+    // ----------------------------------------------------------------------------------------
+
+    class LogArchive:
+      public streambuf
+    {
+      public:
+                                LogArchive(const char *const,
+                                  const unsigned long int = 262144UL);
+        virtual                 ~LogArchive();
+
+        const bool              good() const;
+        void                    mark(const char *const, const unsigned int);
+        void                    flushBlock();
+        const bool              close();
 
-                TestSuite(istream&, ostream&);
-    void        one(const char *const);
-    void        group(const char *const, ...);
-    void        group(const unsigned int, const char *const *const);
-    void        all();
-    ostream&    log() const
-                  {assert(_log != NULL); return *_log;}
+      protected:
+        virtual int             overflow(int);
+        virtual int             sync();
+
+      private:
+        ostream*                _file;             // the archive file (NULL once closed)
+        const unsigned long int _blockSize;        // no. of characters of text in a block
+        char *const             _block;            // the text of the current block
+        char *const             _packed;           // the current block, compressed
+        unsigned long int       _position;         // no. of characters in earlier blocks
+        unsigned long int       _fileOffset;       // no. of bytes written to "_file"
+        ostrstream              _seekTable;        // the blocks' offsets and text lengths
+        unsigned long int       _numBlocks;        // no. of blocks written
+        ostrstream              _entries;          // the index entries, as they'll be written
+        unsigned long int       _numEntries;       // no. of entries in "_entries"
+        NameTable               _names;            // the test names in the index
+        bool                    _pending;          // is there a mark that isn't in "_entries"?
+        unsigned long int       _pendingName;      // its test name's number
+        unsigned int            _pendingCase;      // its test case number
+        unsigned long int       _pendingPosition;  // where its text starts
+        unsigned long int       _lastPosition;     // where the last entry's text starts
+        double                  _lastWrite;        // when the last block was written
+
+                                LogArchive(const LogArchive&);
+        LogArchive&             operator=(const LogArchive&);
+        void                    writeBlock();
+        void                    writeEntry();
+    };
+
+    // ----------------------------------------------------------------------------------------
+
+    class LogReader
+    {
+      public:
+                                LogReader(const char *const);
+                                ~LogReader();
+
+        const bool              good() const
+                                  {return (_file != NULL);}
+        const bool              indexed() const
+                                  {return _indexed;}
+        const unsigned long int listTests(ostream&) const;
+        const bool              extractAll(ostream&);
+        const bool              extractTest(ostream&, const char *const);
+        const bool              extractCase(ostream&, const char *const, const unsigned int);
+
+      private:
+        istream*           _file;                  // the archive file (NULL if it's unusable)
+        bool               _indexed;               // was the index read?
+        unsigned long int  _blockSize;             // the most text in any block
+        unsigned long int  _numBlocks;             // no. of blocks in the archive
+        unsigned long int* _offsets;               // where each block's header is in "_file"
+        unsigned long int* _starts;                // where each block's text starts in the log
+        char*              _nameText;              // the test names, one after another
+        const char**       _names;                 // the start of each name in "_nameText"
+        unsigned long int  _numNames;              // no. of entries in "_names"
+        unsigned long int  _numEntries;            // no. of index entries
+        unsigned long int* _entryNames;            // each index entry's test name number
+        unsigned int*      _entryCases;            // each index entry's test case number
+        unsigned long int* _entryPositions;        // where each index entry's text starts
+        char*              _block;                 // the text of the block that's loaded
+        char*              _packed;                // a block as it's stored
+        unsigned long int  _loadedBlock;           // the block in "_block" (or "_numBlocks")
+
+                           LogReader(const LogReader&);
+        LogReader&         operator=(const LogReader&);
+        const bool         readIndex();
+        const bool         scanBlocks();
+        const bool         extract(ostream&, const char *const, const bool, const unsigned int);
+        const bool         writeText(ostream&, const unsigned long int,
+                             const unsigned long int);
+        const bool         loadBlock(const unsigned long int);
+    };
+
+    // ----------------------------------------------------------------------------------------
+
+    class Benchmark
+    {
+      public:
+        enum CacheState                 // the states of the caches that test cases are timed in
+        {
+          cold = 1,       // the caches are evicted before each timed run
+          warm = 2        // the test case is run once, untimed, before the timed runs
+        };
+
+                                Benchmark(const unsigned int = cold | warm,
+                                  const unsigned int = 5U,
+                                  const unsigned long int = 67108864UL);
+                                ~Benchmark();
+
+        void                    select(const char *const, const unsigned int,
+                                  const unsigned int = 1U, const unsigned int = UINT_MAX);
+        void                    addFile(const char *const);
+        void                    setDropCaches(const bool dropCaches)
+                                  {_dropCaches = dropCaches; return;}
+        const unsigned int      states(const char *const, const unsigned int) const;
+        const unsigned int      numRuns() const
+                                  {return _numRuns;}
+        const bool              evict();
+        void                    record(const char *const, const unsigned int,
+                                  const CacheState, double *const);
+        const unsigned long int numMeasurements() const
+                                  {return _numMeasurements;}
+        const unsigned long int numUnevicted() const
+                                  {return _numUnevicted;}
+        void                    write(ostream&, const char *const = NULL) const;
+        void                    summarize(ostream&) const;
+        void                    clear();
+
+      private:
+        class Rule
+        {
+          public:
+            char*        testName;                      // the test it applies to
+            unsigned int states;                        // the cache states to time it in
+            unsigned int firstCase;                     // the test cases it applies to
+            unsigned int lastCase;
+            Rule*        next;                          // the rule that was selected before
+        };
+
+        class Measurement
+        {
+          public:
+            unsigned long int name;                     // the test's number in "_names"
+            unsigned int      caseNum;                  // the test case
+            CacheState        state;                    // the state of the caches
+            double            min;                      // the fastest run, in seconds
+            double            median;                   // the median run, in seconds
+            double            mean;                     // the mean run, in seconds
+        };
+
+        const unsigned int      _defaultStates;         // the states for unselected tests
+        const unsigned int      _numRuns;               // no. of timed runs in each state
+        const unsigned long int _sweepSize;             // no. of bytes swept to evict caches
+        char*                   _sweep;                 // what's swept (allocated when needed)
+        volatile unsigned char  _sink;                  // what the sweep read, so it's kept
+        Rule*                   _rules;                 // the selected tests, latest first
+        char**                  _files;                 // files to evict from the page cache
+        unsigned long int       _numFiles;              // no. of entries in "_files"
+        bool                    _dropCaches;            // should the whole page cache go?
+        unsigned long int       _numUnevicted;          // cold runs without page eviction
+        NameTable               _names;                 // the test names measured
+        Measurement*            _measurements;          // the measurements, in order
+        unsigned long int       _numMeasurements;       // no. of entries in use
+        unsigned long int       _capacity;              // no. of entries allocated
+
+                                Benchmark(const Benchmark&);
+        Benchmark&              operator=(const Benchmark&);
+        const bool              evictPages() const;
+    };
+
+    // ----------------------------------------------------------------------------------------
+
+    #ifdef TESTSUITE_POSIX
+      class Profiler
+      {
+        public:
+                                  Profiler(const unsigned long int = 1048576UL);
+                                  ~Profiler();
+
+          const bool              start(const unsigned int = 997U);
+          void                    stop();
+          void                    enterCase(const char *const testName,
+                                    const unsigned int caseNum)
+                                    {_caseNum = caseNum; _testName = testName; return;}
+          void                    leaveCase()
+                                    {_testName = NULL; return;}
+          const unsigned long int numSamples() const
+                                    {return _numSamples;}
+          const unsigned long int numDropped() const
+                                    {return _numDropped;}
+          void                    write(ostream&, const char *const = NULL) const;
+
+        private:
+          static Profiler* volatile        _active;     // the profiler that's sampling (if any)
+
+          void **const                     _pool;       // the samples, one after another
+          const unsigned long int          _capacity;   // no. of entries in "_pool"
+          volatile unsigned long int       _used;       // no. of entries in use
+          volatile unsigned long int       _numSamples; // no. of samples taken
+          volatile unsigned long int       _numDropped; // no. that didn't fit in "_pool"
+          const char* volatile             _testName;   // the test being applied (or NULL)
+          volatile unsigned int            _caseNum;    // the test case being applied
+
+                                  Profiler(const Profiler&);
+          Profiler&               operator=(const Profiler&);
+          const unsigned long int numFrames(const unsigned long int position) const
+                                    {return (unsigned long int)_pool[position + 2U];}
+          static void             takeSample(int);
+      };
+    #endif
+
+    // ----------------------------------------------------------------------------------------
+
+    static void         registerTest(Test *const, const char *const);
+    static void         unregisterTest(const Test *const);
+    static const double timeStamp();
+    static void         cancel();
+
+                     TestSuite(istream&, ostream&);
+    virtual          ~TestSuite();
+    const RunResult& one(const char *const);
+    const RunResult& one(const char *const, const unsigned int);
+    const RunResult& group(const char *const, ...);
+    const RunResult& group(const unsigned int, const char *const *const);
+    const RunResult& tagged(const char *const);
+    const RunResult& changed(const CoverageMap&);
+    const RunResult& shard(const unsigned int, const unsigned int);
+    const RunResult& all();
+    const RunResult& update();
+    void             list();
+    void             index();
+    #if defined(TESTSUITE_POSIX) && defined(__linux__)
+      void           watch(ifstream&, const char *const);
+    #endif
+    void             setHistory(History *const);
+    void             setFailuresFirst(const unsigned int);
+    void             setFailFast(const bool);
+    void             setSkipDuplicates(const bool);
+    void             setLogArchive(LogArchive *const);
+    void             setBenchmark(Benchmark *const);
+    #ifdef TESTSUITE_POSIX
+      void           setWorkers(const unsigned int, const double = 0.05);
+      void           setProfiler(Profiler *const);
+    #endif
+    const bool       serve(istream&, ostream&);
+    #ifdef TESTSUITE_POSIX
+      void           serve(const char *const);
+      const bool     load(const char *const);
+      const bool     unload(const char *const);
+      const bool     reload(const char *const);
+    #endif
+    const RunResult& result() const
+                       {return _result;}
+    ostream&         log() const
+                       {assert(_log != NULL); return *_log;}
 
   protected:
     virtual void logHeader() const
                    {return;}
     virtual void logTestHeader(const Test&) const;
     virtual void logUnknownTestName(const char *const) const;
+    virtual void logUnknownTagName(const char *const) const;
+    virtual void logBadTagExpression(const char *const) const;
+    virtual void logDroppedTags(const char *const) const;
+    virtual void logWorkersNotUsed(const char *const) const;
+    virtual void logNoAffectedTests() const;
+    virtual void logUnmatchedFiles(const CoverageMap&) const;
+    virtual void logListedSection(const Section&, const Test&) const;
+    virtual void logListedTest(const Test&, const unsigned long int, const unsigned long int)
+                   const;
     virtual void logTestCasePassed(const Test&, const TestCase&) const
                    {return;}
     virtual void logTestCaseFailed(const Test&, const TestCase&) const;
     virtual void logTestAborted(const Test&) const;
     virtual void logAllTestsAborted() const;
+    virtual void logCancelled() const;
+    virtual void logDuplicatesSkipped(const Test&, const unsigned int) const;
     virtual void logTestFooter(const Test&, const unsigned int, const unsigned int) const;
     virtual void logFooter() const
                    {return;}
+    virtual void logBadRequest(const char *const) const;
+    virtual void logModuleError(const char *const, const char *const) const;
+    virtual void logDuplicateTest(const char *const, const char *const) const;
+    virtual void logEndOfReply() const;
 
   private:
     class ListNode
@@ -192,23 +846,214 @@ class TestSuite
 
     // ----------------------------------------------------------------------------------------
 
+    class CaseSet
+    {
+      public:
+                          CaseSet();
+                          ~CaseSet()
+                            {clear(); return;}
+
+        const bool        insert(const Test&, const char *const);
+        void              markReadsExtra(const Test&);
+        void              clear();
+
+      private:
+        class Entry
+        {
+          public:
+            const Test*       test;                      // the test it was applied to
+            unsigned long int hash;                      // hash of "test" and "text"
+            const char*       text;                      // the test case (or NULL if unused)
+        };
+
+        Entry*            _entries;                      // hash table of test cases seen
+        unsigned long int _capacity;                     // no. of entries in "_entries"
+        unsigned long int _numEntries;                   // no. of them in use
+        ListNode*         _extraReaders;                 // tests that read extra lines
+
+                          CaseSet(const CaseSet&);
+        CaseSet&          operator=(const CaseSet&);
+        const bool        readsExtra(const Test&) const;
+        void              grow();
+    };
+
+    // ----------------------------------------------------------------------------------------
+
+    class TagExpression
+    {
+      public:
+        enum Opcode                       // instructions for the tag expression's stack machine
+        {
+          pushTag,        // push whether the test has the tag in the instruction's mask
+          notOp,          // invert the top of the stack
+          andOp,          // replace the top two entries with their conjunction
+          orOp            // replace the top two entries with their disjunction
+        };
+
+                          TagExpression();
+                          ~TagExpression()
+                            {delete[] _program; return;}
+
+        void              append(const Opcode, const TagSet = 0UL);
+        const bool        fits() const
+                            {return (_maxDepth <= maxTags);}
+        const bool        matches(const TagSet) const;
+
+      private:
+        class Instruction
+        {
+          public:
+            Opcode opcode;
+            TagSet mask;
+        };
+
+        Instruction* _program;                 // the compiled expression in postfix order
+        unsigned int _length;                  // number of instructions in "_program"
+        unsigned int _capacity;                // number of instructions allocated
+        unsigned int _depth;                   // stack depth after the last instruction
+        unsigned int _maxDepth;                // deepest the stack gets during evaluation
+    };
+
+    // ----------------------------------------------------------------------------------------
+
+    class Module
+    {
+      public:
+                          Module(const char *const, void *const, Module *const = NULL);
+                          ~Module()
+                            {delete[] (char*)_path; return;}
+
+        const char *const path() const
+                            {return _path;}
+        void *const       handle() const
+                            {return _handle;}
+        Module *const     next() const
+                            {return _next;}
+        void              setNext(Module *const newNext)
+                            {_next = newNext; return;}
+
+      private:
+        const char *const _path;                         // the path the module was loaded from
+        void *const       _handle;                       // the module's handle from "dlopen()"
+        Module*           _next;                         // the next module in the list
+    };
+
+    // ----------------------------------------------------------------------------------------
+
+    class ScheduledSection
+    {
+      public:
+        const Section*    section;                       // a section to be performed
+        unsigned long int numFailures;                   // its recent no. of failed test cases
+        unsigned long int position;                      // its position in the index
+    };
+
+    // ----------------------------------------------------------------------------------------
+
+    class ListedTest
+    {
+      public:
+        const Test*       test;                          // a registered test object
+        unsigned long int numSections;                   // no. of sections for it
+        unsigned long int numCases;                      // no. of test cases in them
+    };
+
+    // ----------------------------------------------------------------------------------------
+
+    class CaseTally
+    {
+      public:
+        unsigned int      numCases;                      // no. of test cases applied
+        unsigned int      numFailedCases;                // no. of them that failed
+        unsigned int      numDuplicates;                 // no. of duplicates skipped
+        unsigned int      firstFailedCase;               // no. of the first to fail (or 0U)
+        unsigned long int firstFailedLine;               // where it is in the test data stream
+        bool              abortTest;                     // did a test case abort the test?
+        bool              abortAll;                      // did a test case abort all testing?
+        bool              readExtra;                     // did a test case read extra lines?
+        double            duration;                      // seconds spent applying them
+    };
+
+    // ----------------------------------------------------------------------------------------
+
+    class CaseNode
+    {
+      public:
+        TestCase* testCase;                              // a copy of a test case
+        CaseNode* next;                                  // the next one in the list
+    };
+
+    // ----------------------------------------------------------------------------------------
+
+    class Dispatcher;
+    friend class Dispatcher;
+
+    // ----------------------------------------------------------------------------------------
+
     static ListNode*   _tests;                  // list of tests
-    static bool        _atExitRegistered;       // has the atExit() method been registered yet?
+    static const char* _tagNames[maxTags];      // the tag table, indexed by bit number
+    static unsigned int _numTags;               // number of entries in use in "_tagNames"
+    static char*        _droppedTags;           // tag names that didn't fit in "_tagNames"
+    static volatile sig_atomic_t _cancelled;    // has "cancel()" been called?
 
     TestData           _testData;               // source stream of test data
-    ostream *const     _log;                    // where all test results are logged
-    unsigned int       _totalTestCases;         // total no. of test cases applied
-    unsigned int       _totalFailedTestCases;   // total no. of failed test cases
+    ostream*           _log;                    // where all test results are logged
+    const Section*     _sections;               // index of "_testData" (if it's been built)
+    bool               _indexed;                // has "_sections" been built yet?
+    unsigned int       _firstCase;              // no. of the first test case to apply
+    unsigned int       _lastCase;               // no. of the last test case to apply
+    unsigned int       _caseBase;               // no. of test cases before "_testData"'s first
+    Module*            _modules;                // modules loaded by "load()"
+    History*           _history;                // where test case results are recorded
+    unsigned int       _failureRuns;            // no. of runs to order sections by (or 0U)
+    bool               _failFast;               // should the first failure cancel testing?
+    bool               _skipDuplicates;         // should duplicate test cases be skipped?
+    CaseSet            _caseSet;                // the test cases applied in this run
+    LogArchive*        _logArchive;             // where "_log" is indexed (if anywhere)
+    Benchmark*         _benchmark;              // where test cases are timed (if anywhere)
+    unsigned int       _numWorkers;             // no. of worker processes to perform tests in
+    double             _chunkSeconds;           // how long each worker's share should take
+    #ifdef TESTSUITE_POSIX
+      Profiler*        _profiler;               // where test cases are noted for profiling
+    #endif
+    VirtualClock       _virtualClock;           // the clock that's reset for each test case
+    Tokenizer          _tokenizer;              // tokenizes each test case's text
+    RunResult          _result;                 // the results of the latest tests performed
+    double             _startTime;              // when the latest tests were started
 
     static const Test *const getTest(const char *const, const ListNode *const);
+    static char *const       newString(const char *const);
     static void              deleteList(const ListNode *const);
-    static void              atExit();
+    static void              deleteSections(const Section *const);
+    static const TagSet      internTags(const char *const);
+    static const int         findTag(const char *const, const size_t);
+    static void              dropTag(const char *const, const size_t);
+    static int               compareScheduled(const void*, const void*);
+    static int               compareListed(const void*, const void*);
+    static const unsigned long int findListed(const char *const, const ListedTest *const,
+                                  const unsigned long int);
 
     void                     prepareForTesting();
+    void                     finishTesting();
     const ListNode *const    getTests(const char *const, va_list&) const;
     const ListNode *const    getTests(const unsigned int, const char *const *const) const;
-    void                     runTests(const ListNode *const);
+    const ListNode *const    getTests(const TagExpression&) const;
+    const ListNode *const    getTests(const CoverageMap&) const;
+    const bool               compileTags(const char*&, TagExpression&) const;
+    const bool               compileTagTerm(const char*&, TagExpression&) const;
+    const bool               compileTagFactor(const char*&, TagExpression&) const;
+    const Section *const     sections();
+    void                     runTests(const ListNode *const, const unsigned int = 0U,
+                               const unsigned int = 1U);
     const bool               runTest(Test&);
+    void                     applyTestCases(Test&, CaseTally&);
+    void                     benchmarkCase(Test&, const TestCase&);
+    void                     addTally(const Test&, const CaseTally&);
+    #ifdef TESTSUITE_POSIX
+      void                   runInParallel(const ScheduledSection *const,
+                               const unsigned long int, const ListNode *const);
+    #endif
+    void                     cancelTesting();
 
     void                     assertInvariants() const;
 };
@@ -0,0 +1,177 @@
+// ============================================================================================
+//
+// SOURCE FILE:  testcov.cpp
+//
+// ============================================================================================
+
+// ============================================================================================
+// DESCRIPTION
+// ============================================================================================
+
+/*
+This program builds and queries a coverage map for "TestSuite::changed()" (see
+"coverage.cpp").  Usage:
+
+  testcov <map file> add <test name> <LCOV trace file>...
+  testcov <map file> affected [<changed file>...]
+
+"add" adds the source files that the trace files show as executed to the test's entry, creating
+the map file if it doesn't exist yet.  "affected" lists the tests in the map that execute any
+of the changed files, which are read from the standard input (one per line) if none are given.
+Tests that aren't in the map can't be listed, but "changed()" performs them too.  Changed files
+that match nothing in the map are listed on the standard error, since "changed()" performs
+every test when there are any.
+
+The exit status is 0 if the command succeeded (and, for "affected", found at least one test or
+an unmatched file), 1 if it failed or found nothing and 2 if the command line was wrong.
+*/
+
+// ============================================================================================
+// INCLUDE FILES
+// ============================================================================================
+
+#include <string.h>
+#include <fstream.h>
+
+#ifdef FAT_FILENAMES
+  #include "testsuit.h"
+#else
+  #include "testsuite.h"
+#endif
+
+// ============================================================================================
+// STATIC FUNCTION DECLARATIONS
+// ============================================================================================
+
+static const int addTraces(TestSuite::CoverageMap&, const char *const, const char *const,
+                   const int, const char *const *const);
+static const int listAffected(TestSuite::CoverageMap&, const int, const char *const *const);
+
+// ============================================================================================
+// MAIN FUNCTION
+// ============================================================================================
+
+/*********************************************************************************************/
+
+int main
+(
+  const int         argc,
+  const char *const argv[]
+)
+
+{
+  int                    status = 2;                        // the exit status
+  TestSuite::CoverageMap map;
+
+  if ((argc >= 5) && (strcmp(argv[2], "add") == 0))
+    status = addTraces(map, argv[1], argv[3], argc - 4, argv + 4);
+  else if ((argc >= 3) && (strcmp(argv[2], "affected") == 0))
+  {
+    ifstream mapFile(argv[1]);
+
+    if (!mapFile || !map.read(mapFile))
+    {
+      cerr << argv[0] << ":  \"" << argv[1] << "\" isn't a coverage map." << endl;
+      status = 1;
+    }
+    else
+      status = listAffected(map, argc - 3, argv + 3);
+  }
+
+  if (status == 2)
+  {
+    cerr << "Usage:  " << argv[0] << " <map file> add <test name> <LCOV trace file>..." << endl;
+    cerr << "        " << argv[0] << " <map file> affected [<changed file>...]" << endl;
+  }
+
+  return status;
+}
+
+// ============================================================================================
+// STATIC FUNCTION DEFINITIONS
+// ============================================================================================
+
+/*********************************************************************************************/
+
+static const int addTraces
+(
+  TestSuite::CoverageMap&  map,
+  const char *const        mapFileName,
+  const char *const        testName,
+  const int                numTraces,         // no. of entries in "traceFileNames"
+  const char *const *const traceFileNames
+)
+
+/*
+This function adds the trace files to "testName"'s entry in the map in "mapFileName" (which is
+created if it doesn't exist) and returns the exit status.
+*/
+
+{
+  int      status = 0;
+  ifstream oldMap(mapFileName);
+
+  if (oldMap && !map.read(oldMap))
+  {
+    cerr << "\"" << mapFileName << "\" isn't a coverage map." << endl;
+    status = 1;
+  }
+
+  oldMap.close();
+
+  for (int i = 0; (status == 0) && (i < numTraces); ++i)
+  {
+    ifstream trace(traceFileNames[i]);
+
+    if (!trace)
+    {
+      cerr << "Can't open \"" << traceFileNames[i] << "\"." << endl;
+      status = 1;
+    }
+    else
+      map.addTrace(testName, trace);
+  }
+
+  if (status == 0)
+  {
+    ofstream newMap(mapFileName);
+
+    map.write(newMap);
+    status = (newMap ? 0 : 1);
+  }
+
+  return status;
+}
+
+/*********************************************************************************************/
+
+static const int listAffected
+(
+  TestSuite::CoverageMap&  map,
+  const int                numChanged,        // no. of entries in "changedFiles" (or 0)
+  const char *const *const changedFiles
+)
+
+/*
+This function lists the tests in "map" that are affected by the changed files (from the
+standard input if "numChanged" is 0), and any changed files that aren't in "map", and returns
+the exit status.
+*/
+
+{
+  unsigned long int numAffected;               // no. of tests listed
+
+  if (numChanged == 0)
+    map.readChanged(cin);
+
+  for (int i = 0; i < numChanged; ++i)
+    map.addChanged(changedFiles[i]);
+
+  numAffected = map.listAffected(cout);
+
+  for (unsigned long int i = 0UL; i < map.numUnmatched(); ++i)
+    cerr << "\"" << map.unmatched(i) << "\" isn't in the map, so every test is affected." <<
+      endl;
+
+  return ((numAffected > 0UL) || (map.numUnmatched() > 0UL) ? 0 : 1);
+}
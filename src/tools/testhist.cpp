@@ -0,0 +1,112 @@
+// ============================================================================================
+//
+// SOURCE FILE:  testhist.cpp
+//
+// ============================================================================================
+
+// ============================================================================================
+// DESCRIPTION
+// ============================================================================================
+
+/*
+This program queries a results history that was recorded with "TestSuite::History" (see
+"history.cpp").  Usage:
+
+  testhist <history file> runs
+  testhist <history file> p<percentile> <test name> [<no. of runs>]
+  testhist <history file> newfailures <build id>
+
+"runs" lists every run, the most recent first.  "p<percentile>" (e.g. "p50" or "p90") prints
+the given percentile of the test's duration, in seconds, over the most recent runs in which it
+was performed (30 of them if not given).  "newfailures" lists the test cases that failed in the
+latest run but didn't fail in the latest run of the given build.
+
+The exit status is 0 if the query succeeded, 1 if nothing was found and 2 if the command line
+was wrong.
+*/
+
+// ============================================================================================
+// INCLUDE FILES
+// ============================================================================================
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#ifdef FAT_FILENAMES
+  #include "testsuit.h"
+#else
+  #include "testsuite.h"
+#endif
+
+// ============================================================================================
+// STATIC CONSTANTS
+// ============================================================================================
+
+static const unsigned int defaultNumRuns = 30U;  // no. of runs to look at for a percentile
+
+// ============================================================================================
+// MAIN FUNCTION
+// ============================================================================================
+
+/*********************************************************************************************/
+
+int main
+(
+  const int         argc,
+  const char *const argv[]
+)
+
+{
+  int status = 2;                                                   // the exit status
+
+  if ((argc == 3) && (strcmp(argv[2], "runs") == 0))
+  {
+    const TestSuite::History history(argv[1]);
+
+    status = (history.listRuns(cout) > 0UL ? 0 : 1);
+  }
+  else if ((argc == 4) && (strcmp(argv[2], "newfailures") == 0))
+  {
+    const TestSuite::History history(argv[1]);
+
+    status = (history.newFailures(argv[3], cout) > 0UL ? 0 : 1);
+  }
+  else if (((argc == 4) || (argc == 5)) && (argv[2][0] == 'p'))
+  {
+    const TestSuite::History history(argv[1]);
+    char*                    end      = NULL;         // where "strtod()" or "strtoul()" stopped
+    const double             percent  = strtod(argv[2] + 1, &end);
+    unsigned long int        numRuns  = (unsigned long int)defaultNumRuns;
+    bool                     valid    = (end != argv[2] + 1) && (*end == '\0') &&
+                                          (percent >= 0.0) && (percent <= 100.0);
+    double                   duration;
+
+    if (valid && (argc == 5))
+    {
+      numRuns = strtoul(argv[4], &end, 10);
+      valid   = (end != argv[4]) && (*end == '\0') && (numRuns > 0UL) && (numRuns <= UINT_MAX);
+    }
+
+    if (valid)
+    {
+      status = 1;
+
+      if (history.percentile(argv[3], (unsigned int)numRuns, percent, duration))
+      {
+        cout << duration << endl;
+        status = 0;
+      }
+    }
+  }
+
+  if (status == 2)
+  {
+    cerr << "Usage:  " << argv[0] << " <history file> runs" << endl;
+    cerr << "        " << argv[0] << " <history file> p<percentile> <test name> [<no. of runs>]"
+      << endl;
+    cerr << "        " << argv[0] << " <history file> newfailures <build id>" << endl;
+  }
+
+  return status;
+}
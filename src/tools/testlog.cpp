@@ -0,0 +1,98 @@
+// ============================================================================================
+//
+// SOURCE FILE:  testlog.cpp
+//
+// ============================================================================================
+
+// ============================================================================================
+// DESCRIPTION
+// ============================================================================================
+
+/*
+This program gets text out of a log archive written by "TestSuite::LogArchive" (see
+"logarchive.cpp").  Usage:
+
+  testlog <archive> tests
+  testlog <archive> all
+  testlog <archive> <test name> [<test case no.>]
+
+"tests" lists the tests in the archive's index.  "all" writes the whole log.  Otherwise, the
+text logged for the named test (or only for the given test case of it) is written.  Only the
+blocks that the text is in are decompressed, so this is quick however big the archive is.
+"all" also works on an archive that wasn't closed, but the others need its index.
+
+The exit status is 0 if the text was found and written, 1 if it wasn't and 2 if the command
+line was wrong.
+*/
+
+// ============================================================================================
+// INCLUDE FILES
+// ============================================================================================
+
+#include <string.h>
+#include <stdlib.h>
+
+#ifdef FAT_FILENAMES
+  #include "testsuit.h"
+#else
+  #include "testsuite.h"
+#endif
+
+// ============================================================================================
+// MAIN FUNCTION
+// ============================================================================================
+
+/*********************************************************************************************/
+
+int main
+(
+  const int         argc,
+  const char *const argv[]
+)
+
+{
+  int          status  = 2;                             // the exit status
+  unsigned int caseNum = 0U;                            // the test case to extract (or 0U)
+  char*        end     = NULL;                          // where "strtoul()" stopped
+
+  if (argc == 4)
+  {
+    caseNum = (unsigned int)strtoul(argv[3], &end, 10);
+    status  = ((*end == '\0') && (caseNum > 0U) ? 0 : 2);
+  }
+  else if (argc == 3)
+    status = 0;
+
+  if (status == 0)
+  {
+    TestSuite::LogReader reader(argv[1]);
+
+    if (!reader.good())
+    {
+      cerr << argv[0] << ":  \"" << argv[1] << "\" isn't a log archive." << endl;
+      status = 1;
+    }
+    else if ((argc == 3) && (strcmp(argv[2], "all") == 0))
+      status = (reader.extractAll(cout) ? 0 : 1);
+    else if (!reader.indexed())
+    {
+      cerr << argv[0] << ":  \"" << argv[1] << "\" has no index (it wasn't closed)." << endl;
+      status = 1;
+    }
+    else if ((argc == 3) && (strcmp(argv[2], "tests") == 0))
+      status = (reader.listTests(cout) > 0UL ? 0 : 1);
+    else if (argc == 3)
+      status = (reader.extractTest(cout, argv[2]) ? 0 : 1);
+    else
+      status = (reader.extractCase(cout, argv[2], caseNum) ? 0 : 1);
+  }
+
+  if (status == 2)
+  {
+    cerr << "Usage:  " << argv[0] << " <archive> tests" << endl;
+    cerr << "        " << argv[0] << " <archive> all" << endl;
+    cerr << "        " << argv[0] << " <archive> <test name> [<test case no.>]" << endl;
+  }
+
+  return status;
+}